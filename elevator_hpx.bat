@@ -2,6 +2,6 @@
 
 simu -melevator_hpx.ma -lelevator_hpx.log -w10-3 -t00:30:00:000
 
-"C:\Program Files\Tcl\bin\wish80.exe" pnmark.tcl elevator_hpx.ma elevator_hpx.log elevator_hpx.pn 
+pnmark elevator_hpx.ma elevator_hpx.log elevator_hpx.pn 
 
 pause
\ No newline at end of file
@@ -83,9 +83,8 @@ proc usage {prgName} {
 #   describes the number of tokens the arc takes from a place/
 #   deposits in a place when a transition fires.  Single and
 #   inhibitor arcs have a weight of 1.  Multiple arcs have a 
-#   weight > 1.  Note that because the Petri Net library used
-#   by the CD++ tool can't handle weight > 4, this procedure
-#   will throw an error if the .hpx contains such arcs.
+#   weight > 1.  Weights > 4 are declared to the transitions
+#   using the inweights and outweights parameters.
 #	
 # arcSrc(ID)
 #   Stores the source of the arc identified by ID.  The source
@@ -126,7 +125,7 @@ proc usage {prgName} {
 #
 proc objAttrListProcess { } {
     global objAttrList objType objName tokens arcType arcWeight \
-    	   arcSrc arcTgt arcIdList transIdList placeIdList
+    	   arcSrc arcTgt arcIdList transIdList placeIdList transDelay
 
     set ix [lsearch -exact $objAttrList RUNTIME_CLASS]
     incr ix
@@ -165,6 +164,28 @@ proc objAttrListProcess { } {
 	    # Store type of object in the objType array
 	    set objType($id) pnTrans	     
 
+	    # Get the firing delay of the transition.  HPSIM gives
+	    # it in milliseconds with a time mode: 0 immediate, 
+	    # 1 fixed delay, 2 exponential and 3 equal (uniform)
+	    # distribution over delay .. delay + range.  Immediate
+	    # transitions get "delay : immediate" whatever their
+	    # delay, unless the net has no timed transition (see
+	    # below).
+	    set ix [lsearch -exact $objAttrList TRANSITION_TIME_MODE]
+	    set mode [lindex $objAttrList [incr ix]]
+	    set ix [lsearch -exact $objAttrList FIRE_DELAY]
+	    set delay [expr [lindex $objAttrList [incr ix]] / 1000.0]
+	    set ix [lsearch -exact $objAttrList FIRE_DELAY_RANGE]
+	    set range [expr [lindex $objAttrList [incr ix]] / 1000.0]
+
+	    switch -exact -- $mode {
+		0 { set transDelay($id) "immediate" }
+		1 { set transDelay($id) "deterministic $delay" }
+		2 { set transDelay($id) "exponential $delay" }
+		3 { set transDelay($id) \
+			"uniform $delay [expr $delay + $range]" }
+	    }
+
 	    lappend transIdList $id
 
 	}
@@ -187,11 +208,6 @@ proc objAttrListProcess { } {
 	    set ix [lsearch -exact $objAttrList ARC_WEIGHT]
 	    set arcWeight($id) [lindex $objAttrList [incr ix]]
 
-	    if {$arcWeight($id) > 4} {
-	    	puts "\n$argv0: ERROR - Cannot translate arcs with a weight > 4"
-	    	return -code error INVALID_NET_DEFINITION 
-    	    }
-
 	    # Get the source ID and store it into the arcSrc array
 	    set ix [lsearch -exact $objAttrList SOURCE_ID]
 	    set arcSrc($id) [lindex $objAttrList [incr ix]]
@@ -501,37 +517,72 @@ foreach id $arcIdList {
     }
 }
 
-# Indicate places that have non zero initial tokens
+# Indicate places that have non zero initial tokens and the
+# thresholds of the arcs going from each place to transitions
+# (0 for an inhibitor arc) so the place only advertises its
+# contents when a transition may change state.
 # Should look like this:
 # ---
 # [P1]
 # tokens : 5
+# thresholds : 0 2
 # ---
 
+foreach id $arcIdList {
+
+    set srcId $arcSrc($id)
+
+    if {[string compare pnPlace $objType($srcId)] == 0} {
+
+	if {$arcType($id) == 1} {
+	    set weight 0
+	} else {
+	    set weight $arcWeight($id)
+	}
+
+	if {![info exists thresholds($srcId)] || \
+	    [lsearch -exact $thresholds($srcId) $weight] == -1} {
+	    lappend thresholds($srcId) $weight
+	}
+    }
+}
+
 foreach id $placeIdList {
     
-    if {$tokens($id) != 0} {
+    puts $maFileId "\n\[$objName($id)\]"
 
-    	puts $maFileId "\n\[$objName($id)\]"
+    if {$tokens($id) != 0} {
     	puts $maFileId "tokens : $tokens($id)"
     }
+
+    if {[info exists thresholds($id)]} {
+    	puts $maFileId "thresholds : [lsort -integer $thresholds($id)]"
+    } else {
+    	puts $maFileId "thresholds : none"
+    }
 }
 
 # Indicate the number of input places each transition has.
-# This info is required in the .ma only if a transition
-# has more than than 10 input places so the Petri Net
-# library used in the CD++ tool knows to allocate more
-# memory than the default value
+# This info lets the Petri Net library used in the CD++ tool
+# allocate exactly the memory each transition needs to keep
+# track of its input places.  Also indicate the weights > 4
+# of the arcs of the transition so it creates the ports
+# for them, and the distribution of its firing delays.
 #
 # Should look like this:
 # ---
 # [T2]
 # inputplaces : 11
+# inweights : 5
+# outweights : 6 10
+# delay : exponential 0.5
 # ---
 
-# First we calculate the number of input places
+# First we calculate the number of input places and
+# gather the weights
 foreach id $arcIdList {
     
+    set srcId $arcSrc($id)
     set tgtId $arcTgt($id)
 
     if {[string compare pnTrans $objType($tgtId)] == 0} {
@@ -542,18 +593,60 @@ foreach id $arcIdList {
 	} else {
 	    set inputPlaces($tgtId) 1	
 	}
+
+	if {$arcType($id) == 0 && $arcWeight($id) > 4 && \
+	    (![info exists inWeights($tgtId)] || \
+	     [lsearch -exact $inWeights($tgtId) $arcWeight($id)] == -1)} {
+	    lappend inWeights($tgtId) $arcWeight($id)
+	}
+    } elseif {$arcWeight($id) > 4 && \
+	      (![info exists outWeights($srcId)] || \
+	       [lsearch -exact $outWeights($srcId) $arcWeight($id)] == -1)} {
+	lappend outWeights($srcId) $arcWeight($id)
     }
 }
 
-# Store the info in the .ma
+# A net without any timed transition is an untimed HPSIM net.
+# Its transitions keep the default delay of the library: being
+# immediate they would fire forever in zero time.
+set timedNet 0
 foreach id $transIdList {
+    if {[info exists transDelay($id)] && $transDelay($id) != "immediate"} {
+	set timedNet 1
+    }
+}
 
-    if {[info exists inputPlaces($id)] &&
-        $inputPlaces($id) > 10} {
+if {!$timedNet} {
+    foreach id $transIdList {
+	if {[info exists transDelay($id)]} {
+	    unset transDelay($id)
+	}
+    }
+}
 
+# Store the info in the .ma
+foreach id $transIdList {
+
+    if {[info exists inputPlaces($id)] || [info exists outWeights($id)] || \
+	[info exists transDelay($id)]} {
     	puts $maFileId "\n\[$objName($id)\]"
+    }
+
+    if {[info exists inputPlaces($id)]} {
     	puts $maFileId "inputplaces : $inputPlaces($id)"
     }
+
+    if {[info exists inWeights($id)]} {
+    	puts $maFileId "inweights : $inWeights($id)"
+    }
+
+    if {[info exists outWeights($id)]} {
+    	puts $maFileId "outweights : $outWeights($id)"
+    }
+
+    if {[info exists transDelay($id)]} {
+    	puts $maFileId "delay : $transDelay($id)"
+    }
 }
 
 
@@ -0,0 +1,2 @@
+simu -mpipeline_net.ma -lpipeline_net.log -w10-3 -t02:00:00:000
+pause
\ No newline at end of file
@@ -0,0 +1,380 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Embedding API
+*
+*  This file implements the PnSimulation described in pnApi.h.  The
+*  declared arcs are kept as lists, as the loaders of pnNetDef.cpp
+*  collect them, and handed to pnNetBuild() when the net changed.
+*  The area under the tokens of a place is brought up to date when
+*  a firing touches the place, as pnrep does, so measuring a run
+*  costs one pass over the arcs of every firing.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnApi.h"	// class PnSimulation
+#include <stdio.h>	// sprintf()
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnSimulation constructor
+********************************************************************/
+PnSimulation::PnSimulation( PnEventListKind list )
+: engine( NULL )
+, listKind( list )
+, clock( 0 )
+{
+}
+
+/*******************************************************************
+* Function Name: PnSimulation destructor
+********************************************************************/
+PnSimulation::~PnSimulation()
+{
+	delete engine;
+}
+
+/*******************************************************************
+* Function Name: place
+* Description: A new place needs a new engine.
+********************************************************************/
+unsigned int PnSimulation::place( const string &name, PnTokens tokens )
+{
+	if( tokens < 0 )
+	    throw PnNetError( "Place " + name + " cannot hold a negative number of tokens" );
+
+	placeNames.push_back( name );
+	initTokens.push_back( tokens );
+
+	delete engine;
+	engine = NULL;
+
+	return placeNames.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: transition
+********************************************************************/
+unsigned int PnSimulation::transition( const string &name, const PnDelay &delay )
+{
+	transNames.push_back( name );
+	delays.push_back( delay );
+	priorities.push_back( 1 );
+	weights.push_back( 1 );
+
+	delete engine;
+	engine = NULL;
+
+	return transNames.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: transition
+* Description: Reads the delay as the "delay" parameter of PnTrans.
+********************************************************************/
+unsigned int PnSimulation::transition( const string &name, const string &delay )
+{
+	PnDelay dist;
+
+	if( !pnDelayParse( delay, dist ) )
+	    throw PnNetError( "Invalid delay " + delay + " for transition " + name );
+
+	return transition( name, dist );
+}
+
+/*******************************************************************
+* Function Name: input
+********************************************************************/
+void PnSimulation::input( unsigned int trans, unsigned int place, unsigned int weight )
+{
+	transCheck( trans );
+	placeCheck( place );
+
+	if( weight == 0 )
+	    throw PnNetError( "The input arc of transition " + transNames[trans] +
+			      " from place " + placeNames[place] + " has no weight" );
+
+	inTrans.push_back( trans );
+	inPlace.push_back( place );
+	inWeight.push_back( weight );
+
+	delete engine;
+	engine = NULL;
+}
+
+/*******************************************************************
+* Function Name: inhibitor
+* Description: An inhibitor arc is an input arc of weight 0, as in
+* the compiled net.
+********************************************************************/
+void PnSimulation::inhibitor( unsigned int trans, unsigned int place )
+{
+	transCheck( trans );
+	placeCheck( place );
+
+	inTrans.push_back( trans );
+	inPlace.push_back( place );
+	inWeight.push_back( 0 );
+
+	delete engine;
+	engine = NULL;
+}
+
+/*******************************************************************
+* Function Name: output
+********************************************************************/
+void PnSimulation::output( unsigned int trans, unsigned int place, unsigned int weight )
+{
+	transCheck( trans );
+	placeCheck( place );
+
+	if( weight == 0 )
+	    throw PnNetError( "The output arc of transition " + transNames[trans] +
+			      " to place " + placeNames[place] + " has no weight" );
+
+	outTrans.push_back( trans );
+	outPlace.push_back( place );
+	outWeight.push_back( weight );
+
+	delete engine;
+	engine = NULL;
+}
+
+/*******************************************************************
+* Function Name: tokensSet
+********************************************************************/
+void PnSimulation::tokensSet( unsigned int place, PnTokens tokens )
+{
+	placeCheck( place );
+
+	if( tokens < 0 )
+	    throw PnNetError( "Place " + placeNames[place] + " cannot hold a negative number of tokens" );
+
+	initTokens[place] = tokens;
+}
+
+/*******************************************************************
+* Function Name: delaySet
+********************************************************************/
+void PnSimulation::delaySet( unsigned int trans, const PnDelay &delay )
+{
+	transCheck( trans );
+	delays[trans] = delay;
+}
+
+/*******************************************************************
+* Function Name: prioritySet
+********************************************************************/
+void PnSimulation::prioritySet( unsigned int trans, int priority, double weight )
+{
+	transCheck( trans );
+
+	if( !( weight > 0 ) )
+	    throw PnNetError( "The weight of transition " + transNames[trans] + " must be positive" );
+
+	priorities[trans] = priority;
+	weights[trans] = weight;
+}
+
+/*******************************************************************
+* Function Name: reset
+* Description: Compiles the net if its arcs changed, gives it the
+* current initial tokens and delays and restarts the engine.  The
+* delays are read by the engine as it draws them, so they are only
+* changed here, between two runs.
+********************************************************************/
+void PnSimulation::reset( unsigned long long seed )
+{
+	unsigned int p;
+
+	if( engine == NULL )
+	    {
+	    def = PnNetDef();
+	    def.placeName = placeNames;
+	    def.transName = transNames;
+	    pnNetBuild( def, inTrans, inPlace, inWeight, outTrans, outPlace, outWeight );
+	    engine = new PnEngine( def, false, listKind );
+	    }
+
+	def.initMarking = initTokens;
+	def.transDelay = delays;
+	def.transPriority = priorities;
+	def.transWeight = weights;
+
+	clock = 0;
+	fired.assign( def.transitions(), 0 );
+	area.assign( def.places(), 0 );
+	since.assign( def.places(), 0 );
+	level.resize( def.places() );
+	for( p = 0; p < def.places(); p++ )
+	    level[p] = def.initMarking[p];
+
+	engine->reset( 0, seed );
+	firingsCount();
+}
+
+/*******************************************************************
+* Function Name: run
+********************************************************************/
+bool PnSimulation::run( double time, unsigned long budget )
+{
+	unsigned long start;
+
+	engineCheck();
+
+	start = engine->firings();
+
+	while( engine->pending() && engine->nextTime() <= time )
+	    {
+	    if( budget != 0 && engine->firings() - start >= budget )
+		{
+		clock = engine->now();
+		return false;
+		}
+
+	    engine->fire();
+	    firingsCount();
+	    }
+
+	if( time > clock )
+	    clock = time;
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: tokens
+********************************************************************/
+PnTokens PnSimulation::tokens( unsigned int place ) const
+{
+	engineCheck();
+	placeCheck( place );
+
+	return engine->tokens( place );
+}
+
+/*******************************************************************
+* Function Name: firings
+********************************************************************/
+unsigned long PnSimulation::firings( unsigned int trans ) const
+{
+	engineCheck();
+	transCheck( trans );
+
+	return fired[trans];
+}
+
+/*******************************************************************
+* Function Name: firings
+********************************************************************/
+unsigned long PnSimulation::firings() const
+{
+	engineCheck();
+
+	return engine->firings();
+}
+
+/*******************************************************************
+* Function Name: mean
+* Description: A run which did not leave time 0 reports the current
+* tokens.
+********************************************************************/
+double PnSimulation::mean( unsigned int place ) const
+{
+	engineCheck();
+	placeCheck( place );
+
+	if( clock <= 0 )
+	    return (double) level[place];
+
+	return ( area[place] + level[place] * ( clock - since[place] ) ) / clock;
+}
+
+/*******************************************************************
+* Function Name: dead
+********************************************************************/
+bool PnSimulation::dead() const
+{
+	engineCheck();
+
+	return !engine->pending();
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: placeCheck
+********************************************************************/
+void PnSimulation::placeCheck( unsigned int place ) const
+{
+	char number[16];
+
+	if( place >= placeNames.size() )
+	    {
+	    sprintf( number, "%u", place );
+	    throw PnNetError( string( "There is no place " ) + number );
+	    }
+}
+
+/*******************************************************************
+* Function Name: transCheck
+********************************************************************/
+void PnSimulation::transCheck( unsigned int trans ) const
+{
+	char number[16];
+
+	if( trans >= transNames.size() )
+	    {
+	    sprintf( number, "%u", trans );
+	    throw PnNetError( string( "There is no transition " ) + number );
+	    }
+}
+
+/*******************************************************************
+* Function Name: engineCheck
+* Description: The net must have been compiled by reset() since it
+* last changed.
+********************************************************************/
+void PnSimulation::engineCheck() const
+{
+	if( engine == NULL )
+	    throw PnNetError( "The net changed since the last reset()" );
+}
+
+/*******************************************************************
+* Function Name: firingsCount
+* Description: Counts the firings of the last step of the engine
+* and brings the areas of the places they touched up to date.
+********************************************************************/
+void PnSimulation::firingsCount()
+{
+	const vector<unsigned int> &list = engine->lastFired();
+	double time = engine->now();
+	unsigned int i, a, p;
+
+	for( i = 0; i < list.size(); i++ )
+	    {
+	    unsigned int t = list[i];
+
+	    for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		{
+		p = def.prePlace[a];
+		area[p] += level[p] * ( time - since[p] );
+		since[p] = time;
+		level[p] = engine->tokens( p );
+		}
+
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		{
+		p = def.postPlace[a];
+		area[p] += level[p] * ( time - since[p] );
+		since[p] = time;
+		level[p] = engine->tokens( p );
+		}
+
+	    fired[t]++;
+	    }
+
+	clock = time;
+}
@@ -0,0 +1,149 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Embedding API Header File
+*
+*  A PnSimulation builds a net in memory and fires it inside the
+*  calling program, with no .ma file, no simulator and no log.
+*  Places, transitions and arcs are declared by calls; the net is
+*  compiled into a PnNetDef (see pnNetDef.h) and fired by a
+*  PnEngine (see pnEngine.h).
+*  The marking, the firings of every transition and the time
+*  averaged tokens of every place are read from memory.
+*
+*  A program evaluating many variants of a net declares it once,
+*  then changes the initial tokens or the delays and calls reset()
+*  and run() again.  The net is only compiled again when places,
+*  transitions or arcs are added.
+*
+*  For example, three machines going from idle to busy:
+*
+*  PnSimulation sim;
+*  unsigned int idle = sim.place( "Idle", 3 );
+*  unsigned int busy = sim.place( "Busy" );
+*  unsigned int start = sim.transition( "Start", "exponential 2" );
+*  unsigned int end = sim.transition( "End", "uniform 1 5" );
+*
+*  sim.input( start, idle );
+*  sim.output( start, busy );
+*  sim.input( end, busy );
+*  sim.output( end, idle );
+*
+*  sim.reset( 1 );
+*  sim.run( 3600 );
+*  printf( "%g busy, %lu jobs\n", sim.mean( busy ), sim.firings( end ) );
+*
+*  Every error, such as an arc to a place which does not exist or
+*  immediate transitions firing forever, throws a PnNetError.
+*
+*******************************************************************/
+
+#ifndef __PNAPI_H
+#define __PNAPI_H
+
+#include <string>
+#include <vector>
+#include "pnNetDef.h"	// class PnNetDef, class PnNetError
+#include "pnEngine.h"	// class PnEngine
+#include "pnEvents.h"	// PnEventListKind
+#include "pnRandom.h"	// PnDelay
+
+// PnSimulation class
+
+class PnSimulation
+{
+public:
+	// Constructor.  The kind of event list does not change the
+	// results (see pnEvents.h).
+	PnSimulation( PnEventListKind list = PN_LIST_HEAP );
+
+	~PnSimulation();
+
+	// Declare a place holding <tokens> at the start, or a
+	// transition with a delay distribution given as such or in
+	// the form of the "delay" parameter, e.g. "exponential 5".
+	// Return the number of the place or transition, counted
+	// from 0 in the order of declaration.
+	unsigned int place( const string &name, PnTokens tokens = 0 );
+	unsigned int transition( const string &name, const PnDelay &delay = pnDelayDefault() );
+	unsigned int transition( const string &name, const string &delay );
+
+	// Declare an arc taking <weight> tokens from a place, an
+	// inhibitor arc, or an arc depositing <weight> tokens
+	void input( unsigned int trans, unsigned int place, unsigned int weight = 1 );
+	void inhibitor( unsigned int trans, unsigned int place );
+	void output( unsigned int trans, unsigned int place, unsigned int weight = 1 );
+
+	// Change the initial tokens of a place, the delays of a
+	// transition or the priority and weight of an immediate
+	// transition.  They take effect at the next reset().
+	void tokensSet( unsigned int place, PnTokens tokens );
+	void delaySet( unsigned int trans, const PnDelay &delay );
+	void prioritySet( unsigned int trans, int priority, double weight = 1 );
+
+	// Starts a run at time 0 from the initial marking.  The seed
+	// selects the delays of the run.
+	void reset( unsigned long long seed );
+
+	// Fires the transitions due until <time>, or until at least
+	// <budget> more transitions fired if it is not 0.  Returns
+	// true if the time was reached, false if the budget ran out
+	// first.  Runs can be chained with increasing times.
+	bool run( double time, unsigned long budget = 0 );
+
+	// Time reached by the run
+	double now() const
+		{return clock;}
+
+	PnTokens tokens( unsigned int place ) const;
+
+	// Firings of a transition, and of all of them, since reset()
+	unsigned long firings( unsigned int trans ) const;
+	unsigned long firings() const;
+
+	// Time averaged tokens of a place from time 0 to now()
+	double mean( unsigned int place ) const;
+
+	// Returns true if no transition can fire anymore
+	bool dead() const;
+
+	// The compiled net, up to date after reset()
+	const PnNetDef &net() const
+		{return def;}
+
+private:
+	// Not copyable: the engine is owned and refers to the net
+	// of its simulation
+	PnSimulation( const PnSimulation & );
+	PnSimulation &operator=( const PnSimulation & );
+
+	void placeCheck( unsigned int place ) const;
+	void transCheck( unsigned int trans ) const;
+	void engineCheck() const;
+	void firingsCount();
+
+	// Declared net
+	vector<string> placeNames;
+	vector<PnTokens> initTokens;
+	vector<string> transNames;
+	vector<PnDelay> delays;
+	vector<int> priorities;
+	vector<double> weights;
+	vector<unsigned int> inTrans, inPlace, inWeight;
+	vector<unsigned int> outTrans, outPlace, outWeight;
+
+	// Compiled net and the engine firing it, NULL until the first
+	// reset() and after a change of the arcs
+	PnNetDef def;
+	PnEngine *engine;
+	PnEventListKind listKind;
+
+	// Measures of the run
+	double clock;
+	vector<unsigned long> fired;
+	vector<double> area;
+	vector<double> since;
+	vector<PnTokens> level;
+
+};	// class PnSimulation
+
+#endif   //__PNAPI_H
@@ -0,0 +1,515 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Checkpoint
+*
+*  This file implements the checkpoints described in
+*  pnCheckpoint.h.  A checkpoint is built in memory and written with
+*  a single write; it is read back with a single read and decoded
+*  from the buffer, every record being checked against the end of
+*  the file so a truncated checkpoint is an error, not a crash.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnCheckpoint.h"	// class PnCheckpoint
+#include <stdio.h>	// fopen()
+#include <stdlib.h>	// atexit()
+#include <string.h>	// memcpy()
+
+/** private data **/
+
+// The checkpoints returned by pnCheckpointSave() and
+// pnCheckpointLoad()
+static map<string, PnCheckpoint *> savedCheckpoints;
+static map<string, PnCheckpoint *> loadedCheckpoints;
+
+// Buffer being decoded: the reads past its end fail
+class PnCheckpointBuffer
+{
+public:
+	PnCheckpointBuffer( const string &fileName );
+
+	// Copies <size> bytes.  Throws a PnNetError past the end.
+	void read( void *to, size_t size );
+
+	string read( size_t size );
+
+	bool atEnd() const
+		{return pos == data.size();}
+
+private:
+	string name;
+	string data;
+	size_t pos;
+
+};	// class PnCheckpointBuffer
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: PnCheckpointBuffer constructor
+* Description: Reads the whole file.
+********************************************************************/
+PnCheckpointBuffer::PnCheckpointBuffer( const string &fileName )
+: name( fileName )
+, pos( 0 )
+{
+	FILE *file = fopen( fileName.c_str(), "rb" );
+	long size;
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot open the checkpoint file " + fileName );
+
+	if( fseek( file, 0, SEEK_END ) != 0 || ( size = ftell( file ) ) < 0 ||
+	    fseek( file, 0, SEEK_SET ) != 0 )
+	    {
+	    fclose( file );
+	    throw PnNetError( "Cannot read the checkpoint file " + fileName );
+	    }
+
+	data.resize( size );
+
+	if( size != 0 && fread( &data[0], size, 1, file ) != 1 )
+	    {
+	    fclose( file );
+	    throw PnNetError( "Cannot read the checkpoint file " + fileName );
+	    }
+
+	fclose( file );
+}
+
+/*******************************************************************
+* Function Name: read
+********************************************************************/
+void PnCheckpointBuffer::read( void *to, size_t size )
+{
+	if( data.size() - pos < size )
+	    throw PnNetError( "The checkpoint file " + name + " is truncated" );
+
+	memcpy( to, data.data() + pos, size );
+	pos += size;
+}
+
+/*******************************************************************
+* Function Name: read
+* Description: Returns the next <size> bytes as a string.
+********************************************************************/
+string PnCheckpointBuffer::read( size_t size )
+{
+	if( data.size() - pos < size )
+	    throw PnNetError( "The checkpoint file " + name + " is truncated" );
+
+	pos += size;
+
+	return data.substr( pos - size, size );
+}
+
+/*******************************************************************
+* Function Name: append
+* Description: Appends the bytes of a record to a buffer.
+********************************************************************/
+static void append( string &buffer, const void *from, size_t size )
+{
+	buffer.append( (const char *) from, size );
+}
+
+/*******************************************************************
+* Function Name: fileWrite
+********************************************************************/
+static void fileWrite( const string &fileName, const string &buffer )
+{
+	FILE *file = fopen( fileName.c_str(), "wb" );
+	bool done;
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot create the checkpoint file " + fileName );
+
+	done = fwrite( buffer.data(), buffer.size(), 1, file ) == 1;
+
+	if( fclose( file ) != 0 || !done )
+	    throw PnNetError( "Cannot write the checkpoint file " + fileName );
+}
+
+/*******************************************************************
+* Function Name: headerMake
+********************************************************************/
+static PnCheckpointHeader headerMake( uint32_t kind, double time )
+{
+	PnCheckpointHeader header;
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PN_CHECKPOINT_MAGIC, sizeof( PN_CHECKPOINT_MAGIC ) );
+	header.version = PN_CHECKPOINT_VERSION;
+	header.kind = kind;
+	header.time = time;
+
+	return header;
+}
+
+/*******************************************************************
+* Function Name: headerRead
+* Description: Reads the header and checks it is the one of a
+* checkpoint of the kind expected.
+********************************************************************/
+static PnCheckpointHeader headerRead( PnCheckpointBuffer &buffer,
+				      const string &fileName, uint32_t kind )
+{
+	PnCheckpointHeader header;
+
+	buffer.read( &header, sizeof( header ) );
+
+	if( memcmp( header.magic, PN_CHECKPOINT_MAGIC, sizeof( PN_CHECKPOINT_MAGIC ) ) != 0 ||
+	    header.version != PN_CHECKPOINT_VERSION )
+	    throw PnNetError( fileName + " is not a checkpoint file" );
+
+	if( header.kind != kind )
+	    throw PnNetError( fileName + ( kind == PN_CHECKPOINT_ENGINE ?
+			      " holds the state of PnPlace and PnTrans models, not of a net" :
+			      " holds the state of a net, not of PnPlace and PnTrans models" ) );
+
+	return header;
+}
+
+/*******************************************************************
+* Function Name: netFingerprint
+* Description: Hashes the places, transitions and arcs of a net.
+********************************************************************/
+static uint64_t netFingerprint( const PnNetDef &net )
+{
+	unsigned long long hash = pnRandMix( net.places() );
+	unsigned int i;
+
+	hash = pnRandMix( hash ^ net.transitions() );
+
+	for( i = 0; i < net.prePlace.size(); i++ )
+	    hash = pnRandMix( hash ^ ( net.prePlace[i] + ( (unsigned long long) net.preWeight[i] << 32 ) ) );
+
+	for( i = 0; i <= net.transitions(); i++ )
+	    hash = pnRandMix( hash ^ ( net.preStart[i] + ( (unsigned long long) net.postStart[i] << 32 ) ) );
+
+	for( i = 0; i < net.postPlace.size(); i++ )
+	    hash = pnRandMix( hash ^ ( net.postPlace[i] + ( (unsigned long long) net.postWeight[i] << 32 ) ) );
+
+	return hash;
+}
+
+/*******************************************************************
+* Function Name: checkpointsWrite
+* Description: Writes the checkpoints of pnCheckpointSave() when
+* the program exits.  The program is ending, so an error can only
+* be reported.
+********************************************************************/
+static void checkpointsWrite()
+{
+	for( map<string, PnCheckpoint *>::iterator i = savedCheckpoints.begin();
+	     i != savedCheckpoints.end(); i++ )
+	    {
+	    try
+	       {
+	       i->second->write( i->first );
+	       }
+	    catch( PnNetError &err )
+	       {
+	       fprintf( stderr, "%s\n", err.message().c_str() );
+	       }
+
+	    delete i->second;
+	    }
+
+	savedCheckpoints.clear();
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnCheckpointWrite
+********************************************************************/
+void pnCheckpointWrite( const string &fileName, const PnEngine &engine, double time )
+{
+	PnEngineState state;
+	PnCheckpointHeader header = headerMake( PN_CHECKPOINT_ENGINE, time );
+	string buffer;
+	unsigned int i;
+
+	engine.stateGet( state );
+
+	header.net = netFingerprint( engine.net() );
+	header.firings = state.firings;
+	header.choices = state.choices;
+	header.places = state.marking.size();
+	header.transitions = state.draws.size();
+
+	buffer.reserve( sizeof( header ) + state.marking.size() * sizeof( int64_t ) +
+			state.draws.size() * sizeof( PnCheckpointTrans ) );
+	append( buffer, &header, sizeof( header ) );
+
+	for( i = 0; i < state.marking.size(); i++ )
+	    {
+	    int64_t tokens = state.marking[i];
+
+	    append( buffer, &tokens, sizeof( tokens ) );
+	    }
+
+	for( i = 0; i < state.draws.size(); i++ )
+	    {
+	    PnCheckpointTrans trans;
+
+	    trans.draws = state.draws[i];
+	    trans.due = state.due[i];
+	    append( buffer, &trans, sizeof( trans ) );
+	    }
+
+	fileWrite( fileName, buffer );
+}
+
+/*******************************************************************
+* Function Name: pnCheckpointRead
+********************************************************************/
+void pnCheckpointRead( const string &fileName, const PnNetDef &net,
+		       PnEngineState &state )
+{
+	PnCheckpointBuffer buffer( fileName );
+	PnCheckpointHeader header = headerRead( buffer, fileName, PN_CHECKPOINT_ENGINE );
+	unsigned int i;
+
+	if( header.places != net.places() || header.transitions != net.transitions() ||
+	    header.net != netFingerprint( net ) )
+	    throw PnNetError( fileName + " holds the state of another net" );
+
+	state.time = header.time;
+	state.firings = header.firings;
+	state.choices = header.choices;
+	state.marking.resize( header.places );
+	state.draws.resize( header.transitions );
+	state.due.resize( header.transitions );
+
+	for( i = 0; i < header.places; i++ )
+	    {
+	    int64_t tokens;
+
+	    buffer.read( &tokens, sizeof( tokens ) );
+	    state.marking[i] = tokens;
+	    }
+
+	for( i = 0; i < header.transitions; i++ )
+	    {
+	    PnCheckpointTrans trans;
+
+	    buffer.read( &trans, sizeof( trans ) );
+	    state.draws[i] = trans.draws;
+	    state.due[i] = trans.due;
+	    }
+}
+
+/*******************************************************************
+* Function Name: PnCheckpoint constructor
+********************************************************************/
+PnCheckpoint::PnCheckpoint( double time )
+: at( time )
+{
+}
+
+/*******************************************************************
+* Function Name: PnCheckpoint constructor
+* Description: Reads the places, then the transitions.
+********************************************************************/
+PnCheckpoint::PnCheckpoint( const string &fileName )
+{
+	PnCheckpointBuffer buffer( fileName );
+	PnCheckpointHeader header = headerRead( buffer, fileName, PN_CHECKPOINT_MODELS );
+	unsigned int i;
+
+	at = header.time;
+
+	places.resize( header.places );
+	for( i = 0; i < header.places; i++ )
+	    {
+	    PnCheckpointPlace place;
+
+	    buffer.read( &place, sizeof( place ) );
+	    places[i].name = buffer.read( place.length );
+	    places[i].tokens = place.tokens;
+	    places[i].level = place.level;
+	    placeIndex[places[i].name] = i;
+	    }
+
+	transitions.resize( header.transitions );
+	for( i = 0; i < header.transitions; i++ )
+	    {
+	    PnCheckpointModel model;
+	    Trans &trans = transitions[i];
+
+	    buffer.read( &model, sizeof( model ) );
+	    trans.name = buffer.read( model.length );
+	    trans.draws = model.draws;
+	    trans.due = model.due;
+	    trans.unsatisfied = model.unsatisfied;
+	    trans.arcs.resize( model.inputs );
+	    if( model.inputs != 0 )
+		buffer.read( &trans.arcs[0], model.inputs * sizeof( PnCheckpointArc ) );
+	    transIndex[trans.name] = i;
+	    }
+
+	if( !buffer.atEnd() )
+	    throw PnNetError( fileName + " is not a checkpoint file" );
+}
+
+/*******************************************************************
+* Function Name: placeAdd
+* Description: A place starts empty with nothing advertised, as
+* PnPlace does.
+********************************************************************/
+unsigned int PnCheckpoint::placeAdd( const string &name )
+{
+	Place place;
+
+	place.name = name;
+	place.tokens = 0;
+	place.level = -1;
+	places.push_back( place );
+	placeIndex[name] = places.size() - 1;
+
+	return places.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: transAdd
+********************************************************************/
+unsigned int PnCheckpoint::transAdd( const string &name )
+{
+	Trans trans;
+
+	trans.name = name;
+	trans.draws = 0;
+	trans.due = -1;
+	trans.unsatisfied = 0;
+	transitions.push_back( trans );
+	transIndex[name] = transitions.size() - 1;
+
+	return transitions.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: transArc
+* Description: The slots of a transition are filled in order, so a
+* new slot is always the next one.
+********************************************************************/
+void PnCheckpoint::transArc( unsigned int id, double now, unsigned int slot,
+			     int placeId, unsigned int arcWidth, bool enabled )
+{
+	if( now > at )
+	    return;
+
+	vector<PnCheckpointArc> &arcs = transitions[id].arcs;
+
+	if( slot == arcs.size() )
+	    arcs.push_back( PnCheckpointArc() );
+
+	arcs[slot].placeId = placeId;
+	arcs[slot].arcWidth = arcWidth;
+	arcs[slot].enabled = enabled;
+}
+
+/*******************************************************************
+* Function Name: placeFind
+********************************************************************/
+const PnCheckpoint::Place *PnCheckpoint::placeFind( const string &name ) const
+{
+	map<string, unsigned int>::const_iterator i = placeIndex.find( name );
+
+	return i == placeIndex.end() ? NULL : &places[i->second];
+}
+
+/*******************************************************************
+* Function Name: transFind
+********************************************************************/
+const PnCheckpoint::Trans *PnCheckpoint::transFind( const string &name ) const
+{
+	map<string, unsigned int>::const_iterator i = transIndex.find( name );
+
+	return i == transIndex.end() ? NULL : &transitions[i->second];
+}
+
+/*******************************************************************
+* Function Name: write
+********************************************************************/
+void PnCheckpoint::write( const string &fileName ) const
+{
+	PnCheckpointHeader header = headerMake( PN_CHECKPOINT_MODELS, at );
+	string buffer;
+	unsigned int i;
+
+	header.places = places.size();
+	header.transitions = transitions.size();
+	append( buffer, &header, sizeof( header ) );
+
+	for( i = 0; i < places.size(); i++ )
+	    {
+	    PnCheckpointPlace place;
+
+	    place.tokens = places[i].tokens;
+	    place.level = places[i].level;
+	    place.length = places[i].name.size();
+	    append( buffer, &place, sizeof( place ) );
+	    buffer += places[i].name;
+	    }
+
+	for( i = 0; i < transitions.size(); i++ )
+	    {
+	    const Trans &trans = transitions[i];
+	    PnCheckpointModel model;
+
+	    memset( &model, 0, sizeof( model ) );
+	    model.draws = trans.draws;
+	    model.due = trans.due;
+	    model.unsatisfied = trans.unsatisfied;
+	    model.inputs = trans.arcs.size();
+	    model.length = trans.name.size();
+	    append( buffer, &model, sizeof( model ) );
+	    buffer += trans.name;
+	    if( !trans.arcs.empty() )
+		append( buffer, &trans.arcs[0], trans.arcs.size() * sizeof( PnCheckpointArc ) );
+	    }
+
+	fileWrite( fileName, buffer );
+}
+
+/*******************************************************************
+* Function Name: pnCheckpointSave
+* Description: The time given the first time is kept.
+********************************************************************/
+PnCheckpoint *pnCheckpointSave( const string &fileName, double time )
+{
+	map<string, PnCheckpoint *>::iterator i = savedCheckpoints.find( fileName );
+
+	if( i != savedCheckpoints.end() )
+	    return i->second;
+
+	if( savedCheckpoints.empty() )
+	    atexit( checkpointsWrite );
+
+	PnCheckpoint *checkpoint = new PnCheckpoint( time );
+
+	savedCheckpoints[fileName] = checkpoint;
+
+	return checkpoint;
+}
+
+/*******************************************************************
+* Function Name: pnCheckpointLoad
+* Description: The checkpoints read are kept until the program
+* exits.
+********************************************************************/
+const PnCheckpoint *pnCheckpointLoad( const string &fileName )
+{
+	map<string, PnCheckpoint *>::iterator i = loadedCheckpoints.find( fileName );
+
+	if( i != loadedCheckpoints.end() )
+	    return i->second;
+
+	PnCheckpoint *checkpoint = new PnCheckpoint( fileName );
+
+	loadedCheckpoints[fileName] = checkpoint;
+
+	return checkpoint;
+}
@@ -0,0 +1,213 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Checkpoint Header File
+*
+*  A checkpoint holds the whole state of a simulation at some time,
+*  so a long run can be resumed after a crash or a time out, and
+*  many replications can start from the same warmed up state
+*  without firing the warm up again.  The file is made of:
+*
+*  - a header (PnCheckpointHeader, 56 bytes);
+*  - for the state of an engine, written by PnNet and pnrep: the
+*    tokens of every place (int64_t each), then the delays drawn by
+*    every transition and the time it is due to fire
+*    (PnCheckpointTrans each);
+*  - for the state of PnPlace and PnTrans models: a
+*    PnCheckpointPlace per place followed by its name, then a
+*    PnCheckpointModel per transition followed by its name and its
+*    input places (PnCheckpointArc each).
+*
+*  The file is read into memory at once and decoded in one pass.
+*  Numbers are written in the byte order of the machine.
+*
+*  The delays are drawn by a counter-based generator (see
+*  pnRandom.h), so the state of the generator is the number of
+*  delays each transition drew.  The firings already scheduled keep
+*  their times: resuming with the same seed goes on with the run
+*  the checkpoint was taken from, another seed starts a new
+*  replication from the same state.  The times of the resumed run
+*  count from the time of the checkpoint.
+*
+*  The state of an engine is only loaded for a net with the same
+*  places, transitions and arcs; the delays may differ.  The state
+*  of the models is found by their names and the input places of a
+*  transition are model IDs, so the .ma file must be the same.
+*
+*  The models are given the checkpoint by the [pncheckpoint]
+*  section of the .ma file: "save" and "at" write the state reached
+*  at time "at" when the simulator exits, which must run past that
+*  time; "load" starts the simulation from a saved state.
+*
+*  [pncheckpoint]
+*  save : warm.pnc
+*  at : 36000
+*
+*  [pncheckpoint]
+*  load : warm.pnc
+*
+*******************************************************************/
+
+#ifndef __PNCHECKPOINT_H
+#define __PNCHECKPOINT_H
+
+#include <stdint.h>	// int32_t, ...
+#include <string>
+#include <vector>
+#include <map>
+#include "pnNetDef.h"	// class PnNetDef, class PnNetError
+#include "pnEngine.h"	// struct PnEngineState
+
+#define PN_CHECKPOINT_MAGIC	"PNCHECK"
+#define PN_CHECKPOINT_VERSION	1
+
+// Kinds of checkpoints
+#define PN_CHECKPOINT_ENGINE	0
+#define PN_CHECKPOINT_MODELS	1
+
+struct PnCheckpointHeader
+    {
+    char magic[8];		// PN_CHECKPOINT_MAGIC
+    uint32_t version;		// PN_CHECKPOINT_VERSION
+    uint32_t kind;		// PN_CHECKPOINT_ENGINE or _MODELS
+    double time;		// time of the state, in seconds
+    uint64_t net;		// fingerprint of the net, 0 for models
+    uint64_t firings;		// firings of the engine so far
+    uint64_t choices;		// draws among immediate transitions
+    uint32_t places;
+    uint32_t transitions;
+    };
+
+// Transition of an engine
+struct PnCheckpointTrans
+    {
+    uint64_t draws;		// delays drawn
+    double due;			// firing time, negative if none
+    };
+
+// PnPlace model.  The name follows, length bytes long.
+struct PnCheckpointPlace
+    {
+    int64_t tokens;
+    int32_t level;		// level last advertised
+    uint32_t length;
+    };
+
+// PnTrans model.  The name follows, length bytes long, then the
+// input places.
+struct PnCheckpointModel
+    {
+    uint64_t draws;		// delays drawn
+    double due;			// firing time, negative if none
+    uint32_t unsatisfied;	// input arcs not satisfied
+    uint32_t inputs;		// number of input places
+    uint32_t length;
+    uint32_t unused;
+    };
+
+// Input place of a PnTrans model
+struct PnCheckpointArc
+    {
+    int32_t placeId;
+    uint32_t arcWidth;
+    uint32_t enabled;
+    };
+
+// Writes the state of an engine at <time>, which lies between its
+// last firing and the next one.  Throws a PnNetError if the file
+// cannot be written.
+void pnCheckpointWrite( const string &fileName, const PnEngine &engine, double time );
+
+// Reads the state of an engine firing <net>.  Throws a PnNetError
+// if the file cannot be read or is not the state of an engine of
+// that net.
+void pnCheckpointRead( const string &fileName, const PnNetDef &net,
+		       PnEngineState &state );
+
+// PnCheckpoint class: the state of PnPlace and PnTrans models
+
+class PnCheckpoint
+{
+public:
+	// Saved state of a place and a transition
+	struct Place
+	    {
+	    string name;
+	    PnTokens tokens;
+	    int level;
+	    };
+
+	struct Trans
+	    {
+	    string name;
+	    unsigned long long draws;
+	    double due;
+	    unsigned int unsatisfied;
+	    vector<PnCheckpointArc> arcs;	// by slot
+	    };
+
+	// Checkpoint of the state at <time>, to be written
+	PnCheckpoint( double time );
+
+	// Reads a checkpoint.  Throws a PnNetError if the file cannot
+	// be read or is not the state of models.
+	PnCheckpoint( const string &fileName );
+
+	double time() const
+		{return at;}
+
+	// Adds a place or transition and returns its number
+	unsigned int placeAdd( const string &name );
+	unsigned int transAdd( const string &name );
+
+	// Record the state of a model after a change at <now>.  The
+	// changes after the time of the checkpoint are left out.
+	void place( unsigned int id, double now, PnTokens tokens, int level )
+		{
+		if( now <= at )
+		    {
+		    places[id].tokens = tokens;
+		    places[id].level = level;
+		    }
+		}
+
+	void trans( unsigned int id, double now, unsigned long long draws,
+		    double due, unsigned int unsatisfied )
+		{
+		if( now <= at )
+		    {
+		    transitions[id].draws = draws;
+		    transitions[id].due = due;
+		    transitions[id].unsatisfied = unsatisfied;
+		    }
+		}
+
+	// Records the input place in slot <slot> of a transition
+	void transArc( unsigned int id, double now, unsigned int slot, int placeId,
+		       unsigned int arcWidth, bool enabled );
+
+	// Returns the saved state of a model, NULL if there is none
+	const Place *placeFind( const string &name ) const;
+	const Trans *transFind( const string &name ) const;
+
+	// Throws a PnNetError if the file cannot be written
+	void write( const string &fileName ) const;
+
+private:
+	double at;
+	vector<Place> places;
+	vector<Trans> transitions;
+	map<string, unsigned int> placeIndex;
+	map<string, unsigned int> transIndex;
+
+};	// class PnCheckpoint
+
+// Returns the checkpoint saved to a file at <time>, creating it the
+// first time.  Every model naming the same file shares it.  It is
+// written when the program exits.
+PnCheckpoint *pnCheckpointSave( const string &fileName, double time );
+
+// Returns the checkpoint read from a file, reading it the first
+// time.  Throws a PnNetError if it cannot be read.
+const PnCheckpoint *pnCheckpointLoad( const string &fileName );
+
+#endif   //__PNCHECKPOINT_H
@@ -0,0 +1,603 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Markov Chain Solver
+*
+*  The tangible markings are numbered breadth first from the
+*  initial marking.  They are stored one after the other in a flat
+*  array and found through an open addressing table of their
+*  indexes.  Every timed firing of a tangible marking becomes an arc
+*  of the chain, after the immediate transitions it enables have
+*  fired.
+*
+*  Solving the chain only needs, for every state j, the arcs into
+*  it: pi(j) = sum of pi(i) * q(i, j) over the arcs i -> j, divided
+*  by the rate out of j.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnCtmc.h"	// class PnCtmc
+#include "pnRandom.h"	// pnRandMix()
+#include <math.h>	// fabs()
+#include <map>
+
+/** private data **/
+
+// Number of immediate firings in a row after which the immediate
+// transitions are deemed to fire forever
+static const unsigned int IMMEDIATE_LIMIT = 1000000;
+
+static const unsigned int NO_STATE = ~0U;
+
+// Largest residual of a solution
+static const double RESIDUAL_LIMIT = 1e-6;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: markingHash
+********************************************************************/
+static unsigned long long markingHash( const PnTokens *marking, unsigned int places )
+{
+	unsigned long long h = 0;
+
+	for( unsigned int p = 0; p < places; p++ )
+	    h = pnRandMix( h ^ (unsigned long long) marking[p] );
+
+	return h;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnCtmc constructor
+********************************************************************/
+PnCtmc::PnCtmc( const PnNetDef &net, unsigned int workers )
+: def( net )
+, pool( workers )
+, approx( false )
+, maxStates( 0 )
+, stateCount( 0 )
+, vanishing( 0 )
+, relax( 1 )
+, sweepCount( 0 )
+{
+}
+
+/*******************************************************************
+* Function Name: build
+* Description: Computes the rates of the transitions, then explores
+* the tangible markings breadth first.  The states are numbered in
+* the order they are found, so the states still to be expanded are
+* simply the ones after the current one.
+********************************************************************/
+void PnCtmc::build()
+{
+	vector<PnTokens> current, marking;
+	vector<vector<PnTokens> > ends;
+	vector<double> prob, count;
+	vector<unsigned int> fired;
+	unsigned int t, s, a, i;
+
+	rate.assign( def.transitions(), 0 );
+	for( t = 0; t < def.transitions(); t++ )
+	    {
+	    const PnDelay &delay = def.transDelay[t];
+	    double mean = delay.mode == PN_DELAY_UNIFORM || delay.mode == PN_DELAY_DISCRETE ?
+			  ( delay.a + delay.b ) / 2 : delay.a;
+
+	    if( mean == 0 )
+		continue;
+
+	    if( delay.mode != PN_DELAY_EXPONENTIAL && !approx )
+		throw PnNetError( "The delay of transition " + def.transName[t] +
+				  " is not exponential" );
+
+	    rate[t] = 1 / mean;
+	    }
+
+	markings.clear();
+	table.assign( 1024, NO_STATE );
+	stateCount = 0;
+	arcFrom.clear();
+	arcTo.clear();
+	arcTrans.clear();
+	arcRate.clear();
+	arcChainStart.assign( 1, 0 );
+	chainTrans.clear();
+	chainCount.clear();
+	vanishing = 0;
+
+	// The initial marking may itself be vanishing; the steady
+	// state does not depend on where the chain starts
+	resolve( def.initMarking, ends, prob, fired, count );
+	for( i = 0; i < ends.size(); i++ )
+	    stateIndex( ends[i] );
+
+	for( s = 0; s < stateCount; s++ )
+	    {
+	    current.assign( markings.begin() + (size_t) s * def.places(),
+			    markings.begin() + (size_t) ( s + 1 ) * def.places() );
+
+	    for( t = 0; t < def.transitions(); t++ )
+		{
+		if( rate[t] == 0 || !enabled( current, t ) )
+		    continue;
+
+		marking = current;
+		fire( marking, t );
+		resolve( marking, ends, prob, fired, count );
+
+		for( i = 0; i < ends.size(); i++ )
+		    {
+		    arcFrom.push_back( s );
+		    arcTo.push_back( stateIndex( ends[i] ) );
+		    arcTrans.push_back( t );
+		    arcRate.push_back( rate[t] * prob[i] );
+
+		    if( i == 0 )
+			{
+			chainTrans.insert( chainTrans.end(), fired.begin(), fired.end() );
+			chainCount.insert( chainCount.end(), count.begin(), count.end() );
+			}
+		    arcChainStart.push_back( chainTrans.size() );
+		    }
+		}
+	    }
+
+	// Arcs into every state
+	inStart.assign( stateCount + 1, 0 );
+	outRate.assign( stateCount, 0 );
+	for( a = 0; a < arcTo.size(); a++ )
+	    if( arcFrom[a] != arcTo[a] )
+		{
+		inStart[arcTo[a] + 1]++;
+		outRate[arcFrom[a]] += arcRate[a];
+		}
+
+	for( s = 0; s < stateCount; s++ )
+	    inStart[s + 1] += inStart[s];
+
+	vector<unsigned int> fill( inStart.begin(), inStart.end() - 1 );
+
+	inFrom.resize( inStart[stateCount] );
+	inRate.resize( inStart[stateCount] );
+	for( a = 0; a < arcTo.size(); a++ )
+	    if( arcFrom[a] != arcTo[a] )
+		{
+		i = fill[arcTo[a]]++;
+
+		inFrom[i] = arcFrom[a];
+		inRate[i] = arcRate[a];
+		}
+}
+
+/*******************************************************************
+* Function Name: closedClasses
+* Description: Finds the strongly connected components of the chain
+* with Tarjan's algorithm, run without recursion, and counts the
+* ones no arc leaves.
+********************************************************************/
+unsigned int PnCtmc::closedClasses() const
+{
+	vector<unsigned int> start( stateCount + 1, 0 ), to( arcTo.size() );
+	vector<unsigned int> index( stateCount, NO_STATE ), low( stateCount );
+	vector<unsigned int> comp( stateCount, NO_STATE ), stack;
+	vector<pair<unsigned int, unsigned int> > calls;
+	unsigned int counter = 0, comps = 0, s, a;
+
+	for( a = 0; a < arcFrom.size(); a++ )
+	    start[arcFrom[a] + 1]++;
+	for( s = 0; s < stateCount; s++ )
+	    start[s + 1] += start[s];
+
+	vector<unsigned int> fill( start.begin(), start.end() - 1 );
+	for( a = 0; a < arcFrom.size(); a++ )
+	    to[fill[arcFrom[a]]++] = arcTo[a];
+
+	for( unsigned int root = 0; root < stateCount; root++ )
+	    {
+	    if( index[root] != NO_STATE )
+		continue;
+
+	    index[root] = low[root] = counter++;
+	    stack.push_back( root );
+	    calls.push_back( make_pair( root, start[root] ) );
+
+	    while( !calls.empty() )
+		{
+		unsigned int v = calls.back().first;
+
+		if( calls.back().second < start[v + 1] )
+		    {
+		    unsigned int w = to[calls.back().second++];
+
+		    if( index[w] == NO_STATE )
+			{
+			index[w] = low[w] = counter++;
+			stack.push_back( w );
+			calls.push_back( make_pair( w, start[w] ) );
+			}
+		    else if( comp[w] == NO_STATE && index[w] < low[v] )
+			low[v] = index[w];
+		    continue;
+		    }
+
+		calls.pop_back();
+		if( !calls.empty() && low[v] < low[calls.back().first] )
+		    low[calls.back().first] = low[v];
+
+		if( low[v] == index[v] )
+		    {
+		    unsigned int w;
+
+		    do
+			{
+			w = stack.back();
+			stack.pop_back();
+			comp[w] = comps;
+			}
+		    while( w != v );
+
+		    comps++;
+		    }
+		}
+	    }
+
+	vector<bool> closed( comps, true );
+	for( a = 0; a < arcFrom.size(); a++ )
+	    if( comp[arcFrom[a]] != comp[arcTo[a]] )
+		closed[comp[arcFrom[a]]] = false;
+
+	unsigned int count = 0;
+	for( s = 0; s < comps; s++ )
+	    if( closed[s] )
+		count++;
+
+	return count;
+}
+
+/*******************************************************************
+* Function Name: deadStates
+********************************************************************/
+unsigned int PnCtmc::deadStates() const
+{
+	vector<bool> live( stateCount, false );
+	unsigned int count = 0;
+
+	for( unsigned int a = 0; a < arcFrom.size(); a++ )
+	    live[arcFrom[a]] = true;
+
+	for( unsigned int s = 0; s < stateCount; s++ )
+	    if( !live[s] )
+		count++;
+
+	return count;
+}
+
+/*******************************************************************
+* Function Name: solve
+* Description: Sweeps the blocks in parallel, starting from the
+* uniform distribution, and normalizes the probabilities after
+* every sweep.  Then computes the tokens and throughputs.  A dead
+* state keeps its probability: the chain must have none.  The
+* solution is only accepted if its residual is small.
+********************************************************************/
+bool PnCtmc::solve( double epsilon, unsigned int maxSweeps, double omega )
+{
+	unsigned int blocks = pool.workers() < stateCount ? pool.workers() : stateCount;
+	bool converged = false;
+	unsigned int s, a, i;
+
+	prev.assign( stateCount, 1.0 / stateCount );
+	next.assign( stateCount, 0 );
+	blockSum.assign( blocks, 0 );
+	blockStart.resize( blocks + 1 );
+	for( i = 0; i <= blocks; i++ )
+	    blockStart[i] = (unsigned int) ( (unsigned long long) stateCount * i / blocks );
+	relax = omega;
+
+	for( sweepCount = 1; sweepCount <= maxSweeps && !converged; sweepCount++ )
+	    {
+	    double total = 0, change = 0, largest = 0;
+
+	    pool.run( blocks, *this );
+
+	    for( i = 0; i < blocks; i++ )
+		total += blockSum[i];
+
+	    for( s = 0; s < stateCount; s++ )
+		{
+		next[s] /= total;
+		if( fabs( next[s] - prev[s] ) > change )
+		    change = fabs( next[s] - prev[s] );
+		if( next[s] > largest )
+		    largest = next[s];
+		}
+
+	    prev.swap( next );
+	    converged = change <= epsilon * largest;
+	    }
+
+	sweepCount--;
+
+	// Over relaxed sweeps may settle on a vector which is not a
+	// solution
+	if( converged && residual() > RESIDUAL_LIMIT )
+	    converged = false;
+
+	// Metrics
+	placeTokens.assign( def.places(), 0 );
+	for( s = 0; s < stateCount; s++ )
+	    for( unsigned int p = 0; p < def.places(); p++ )
+		placeTokens[p] += prev[s] * markings[(size_t) s * def.places() + p];
+
+	transThroughput.assign( def.transitions(), 0 );
+	for( a = 0; a < arcFrom.size(); a++ )
+	    {
+	    double flow = prev[arcFrom[a]] * rate[arcTrans[a]];
+
+	    transThroughput[arcTrans[a]] += prev[arcFrom[a]] * arcRate[a];
+	    for( i = arcChainStart[a]; i < arcChainStart[a + 1]; i++ )
+		transThroughput[chainTrans[i]] += flow * chainCount[i];
+	    }
+
+	return converged;
+}
+
+/*******************************************************************
+* Function Name: residual
+********************************************************************/
+double PnCtmc::residual() const
+{
+	double largest = 0, worst = 0;
+	unsigned int s, i;
+
+	for( s = 0; s < stateCount; s++ )
+	    if( prev[s] * outRate[s] > largest )
+		largest = prev[s] * outRate[s];
+
+	for( s = 0; s < stateCount; s++ )
+	    {
+	    double r = -prev[s] * outRate[s];
+
+	    for( i = inStart[s]; i < inStart[s + 1]; i++ )
+		r += prev[inFrom[i]] * inRate[i];
+
+	    if( fabs( r ) > worst )
+		worst = fabs( r );
+	    }
+
+	return largest > 0 ? worst / largest : 0;
+}
+
+/*******************************************************************
+* Function Name: run
+* Description: Sweeps the states of a block in order.  The states
+* of the block already swept contribute their new value, all the
+* others the value of the last sweep.
+********************************************************************/
+void PnCtmc::run( unsigned int block, unsigned int )
+{
+	unsigned int first = blockStart[block];
+	unsigned int last = blockStart[block + 1];
+	double sum = 0;
+
+	for( unsigned int j = first; j < last; j++ )
+	    {
+	    double flow = 0, value = prev[j];
+
+	    for( unsigned int i = inStart[j]; i < inStart[j + 1]; i++ )
+		{
+		unsigned int from = inFrom[i];
+
+		flow += ( from >= first && from < j ? next[from] : prev[from] ) * inRate[i];
+		}
+
+	    if( outRate[j] > 0 )
+		value = ( 1 - relax ) * prev[j] + relax * flow / outRate[j];
+
+	    next[j] = value;
+	    sum += value;
+	    }
+
+	blockSum[block] = sum;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: enabled
+********************************************************************/
+bool PnCtmc::enabled( const vector<PnTokens> &marking, unsigned int trans ) const
+{
+	for( unsigned int a = def.preStart[trans]; a < def.preStart[trans + 1]; a++ )
+	    {
+	    PnTokens tokens = marking[def.prePlace[a]];
+
+	    if( def.preWeight[a] == 0 ? tokens != 0 : tokens < def.preWeight[a] )
+		return false;
+	    }
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: fire
+********************************************************************/
+void PnCtmc::fire( vector<PnTokens> &marking, unsigned int trans ) const
+{
+	unsigned int a;
+
+	for( a = def.preStart[trans]; a < def.preStart[trans + 1]; a++ )
+	    marking[def.prePlace[a]] -= def.preWeight[a];
+
+	for( a = def.postStart[trans]; a < def.postStart[trans + 1]; a++ )
+	    marking[def.postPlace[a]] += def.postWeight[a];
+}
+
+/*******************************************************************
+* Function Name: choices
+* Description: Lists the enabled immediate transitions of a marking
+* with the highest priority.
+********************************************************************/
+void PnCtmc::choices( const vector<PnTokens> &marking, vector<unsigned int> &trans ) const
+{
+	trans.clear();
+
+	for( unsigned int t = 0; t < def.transitions(); t++ )
+	    if( rate[t] == 0 && enabled( marking, t ) )
+		{
+		if( !trans.empty() && def.transPriority[t] > def.transPriority[trans[0]] )
+		    trans.clear();
+
+		if( trans.empty() || def.transPriority[t] == def.transPriority[trans[0]] )
+		    trans.push_back( t );
+		}
+}
+
+/*******************************************************************
+* Function Name: resolve
+* Description: Fires the immediate transitions enabled by a marking
+* until the markings reached are tangible.  Returns the tangible
+* markings with their probabilities, and the immediate transitions
+* fired with their expected number of firings.  As long as a single
+* immediate transition is enabled the marking is simply fired on.
+* Otherwise the vanishing markings are expanded one firing at a
+* time, the ones reached by several orders of the same firings
+* being merged, so concurrent immediate transitions do not lead to
+* every order of their firings.
+********************************************************************/
+void PnCtmc::resolve( const vector<PnTokens> &marking, vector<vector<PnTokens> > &ends,
+		      vector<double> &prob, vector<unsigned int> &fired,
+		      vector<double> &count )
+{
+	typedef map<vector<PnTokens>, double> Layer;
+	vector<PnTokens> current( marking );
+	vector<unsigned int> trans, after;
+	map<unsigned int, double> counts;
+	Layer layer, next, tangible;
+	unsigned long steps = 0;
+	unsigned int i;
+
+	for( choices( current, trans ); trans.size() == 1; choices( current, trans ) )
+	    {
+	    if( ++steps > IMMEDIATE_LIMIT )
+		throw PnNetError( "Immediate transitions fire forever from a marking" );
+
+	    fire( current, trans[0] );
+	    counts[trans[0]] += 1;
+	    }
+
+	if( trans.empty() )
+	    {
+	    ends.resize( 1 );
+	    ends[0] = current;
+	    prob.assign( 1, 1.0 );
+	    }
+	else
+	    {
+	    layer[current] = 1;
+
+	    while( !layer.empty() )
+		{
+		for( Layer::iterator m = layer.begin(); m != layer.end(); m++ )
+		    {
+		    double total = 0;
+
+		    choices( m->first, trans );
+		    for( i = 0; i < trans.size(); i++ )
+			total += def.transWeight[trans[i]];
+
+		    for( i = 0; i < trans.size(); i++ )
+			{
+			double p = m->second * def.transWeight[trans[i]] / total;
+
+			if( ++steps > IMMEDIATE_LIMIT )
+			    throw PnNetError( "Immediate transitions fire forever from a marking" );
+
+			current = m->first;
+			fire( current, trans[i] );
+			counts[trans[i]] += p;
+
+			choices( current, after );
+			if( after.empty() )
+			    tangible[current] += p;
+			else
+			    next[current] += p;
+			}
+		    }
+
+		layer.swap( next );
+		next.clear();
+		}
+
+	    ends.clear();
+	    prob.clear();
+	    for( Layer::iterator m = tangible.begin(); m != tangible.end(); m++ )
+		{
+		ends.push_back( m->first );
+		prob.push_back( m->second );
+		}
+	    }
+
+	fired.clear();
+	count.clear();
+	for( map<unsigned int, double>::iterator c = counts.begin(); c != counts.end(); c++ )
+	    {
+	    fired.push_back( c->first );
+	    count.push_back( c->second );
+	    }
+
+	vanishing += steps;
+}
+
+/*******************************************************************
+* Function Name: stateIndex
+* Description: Returns the index of a tangible marking, adding it
+* as a new state if it was not found yet.  The table grows when it
+* is 70% full.
+********************************************************************/
+unsigned int PnCtmc::stateIndex( const vector<PnTokens> &marking )
+{
+	unsigned int places = def.places();
+	size_t mask = table.size() - 1;
+	size_t slot = markingHash( &marking[0], places ) & mask;
+
+	while( table[slot] != NO_STATE )
+	    {
+	    const PnTokens *m = &markings[(size_t) table[slot] * places];
+	    unsigned int p;
+
+	    for( p = 0; p < places && m[p] == marking[p]; p++ )
+		;
+
+	    if( p == places )
+		return table[slot];
+
+	    slot = ( slot + 1 ) & mask;
+	    }
+
+	if( maxStates != 0 && stateCount == maxStates )
+	    throw PnNetError( "The chain has too many states" );
+
+	markings.insert( markings.end(), marking.begin(), marking.end() );
+	table[slot] = stateCount++;
+
+	if( (size_t) stateCount * 10 > table.size() * 7 )
+	    {
+	    // Grow the table
+	    table.assign( table.size() * 2, NO_STATE );
+	    mask = table.size() - 1;
+
+	    for( unsigned int s = 0; s < stateCount; s++ )
+		{
+		slot = markingHash( &markings[(size_t) s * places], places ) & mask;
+		while( table[slot] != NO_STATE )
+		    slot = ( slot + 1 ) & mask;
+		table[slot] = s;
+		}
+	    }
+
+	return stateCount - 1;
+}
@@ -0,0 +1,164 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Markov Chain Solver Header File
+*
+*  When every firing delay of a net is exponential the marking is
+*  a continuous time Markov chain (CTMC) and its steady state gives
+*  exactly what a long simulation estimates: the time averaged
+*  tokens of every place and the throughput of every transition.
+*
+*  A transition with an exponential delay of mean M fires at rate
+*  1/M while it is enabled, whatever its enabling degree, as in
+*  PnEngine.  A transition with a zero delay is immediate: markings
+*  enabling one are vanishing, no time is spent in them.  As in
+*  PnEngine, the enabled immediate transitions with the highest
+*  priority fire first, each with a probability proportional to its
+*  weight.  The vanishing markings are eliminated while the chain is
+*  built, each timed firing leading directly to the tangible
+*  markings the immediate firings end in, with the probability of
+*  reaching each of them.
+*
+*  The chain is solved with block Gauss-Seidel: the states are split
+*  in one block per worker of a PnPool, each block is swept in order
+*  with the values of the current sweep, and the blocks are swept in
+*  parallel using the values of the last sweep for the other blocks.
+*  With one worker this is plain Gauss-Seidel.  More blocks need more
+*  sweeps, since a sweep only carries a change from block to block
+*  once, but the sweeps are shared by the workers; the results agree
+*  to the precision asked whatever the number of workers.  A
+*  relaxation factor other than 1 turns it into SOR.
+*
+*******************************************************************/
+
+#ifndef __PNCTMC_H
+#define __PNCTMC_H
+
+#include <vector>
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnPool.h"	// class PnPool
+
+// PnCtmc class
+
+class PnCtmc : public PnTask
+{
+public:
+	// Constructor.  The net must outlive the solver.  With 0
+	// workers one worker per processor is used.
+	PnCtmc( const PnNetDef &net, unsigned int workers = 0 );
+
+	// Replaces every delay which is neither exponential nor zero
+	// by an exponential delay with the same mean
+	void approximateSet( bool approximate )
+		{approx = approximate;}
+
+	// Stops building the chain after that many states (0 for no
+	// limit)
+	void maxStatesSet( unsigned int states )
+		{maxStates = states;}
+
+	// Builds the chain.  Throws a PnNetError if a delay is not
+	// exponential, if immediate transitions can fire forever, or
+	// go around a loop of vanishing markings, or if there are
+	// more than maxStates states.
+	void build();
+
+	// Number of closed classes of the chain, markings it can
+	// never leave.  The steady state depends on the initial
+	// marking unless there is only one.
+	unsigned int closedClasses() const;
+
+	// Number of tangible states with no enabled transition
+	unsigned int deadStates() const;
+
+	// Solves the chain.  Returns true if the largest change of a
+	// probability in a sweep, relative to the largest probability,
+	// fell below epsilon within maxSweeps sweeps and the residual
+	// is below 1e-6.
+	bool solve( double epsilon, unsigned int maxSweeps, double omega = 1 );
+
+	// Chain
+	unsigned int states() const
+		{return stateCount;}
+
+	unsigned long long arcs() const
+		{return arcTo.size();}
+
+	unsigned long long vanishingFirings() const
+		{return vanishing;}
+
+	// Solution
+	unsigned int sweeps() const
+		{return sweepCount;}
+
+	// Largest |(pi.Q)_j| relative to the largest flow out of a state
+	double residual() const;
+
+	// Time averaged tokens of the places and firings per second of
+	// the transitions
+	const vector<double> &tokens() const
+		{return placeTokens;}
+
+	const vector<double> &throughput() const
+		{return transThroughput;}
+
+	// Sweeps a block
+	void run( unsigned int block, unsigned int worker );
+
+private:
+	bool enabled( const vector<PnTokens> &marking, unsigned int trans ) const;
+	void fire( vector<PnTokens> &marking, unsigned int trans ) const;
+	unsigned int stateIndex( const vector<PnTokens> &marking );
+	void choices( const vector<PnTokens> &marking, vector<unsigned int> &trans ) const;
+	void resolve( const vector<PnTokens> &marking, vector<vector<PnTokens> > &ends,
+		      vector<double> &prob, vector<unsigned int> &fired,
+		      vector<double> &count );
+
+	const PnNetDef &def;
+	PnPool pool;
+	bool approx;
+	unsigned int maxStates;
+
+	// Rate of every timed transition, 0 for immediate ones
+	vector<double> rate;
+
+	// Tangible markings, one row of places per state, and the open
+	// addressing table of their indexes (~0 for a free slot)
+	vector<PnTokens> markings;
+	vector<unsigned int> table;
+	unsigned int stateCount;
+
+	// Arcs of the chain, one per timed firing and tangible marking
+	// it leads to, with their rates.  The first arc of a timed
+	// firing carries the immediate transitions fired after it and
+	// their expected number of firings.
+	vector<unsigned int> arcFrom;
+	vector<unsigned int> arcTo;
+	vector<unsigned int> arcTrans;
+	vector<double> arcRate;
+	vector<unsigned int> arcChainStart;
+	vector<unsigned int> chainTrans;
+	vector<double> chainCount;
+	unsigned long long vanishing;
+
+	// Arcs into every state, self loops left out, and the rate out
+	// of every state
+	vector<unsigned int> inStart;
+	vector<unsigned int> inFrom;
+	vector<double> inRate;
+	vector<double> outRate;
+
+	// Solution: probabilities of the last sweep and of the current
+	// one, the first state and the sum of every block
+	vector<double> prev;
+	vector<double> next;
+	vector<unsigned int> blockStart;
+	vector<double> blockSum;
+	double relax;
+	unsigned int sweepCount;
+
+	vector<double> placeTokens;
+	vector<double> transThroughput;
+
+};	// class PnCtmc
+
+#endif   //__PNCTMC_H
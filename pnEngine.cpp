@@ -0,0 +1,677 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Firing Engine
+*
+*  This is the implementation of the engine which fires the
+*  transitions of a compiled net directly on its marking.  Firing
+*  a transition costs one pass over its input and output arcs plus
+*  an enablement check of the consumers of the places it touched.
+*  The scheduled firings are kept in an event list (see pnEvents.h);
+*  cancelled firings are left in the list and skipped when they
+*  reach the head.
+*  When siphons are watched, a firing also updates the token count
+*  of the siphons of the places it touched.  The immediate
+*  transitions which get enabled are kept in a list of their own
+*  and fired before fire() returns.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnEngine.h"	// class PnEngine
+#include <algorithm>	// binary_search()
+#include <map>
+#ifdef __AVX2__
+#include <immintrin.h>	// _mm256_testc_si256()
+#endif
+
+/** private data **/
+
+// Number of immediate firings in a row after which the immediate
+// transitions are deemed to fire forever
+static const unsigned long IMMEDIATE_LIMIT = 1000000;
+
+// Largest number of transitions of a dense safe net for which the
+// enablement of every transition is recomputed after a firing
+static const unsigned int RECOMPUTE_LIMIT = 64;
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnEngine constructor
+* Description: Allocates the state of the engine and builds the
+* masks of the transitions in safe mode.
+********************************************************************/
+PnEngine::PnEngine( const PnNetDef &net, bool safe, PnEventListKind list )
+: def( net )
+, safeMode( safe )
+, dense( safe && net.places() <= 256 )
+, recomputeAll( dense && net.transitions() <= RECOMPUTE_LIMIT )
+, marking( net.places() )
+, stamp( net.transitions(), 0 )
+, scheduled( net.transitions(), false )
+, dueTime( net.transitions(), 0 )
+, events( list )
+, clock( 0 )
+, firingCount( 0 )
+, seed( 0 )
+, choices( 0 )
+, killedTrans( net.transitions(), false )
+, killedCount( 0 )
+, inputTrans( 0 )
+{
+	for( unsigned int t = 0; t < net.transitions(); t++ )
+	    for( unsigned int a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		if( net.preWeight[a] != 0 )
+		    {
+		    inputTrans++;
+		    break;
+		    }
+
+	placeSiphonStart.assign( net.places() + 1, 0 );
+
+	if( safeMode )
+	    masksBuild();
+}
+
+/*******************************************************************
+* Function Name: siphonsSet
+* Description: Builds the list of the siphons of every place.
+********************************************************************/
+void PnEngine::siphonsSet( const vector<PnPlaceSet> &sets )
+{
+	unsigned int s, i, p;
+
+	siphons = sets;
+	placeSiphonStart.assign( def.places() + 1, 0 );
+
+	for( s = 0; s < siphons.size(); s++ )
+	    for( i = 0; i < siphons[s].size(); i++ )
+		placeSiphonStart[siphons[s][i] + 1]++;
+
+	for( p = 0; p < def.places(); p++ )
+	    placeSiphonStart[p + 1] += placeSiphonStart[p];
+
+	vector<unsigned int> fill( placeSiphonStart.begin(), placeSiphonStart.end() - 1 );
+
+	placeSiphon.resize( placeSiphonStart[def.places()] );
+	for( s = 0; s < siphons.size(); s++ )
+	    for( i = 0; i < siphons[s].size(); i++ )
+		placeSiphon[fill[siphons[s][i]]++] = s;
+}
+
+/*******************************************************************
+* Function Name: reset
+* Description: Restores the initial marking, empties the event list,
+* fires the immediate transitions and schedules every transition
+* enabled by the marking left.
+* The draw counters of the transitions restart from zero so two
+* runs with the same seed are identical.
+********************************************************************/
+void PnEngine::reset( double startTime, unsigned long long runSeed )
+{
+	markingSet( def.initMarking );
+
+	draws.assign( def.transitions(), 0 );
+	seed = runSeed;
+	events.clear();
+	scheduled.assign( def.transitions(), false );
+	clock = startTime;
+	firingCount = 0;
+	ready.clear();
+	choices = 0;
+	firedList.clear();
+	siphonsReset();
+
+	for( unsigned int t = 0; t < def.transitions(); t++ )
+	    update( t );
+
+	resolve();
+	purge();
+}
+
+/*******************************************************************
+* Function Name: stateGet
+* Description: The immediate transitions are never pending between
+* two steps, so the marking, the draws and the scheduled firings
+* are the whole state.
+********************************************************************/
+void PnEngine::stateGet( PnEngineState &state ) const
+{
+	unsigned int i;
+
+	state.time = clock;
+	state.firings = firingCount;
+	state.choices = choices;
+
+	state.marking.resize( def.places() );
+	for( i = 0; i < def.places(); i++ )
+	    state.marking[i] = tokens( i );
+
+	state.draws = draws;
+
+	state.due.resize( def.transitions() );
+	for( i = 0; i < def.transitions(); i++ )
+	    state.due[i] = due( i );
+}
+
+/*******************************************************************
+* Function Name: stateSet
+* Description: Schedules the firings of the state, moved by the
+* difference between <startTime> and the time of the state, then
+* lets update() schedule or cancel any transition the state does
+* not agree with, as reset() does for the initial marking.
+********************************************************************/
+void PnEngine::stateSet( const PnEngineState &state, double startTime,
+			 unsigned long long runSeed )
+{
+	unsigned int t;
+
+	if( state.marking.size() != def.places() ||
+	    state.draws.size() != def.transitions() ||
+	    state.due.size() != def.transitions() )
+	    throw PnNetError( "The saved state is not one of this net" );
+
+	markingSet( state.marking );
+
+	draws = state.draws;
+	seed = runSeed;
+	events.clear();
+	scheduled.assign( def.transitions(), false );
+	clock = startTime;
+	firingCount = state.firings;
+	ready.clear();
+	choices = state.choices;
+	firedList.clear();
+	siphonsReset();
+
+	for( t = 0; t < def.transitions(); t++ )
+	    if( state.due[t] >= 0 && !def.immediate( t ) && enabled( t ) )
+		{
+		PnEvent ev;
+
+		ev.time = startTime + ( state.due[t] - state.time );
+		ev.trans = t;
+		ev.stamp = stamp[t];
+		dueTime[t] = ev.time;
+
+		scheduled[t] = true;
+		events.push( ev );
+		}
+
+	for( t = 0; t < def.transitions(); t++ )
+	    update( t );
+
+	resolve();
+	purge();
+}
+
+/*******************************************************************
+* Function Name: enabled
+* Description: A transition is enabled when every input place holds
+* at least the weight of its arc and every inhibitor place is empty.
+********************************************************************/
+bool PnEngine::enabled( unsigned int trans ) const
+{
+	if( safeMode )
+	    return safeEnabled( trans );
+
+	for( unsigned int a = def.preStart[trans]; a < def.preStart[trans + 1]; a++ )
+	    {
+	    PnTokens tokens = marking[def.prePlace[a]];
+
+	    if( def.preWeight[a] == 0 ? tokens != 0 : tokens < def.preWeight[a] )
+		return false;
+	    }
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: fire
+* Description: Fires the transition at the head of the event list,
+* then the immediate transitions.
+********************************************************************/
+unsigned int PnEngine::fire()
+{
+	PnEvent ev = events.top();
+
+	events.pop();
+	clock = ev.time;
+	firedList.clear();
+
+	arcsFire( ev.trans );
+	resolve();
+	purge();
+
+	return ev.trans;
+}
+
+/*******************************************************************
+* Function Name: deposit
+* Description: Adds tokens to places and checks their consumers for
+* a change of enablement, then fires the immediate transitions.
+********************************************************************/
+void PnEngine::deposit( double time, const vector<pair<unsigned int, PnTokens> > &arrivals )
+{
+	unsigned int i, c;
+
+	clock = time;
+	firedList.clear();
+
+	for( i = 0; i < arrivals.size(); i++ )
+	    {
+	    unsigned int p = arrivals[i].first;
+
+	    if( safeMode )
+		bits[p >> 6] |= 1ULL << ( p & 63 );
+	    else
+		marking[p] += arrivals[i].second;
+
+	    siphonsUpdate( p, arrivals[i].second );
+	    }
+
+	for( i = 0; i < arrivals.size(); i++ )
+	    {
+	    unsigned int p = arrivals[i].first;
+
+	    for( c = def.consStart[p]; c < def.consStart[p + 1]; c++ )
+		update( def.consTrans[c] );
+	    }
+
+	resolve();
+	purge();
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: markingSet
+* Description: Sets the marking, and its bitset in safe mode.
+********************************************************************/
+void PnEngine::markingSet( const vector<PnTokens> &tokens )
+{
+	marking = tokens;
+
+	if( safeMode )
+	    {
+	    bits.assign( bits.size(), 0 );
+	    for( unsigned int p = 0; p < def.places(); p++ )
+		if( marking[p] != 0 )
+		    bits[p >> 6] |= 1ULL << ( p & 63 );
+	    }
+}
+
+/*******************************************************************
+* Function Name: siphonsReset
+* Description: Counts the tokens of the watched siphons in the
+* current marking and kills the siphons which are empty.
+********************************************************************/
+void PnEngine::siphonsReset()
+{
+	killedTrans.assign( def.transitions(), false );
+	killedCount = 0;
+	siphonTokens.assign( siphons.size(), 0 );
+
+	for( unsigned int s = 0; s < siphons.size(); s++ )
+	    {
+	    for( unsigned int i = 0; i < siphons[s].size(); i++ )
+		siphonTokens[s] += tokens( siphons[s][i] );
+
+	    if( siphonTokens[s] == 0 )
+		siphonKill( s );
+	    }
+}
+
+/*******************************************************************
+* Function Name: update
+* Description: Schedules a transition which just became enabled
+* and cancels the firing of a transition which just got disabled.
+********************************************************************/
+void PnEngine::update( unsigned int trans )
+{
+	bool en = enabled( trans );
+
+	// An immediate transition joins the ready list, which drops it
+	// once it is disabled
+	if( def.immediate( trans ) )
+	    {
+	    if( en && !scheduled[trans] )
+		{
+		scheduled[trans] = true;
+		ready.push_back( trans );
+		}
+	    }
+	else if( en && !scheduled[trans] )
+	    schedule( trans );
+	else if( !en && scheduled[trans] )
+	    {
+	    scheduled[trans] = false;
+	    ++stamp[trans];
+	    }
+}
+
+/*******************************************************************
+* Function Name: schedule
+* Description: Schedules the firing of a transition a random delay
+* after the current time.
+********************************************************************/
+void PnEngine::schedule( unsigned int trans )
+{
+	PnEvent ev;
+
+	ev.time = clock + delayGet( trans );
+	ev.trans = trans;
+	ev.stamp = stamp[trans];
+	dueTime[trans] = ev.time;
+
+	scheduled[trans] = true;
+	events.push( ev );
+}
+
+/*******************************************************************
+* Function Name: purge
+* Description: Removes the cancelled firings from the head of the
+* event list so the head is always a firing which will happen.
+********************************************************************/
+void PnEngine::purge()
+{
+	while( !events.empty() &&
+	       events.top().stamp != stamp[events.top().trans] )
+	    events.pop();
+}
+
+/*******************************************************************
+* Function Name: delayGet
+* Description: Returns the next firing delay of a transition.  The
+* index of the transition, or its number in the larger net, is the
+* stream of the generator.
+********************************************************************/
+double PnEngine::delayGet( unsigned int trans )
+{
+	return pnDelayDraw( def.transDelay[trans], seed,
+			    streams.empty() ? trans : streams[trans], draws[trans]++ );
+}
+
+/*******************************************************************
+* Function Name: siphonsUpdate
+* Description: Adds a change of the tokens of a place to its
+* siphons and kills the siphons which got empty.
+********************************************************************/
+void PnEngine::siphonsUpdate( unsigned int place, long long delta )
+{
+	for( unsigned int i = placeSiphonStart[place]; i < placeSiphonStart[place + 1]; i++ )
+	    {
+	    unsigned int s = placeSiphon[i];
+
+	    siphonTokens[s] += delta;
+	    if( siphonTokens[s] == 0 && delta != 0 )
+		siphonKill( s );
+	    }
+}
+
+/*******************************************************************
+* Function Name: siphonKill
+* Description: Marks as killed every transition with an input arc
+* from an empty siphon.  Inhibitor arcs take no token and do not
+* count.
+********************************************************************/
+void PnEngine::siphonKill( unsigned int siphon )
+{
+	const PnPlaceSet &s = siphons[siphon];
+
+	for( unsigned int t = 0; t < def.transitions(); t++ )
+	    {
+	    if( killedTrans[t] )
+		continue;
+
+	    for( unsigned int a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		if( def.preWeight[a] != 0 &&
+		    binary_search( s.begin(), s.end(), def.prePlace[a] ) )
+		    {
+		    killedTrans[t] = true;
+		    killedCount++;
+		    break;
+		    }
+	    }
+}
+
+/*******************************************************************
+* Function Name: arcsFire
+* Description: Fires a transition.  Tokens are removed from the
+* input places and deposited in the output places, then the
+* transition itself and the consumers of every place it touched
+* are checked for a change of enablement.
+********************************************************************/
+void PnEngine::arcsFire( unsigned int t )
+{
+	unsigned int a, c;
+
+	scheduled[t] = false;
+	++stamp[t];
+	++firingCount;
+	firedList.push_back( t );
+
+	if( safeMode )
+	    for( a = maskStart[t]; a < maskStart[t + 1]; a++ )
+		{
+		uint64_t &word = bits[maskWord[a]];
+		word = ( word & ~maskPre[a] ) | maskPost[a];
+		}
+	else
+	    {
+	    for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		marking[def.prePlace[a]] -= def.preWeight[a];
+
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		marking[def.postPlace[a]] += def.postWeight[a];
+	    }
+
+	if( !siphons.empty() )
+	    {
+	    // Outputs first so a siphon emptied and refilled by the
+	    // same firing never looks empty
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		siphonsUpdate( def.postPlace[a], def.postWeight[a] );
+
+	    for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		siphonsUpdate( def.prePlace[a], -(long long) def.preWeight[a] );
+	    }
+
+	// A small safe net recomputes every transition, which costs
+	// less than walking the consumers of the places
+	if( recomputeAll )
+	    {
+	    for( c = 0; c < def.transitions(); c++ )
+		update( c );
+	    return;
+	    }
+
+	update( t );
+
+	for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+	    {
+	    unsigned int p = def.prePlace[a];
+	    for( c = def.consStart[p]; c < def.consStart[p + 1]; c++ )
+		update( def.consTrans[c] );
+	    }
+
+	for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+	    {
+	    unsigned int p = def.postPlace[a];
+	    for( c = def.consStart[p]; c < def.consStart[p + 1]; c++ )
+		update( def.consTrans[c] );
+	    }
+}
+
+/*******************************************************************
+* Function Name: resolve
+* Description: Fires immediate transitions until none is enabled.
+* At every step the list of ready transitions is cleaned of the
+* ones disabled by the previous firings, then one of the ready
+* transitions with the highest priority is fired, drawn in
+* proportion to the weights when there are several.
+********************************************************************/
+void PnEngine::resolve()
+{
+	for( unsigned long steps = 0; ; steps++ )
+	    {
+	    unsigned int i, kept = 0, count = 0, chosen = 0;
+	    int top = 0;
+	    double total = 0;
+
+	    for( i = 0; i < ready.size(); i++ )
+		{
+		unsigned int t = ready[i];
+
+		if( !enabled( t ) )
+		    {
+		    scheduled[t] = false;
+		    continue;
+		    }
+
+		if( kept == 0 || def.transPriority[t] > top )
+		    {
+		    top = def.transPriority[t];
+		    total = 0;
+		    count = 0;
+		    }
+
+		if( def.transPriority[t] == top )
+		    {
+		    total += def.transWeight[t];
+		    count++;
+		    chosen = kept;
+		    }
+
+		ready[kept++] = t;
+		}
+
+	    ready.resize( kept );
+
+	    if( kept == 0 )
+		return;
+
+	    if( steps == IMMEDIATE_LIMIT )
+		throw PnNetError( "Immediate transitions fire forever, " +
+				  def.transName[ready[chosen]] + " among them" );
+
+	    // Several candidates: the last one is kept if rounding
+	    // leaves the draw beyond the sum of the weights
+	    if( count > 1 )
+		{
+		double pick = total * pnRandUnit( pnRand64( seed, ~1ULL, choices++ ) );
+
+		for( i = 0; i < kept; i++ )
+		    if( def.transPriority[ready[i]] == top )
+			{
+			chosen = i;
+			pick -= def.transWeight[ready[i]];
+			if( pick < 0 )
+			    break;
+			}
+		}
+
+	    unsigned int t = ready[chosen];
+
+	    ready[chosen] = ready.back();
+	    ready.pop_back();
+	    arcsFire( t );
+	    }
+}
+
+/*******************************************************************
+* Function Name: masksBuild
+* Description: Builds the masks of every transition from its arcs,
+* one entry per word of the marking it has arcs in, and the dense
+* masks when the marking fits in 256 bits.
+********************************************************************/
+void PnEngine::masksBuild()
+{
+	unsigned int words = ( ( def.places() + 255 ) / 256 ) * 4;
+	unsigned int t, a;
+
+	bits.assign( words, 0 );
+	maskStart.assign( 1, 0 );
+
+	for( t = 0; t < def.transitions(); t++ )
+	    {
+	    map<unsigned int, uint64_t> pre, inhib, post;
+	    map<unsigned int, bool> used;
+
+	    for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		{
+		unsigned int p = def.prePlace[a];
+
+		( def.preWeight[a] == 0 ? inhib : pre )[p >> 6] |= 1ULL << ( p & 63 );
+		used[p >> 6] = true;
+		}
+
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		{
+		unsigned int p = def.postPlace[a];
+
+		post[p >> 6] |= 1ULL << ( p & 63 );
+		used[p >> 6] = true;
+		}
+
+	    for( map<unsigned int, bool>::iterator w = used.begin(); w != used.end(); w++ )
+		{
+		maskWord.push_back( w->first );
+		maskPre.push_back( pre[w->first] );
+		maskInhib.push_back( inhib[w->first] );
+		maskPost.push_back( post[w->first] );
+		}
+
+	    maskStart.push_back( maskWord.size() );
+	    }
+
+	if( !dense )
+	    return;
+
+	densePre.assign( (size_t) def.transitions() * 4, 0 );
+	denseInhib.assign( (size_t) def.transitions() * 4, 0 );
+	for( t = 0; t < def.transitions(); t++ )
+	    for( a = maskStart[t]; a < maskStart[t + 1]; a++ )
+		{
+		densePre[t * 4 + maskWord[a]] = maskPre[a];
+		denseInhib[t * 4 + maskWord[a]] = maskInhib[a];
+		}
+}
+
+/*******************************************************************
+* Function Name: safeEnabled
+* Description: Checks the masks of a transition against the bitset
+* of the marking.
+********************************************************************/
+bool PnEngine::safeEnabled( unsigned int trans ) const
+{
+	if( dense )
+	    {
+#ifdef __AVX2__
+	    __m256i m = _mm256_loadu_si256( (const __m256i *) &bits[0] );
+	    __m256i pre = _mm256_loadu_si256( (const __m256i *) &densePre[trans * 4] );
+	    __m256i inhib = _mm256_loadu_si256( (const __m256i *) &denseInhib[trans * 4] );
+
+	    return _mm256_testc_si256( m, pre ) && _mm256_testz_si256( m, inhib );
+#else
+	    const uint64_t *pre = &densePre[trans * 4];
+	    const uint64_t *inhib = &denseInhib[trans * 4];
+	    uint64_t missing = 0;
+
+	    for( unsigned int w = 0; w < 4; w++ )
+		missing |= ( pre[w] & ~bits[w] ) | ( inhib[w] & bits[w] );
+
+	    return missing == 0;
+#endif
+	    }
+
+	for( unsigned int a = maskStart[trans]; a < maskStart[trans + 1]; a++ )
+	    {
+	    uint64_t word = bits[maskWord[a]];
+
+	    if( ( word & maskPre[a] ) != maskPre[a] || ( word & maskInhib[a] ) != 0 )
+		return false;
+	    }
+
+	return true;
+}
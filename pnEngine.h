@@ -0,0 +1,241 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Firing Engine Header File
+*
+*  A PnEngine executes a timed Petri Net described by a PnNetDef
+*  without exchanging any message: the marking is kept in one flat
+*  array and the transitions are fired directly on it.
+*
+*  The timing semantics are the ones of the PnTrans model: when a
+*  transition becomes enabled its firing is scheduled a random
+*  delay later, drawn from the distribution of the transition with
+*  the counter-based generator of pnRandom.h.  The firing stays
+*  scheduled as long as the transition remains enabled (enabling
+*  memory); it is cancelled as soon as the transition is disabled.
+*  After a firing the transition is rescheduled with a new delay if
+*  it is still enabled.  Source transitions are always enabled.
+*  The delays are drawn from other streams than the ones of the
+*  PnTrans models, so the runs agree in distribution, not firing
+*  for firing.
+*
+*  A transition with no delay (see pnDelayZero()) is immediate: it
+*  never goes through the event list.  Once a firing is done, the
+*  immediate transitions it enabled fire right away, at the same
+*  time, until none is enabled, so a cascade of logical steps costs
+*  one event.  No timed transition fires while an immediate one is
+*  enabled.  The enabled immediate transitions with the highest
+*  priority fire first; among them the one to fire is drawn in
+*  proportion to the weights, from a stream of the generator no
+*  transition uses.
+*
+*  A 1-safe net (see pnNetSafe()) can be fired in safe mode: the
+*  marking is a bitset and every transition has a pre, an inhibitor
+*  and a post mask per word of it.  A transition is enabled when
+*  (M & pre) == pre and (M & inhibitor) == 0, and firing it is
+*  M = (M & ~pre) | post.  When the net has at most 256 places the
+*  masks of a transition are one 256 bit vector each, checked with
+*  a single AVX2 instruction when the engine is compiled with AVX2,
+*  and if it also has few transitions the enablement of all of them
+*  is recomputed after a firing instead of the one of the consumers
+*  of the places touched.  The results are the same in both modes.
+*
+*  The engine can also watch the siphons of the net (see
+*  pnStruct.h): a siphon which gets empty stays empty, so every
+*  transition taking tokens from it is dead for the rest of the
+*  run.  The net is dead once every transition with an input arc
+*  is, even if source transitions keep firing.
+*
+*  The state of a run can be taken out of the engine and put back
+*  in another engine of the same net, to be saved in a checkpoint
+*  (see pnCheckpoint.h).  The delays already drawn are part of the
+*  state; a new seed only changes the delays drawn afterwards.
+*
+*******************************************************************/
+
+#ifndef __PNENGINE_H
+#define __PNENGINE_H
+
+#include <stdint.h>	// uint64_t
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEvents.h"	// class PnEventList
+#include "pnStruct.h"	// PnPlaceSet
+
+// State of a run of an engine, at time <time>.  A transition which
+// is not scheduled has a negative due time.
+struct PnEngineState
+    {
+    double time;
+    unsigned long long firings;
+    unsigned long long choices;	// draws among immediate transitions
+    vector<PnTokens> marking;
+    vector<unsigned long long> draws;
+    vector<double> due;
+    };
+
+// PnEngine class
+
+class PnEngine
+{
+public:
+	// Constructor.  The net must outlive the engine.  Safe mode
+	// may only be asked for a net which pnNetSafe() proved 1-safe.
+	// The kind of event list does not change the results.
+	PnEngine( const PnNetDef &net, bool safe = false,
+		  PnEventListKind list = PN_LIST_HEAP );
+
+	// Restores the initial marking, fires the immediate
+	// transitions it enables and schedules the timed transitions
+	// which are enabled.  The seed selects the sequence of random
+	// delays of the run.  Throws a PnNetError if the immediate
+	// transitions fire forever.
+	void reset( double startTime, unsigned long long seed );
+
+	// Copies the state of the run.  The state is the one of every
+	// time from now() to the next firing.
+	void stateGet( PnEngineState &state ) const;
+
+	// Restarts the run from a state taken from an engine of the
+	// same net, moved to <startTime>: the scheduled firings keep
+	// their delays from the time of the state.  The seed selects
+	// the delays drawn from now on.  Throws a PnNetError if the
+	// state does not fit the net or if the immediate transitions
+	// fire forever.
+	void stateSet( const PnEngineState &state, double startTime,
+		       unsigned long long seed );
+
+	// Returns true if at least one transition is scheduled
+	bool pending() const
+		{return !events.empty();}
+
+	// Time and index of the next transition to fire.  Only
+	// valid if pending() is true.
+	double nextTime() const
+		{return events.top().time;}
+
+	unsigned int nextTransition() const
+		{return events.top().trans;}
+
+	// Fires the next scheduled transition and the immediate
+	// transitions it enables, and returns the index of the
+	// scheduled one.  Throws a PnNetError if the immediate
+	// transitions fire forever.
+	unsigned int fire();
+
+	// Adds tokens to places, as (place, count) pairs, at a time no
+	// earlier than now(), then fires the immediate transitions
+	// they enable.  Used when the tokens come from a transition
+	// outside the net, for instance in another partition (see
+	// pnPart.h).
+	void deposit( double time, const vector<pair<unsigned int, PnTokens> > &arrivals );
+
+	// Time a transition is scheduled to fire at, or a negative
+	// value if it is not scheduled
+	double due( unsigned int trans ) const
+		{return scheduled[trans] && !def.immediate( trans ) ? dueTime[trans] : -1;}
+
+	// Transitions fired by the last fire(), deposit() or reset(),
+	// in the order they fired
+	const vector<unsigned int> &lastFired() const
+		{return firedList;}
+
+	double now() const
+		{return clock;}
+
+	PnTokens tokens( unsigned int place ) const
+		{return safeMode ? (PnTokens) ( ( bits[place >> 6] >> ( place & 63 ) ) & 1 ) :
+				   marking[place];}
+
+	bool safe() const
+		{return safeMode;}
+
+	bool enabled( unsigned int trans ) const;
+
+	unsigned long firings() const
+		{return firingCount;}
+
+	const PnNetDef &net() const
+		{return def;}
+
+	// Numbers the transitions as in a larger net, so a subnet of it
+	// draws the same delays as the whole net.  Takes effect at the
+	// next reset().
+	void streamsSet( const vector<unsigned int> &ids )
+		{streams = ids;}
+
+	// Sets the siphons to watch, usually the ones of pnSiphons().
+	// Takes effect at the next reset().
+	void siphonsSet( const vector<PnPlaceSet> &sets );
+
+	// Returns true if an empty siphon killed the transition
+	bool killed( unsigned int trans ) const
+		{return killedTrans[trans];}
+
+	// Returns true if every transition with an input arc was
+	// killed by an empty siphon
+	bool dead() const
+		{return inputTrans != 0 && killedCount == inputTrans;}
+
+private:
+	void masksBuild();
+	void markingSet( const vector<PnTokens> &tokens );
+	void siphonsReset();
+	bool safeEnabled( unsigned int trans ) const;
+	void arcsFire( unsigned int trans );
+	void resolve();
+	void update( unsigned int trans );
+	void schedule( unsigned int trans );
+	void purge();
+	double delayGet( unsigned int trans );
+	void siphonsUpdate( unsigned int place, long long delta );
+	void siphonKill( unsigned int siphon );
+
+	const PnNetDef &def;
+
+	// Safe mode: the marking bitset, padded to 256 bits, and the
+	// masks of the transitions.  The sparse masks list the words a
+	// transition has arcs in; the dense ones, only used with at
+	// most 256 places, are 4 words per transition.
+	bool safeMode;
+	bool dense;
+	bool recomputeAll;
+	vector<uint64_t> bits;
+	vector<unsigned int> maskStart;
+	vector<unsigned int> maskWord;
+	vector<uint64_t> maskPre;
+	vector<uint64_t> maskInhib;
+	vector<uint64_t> maskPost;
+	vector<uint64_t> densePre;
+	vector<uint64_t> denseInhib;
+
+	// State variables
+	vector<PnTokens> marking;
+	vector<unsigned int> stamp;
+	vector<bool> scheduled;
+	vector<unsigned long long> draws;
+	vector<double> dueTime;
+	vector<unsigned int> streams;
+	PnEventList events;
+	double clock;
+	unsigned long firingCount;
+	unsigned long long seed;
+
+	// Immediate transitions which got enabled, some of which may
+	// have been disabled since, the draws made among them and the
+	// transitions fired by the last step
+	vector<unsigned int> ready;
+	unsigned long long choices;
+	vector<unsigned int> firedList;
+
+	// Watched siphons, the siphons of every place and the tokens
+	// of every siphon
+	vector<PnPlaceSet> siphons;
+	vector<unsigned int> placeSiphonStart;
+	vector<unsigned int> placeSiphon;
+	vector<PnTokens> siphonTokens;
+	vector<bool> killedTrans;
+	unsigned int killedCount;
+	unsigned int inputTrans;	// transitions with an input arc
+
+};	// class PnEngine
+
+#endif   //__PNENGINE_H
@@ -0,0 +1,180 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Event List
+*
+*  The heap and the bottom of the ladder queue are kept with the
+*  standard heap algorithms and the ordering of PnEvent, so the
+*  earliest firing is at their front.  A firing goes to the bottom,
+*  a bucket or the top according to its position (t - start) / width
+*  on the rung; the position grows with the time, so every firing of
+*  a tier is due before the ones of the next tier and before the
+*  ones of the next buckets.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnEvents.h"	// class PnEventList
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnEventListParse
+********************************************************************/
+bool pnEventListParse( const string &name, PnEventListKind &kind )
+{
+	if( name == "heap" )
+	    kind = PN_LIST_HEAP;
+	else if( name == "ladder" )
+	    kind = PN_LIST_LADDER;
+	else
+	    return false;
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: PnEventList constructor
+********************************************************************/
+PnEventList::PnEventList( PnEventListKind kind )
+: listKind( kind )
+, count( 0 )
+, start( 0 )
+, width( 1 )
+, rungSize( 0 )
+, cur( 0 )
+{
+}
+
+/*******************************************************************
+* Function Name: push
+* Description: Adds a firing.  The bottom is refilled when a firing
+* is pushed into an empty ladder queue, so top() is always valid.
+********************************************************************/
+void PnEventList::push( const PnEvent &ev )
+{
+	count++;
+
+	if( listKind == PN_LIST_HEAP )
+	    {
+	    heap.push_back( ev );
+	    push_heap( heap.begin(), heap.end() );
+	    return;
+	    }
+
+	double pos = ( ev.time - start ) / width;
+
+	if( pos < cur )
+	    {
+	    bottom.push_back( ev );
+	    push_heap( bottom.begin(), bottom.end() );
+	    }
+	else if( pos < rungSize )
+	    buckets[(size_t) pos].push_back( ev );
+	else
+	    overflow.push_back( ev );
+
+	if( bottom.empty() )
+	    refill();
+}
+
+/*******************************************************************
+* Function Name: pop
+* Description: Removes the earliest firing.
+********************************************************************/
+void PnEventList::pop()
+{
+	count--;
+
+	if( listKind == PN_LIST_HEAP )
+	    {
+	    pop_heap( heap.begin(), heap.end() );
+	    heap.pop_back();
+	    return;
+	    }
+
+	pop_heap( bottom.begin(), bottom.end() );
+	bottom.pop_back();
+
+	if( bottom.empty() && count != 0 )
+	    refill();
+}
+
+/*******************************************************************
+* Function Name: clear
+********************************************************************/
+void PnEventList::clear()
+{
+	for( size_t i = cur; i < rungSize; i++ )
+	    buckets[i].clear();
+
+	heap.clear();
+	bottom.clear();
+	overflow.clear();
+	count = 0;
+	start = 0;
+	width = 1;
+	rungSize = 0;
+	cur = 0;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: refill
+* Description: Makes the next non empty bucket the bottom, building
+* a new rung from the top when the rung is used up.
+********************************************************************/
+void PnEventList::refill()
+{
+	while( bottom.empty() )
+	    {
+	    if( cur == rungSize )
+		{
+		if( overflow.empty() )
+		    return;
+
+		rungBuild();
+		}
+
+	    // The bucket gets the empty storage of the bottom back
+	    bottom.swap( buckets[cur++] );
+	    make_heap( bottom.begin(), bottom.end() );
+	    }
+}
+
+/*******************************************************************
+* Function Name: rungBuild
+* Description: Spreads the top over one bucket per firing, plus one
+* so the latest firing falls in the last bucket.  Firings due at
+* the same time all fall in the first bucket.
+********************************************************************/
+void PnEventList::rungBuild()
+{
+	double first = overflow[0].time, last = overflow[0].time;
+	size_t i;
+
+	for( i = 1; i < overflow.size(); i++ )
+	    if( overflow[i].time < first )
+		first = overflow[i].time;
+	    else if( overflow[i].time > last )
+		last = overflow[i].time;
+
+	rungSize = overflow.size() + 1;
+	start = first;
+	width = ( last - first ) / overflow.size();
+	if( !( width > 0 ) )
+	    width = 1;
+	cur = 0;
+
+	if( buckets.size() < rungSize )
+	    buckets.resize( rungSize );
+
+	for( i = 0; i < overflow.size(); i++ )
+	    {
+	    size_t b = (size_t) ( ( overflow[i].time - start ) / width );
+
+	    buckets[b < rungSize ? b : rungSize - 1].push_back( overflow[i] );
+	    }
+
+	overflow.clear();
+}
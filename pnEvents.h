@@ -0,0 +1,108 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Event List Header File
+*
+*  A PnEventList holds the scheduled firings of a PnEngine, earliest
+*  first, with ties broken by transition index.  It is either a
+*  binary heap, which costs log(n) per firing, or a ladder queue
+*  tuned for many firings due at close or equal times, as with the
+*  integer delays of the default distribution, which costs O(1)
+*  amortised per firing.  The kind is chosen at run time; both give
+*  the same firings in the same order.
+*
+*  The ladder queue keeps three tiers:
+*
+*  - the bottom, a small heap holding the firings due before the
+*    bucket being consumed ends;
+*  - a rung of buckets of equal width, unsorted, covering the times
+*    between the bottom and the last firing seen when the rung was
+*    built;
+*  - the top, an unsorted list of the firings due after the rung.
+*
+*  When the bottom empties the next bucket becomes the bottom, and
+*  when the rung is used up it is rebuilt from the top with one
+*  bucket per firing across the span of their times.  A firing is
+*  thus moved a bounded number of times and only compared to the
+*  few firings of its own bucket.
+*
+*******************************************************************/
+
+#ifndef __PNEVENTS_H
+#define __PNEVENTS_H
+
+#include <vector>
+#include <string>
+#include <algorithm>	// push_heap(), pop_heap()
+
+using namespace std;
+
+// Scheduled firing.  An entry is stale when its stamp no longer
+// matches the stamp of its transition.  The order is reversed, as
+// priority_queue wants it: a < b when a fires after b.
+struct PnEvent
+    {
+    double time;
+    unsigned int trans;
+    unsigned int stamp;
+
+    bool operator<( const PnEvent &e ) const
+	{return time > e.time || ( time == e.time && trans > e.trans );}
+    };
+
+enum PnEventListKind
+    {
+    PN_LIST_HEAP,
+    PN_LIST_LADDER
+    };
+
+// Reads "heap" or "ladder".  Returns false for any other name.
+bool pnEventListParse( const string &name, PnEventListKind &kind );
+
+// PnEventList class
+
+class PnEventList
+{
+public:
+	PnEventList( PnEventListKind kind = PN_LIST_HEAP );
+
+	PnEventListKind kind() const
+		{return listKind;}
+
+	bool empty() const
+		{return count == 0;}
+
+	size_t size() const
+		{return count;}
+
+	// Earliest firing.  Only valid if empty() is false.
+	const PnEvent &top() const
+		{return listKind == PN_LIST_HEAP ? heap.front() : bottom.front();}
+
+	void push( const PnEvent &ev );
+	void pop();
+	void clear();
+
+private:
+	void refill();
+	void rungBuild();
+
+	PnEventListKind listKind;
+	size_t count;
+
+	// Heap
+	vector<PnEvent> heap;
+
+	// Ladder queue: bucket i of the rung holds the times t with
+	// i <= (t - start) / width < i + 1, the bottom the times below
+	// cur
+	vector<PnEvent> bottom;
+	vector<vector<PnEvent> > buckets;
+	vector<PnEvent> overflow;	// the top tier
+	double start;
+	double width;
+	size_t rungSize;
+	size_t cur;			// next bucket to consume
+
+};	// class PnEventList
+
+#endif   //__PNEVENTS_H
@@ -0,0 +1,90 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Token Message Header File
+*
+*  Places and transitions exchange messages made of two fields:
+*  the ID of a place and a number of tokens.  The value of a CD++
+*  message is a double, whose mantissa represents every integer
+*  up to 2^53 exactly, so both fields are packed in it as integers:
+*
+*      value = placeId * 2^32 + tokens
+*
+*  The token count uses the low 32 bits and the place ID the 21
+*  bits above.  A full 32 bit place ID with a 64 bit token count
+*  would need 96 bits, more than one message value holds; the
+*  fields are sized to the 53 bits a double holds exactly, and a
+*  count or ID which does not fit is reported, never truncated.
+*  A CD++ built with a float Value, 24 exact bits, would corrupt
+*  the IDs: the header does not compile with it.  Decoding is one conversion to a 64 bit integer
+*  followed by a shift and a mask; there is no floating point
+*  division and no cap on the token count other than the width of
+*  the field.  A place ID of zero denotes a message which is not
+*  aimed at a specific place (token deposits).
+*
+*******************************************************************/
+
+#ifndef __PNMSG_H
+#define __PNMSG_H
+
+#include <stdio.h>	// sprintf()
+#include <limits>	// numeric_limits
+#include "message.h"	// Value
+#include "pnNetDef.h"	// PnTokens
+
+// Decoded token message
+struct PnTokenMsg
+    {
+    unsigned int placeId;
+    PnTokens tokens;
+    };
+
+// Width of the fields of a message
+const int PN_MSG_TOKEN_BITS = 32;
+const unsigned int PN_MSG_MAX_PLACE_ID = ( 1U << 21 ) - 1;
+const PnTokens PN_MSG_MAX_TOKENS = ( (PnTokens) 1 << PN_MSG_TOKEN_BITS ) - 1;
+
+// The message value must hold the 53 bits of both fields exactly.
+// The size of the array is negative, which does not compile, when
+// it does not.
+typedef char PnMsgValueCheck[ numeric_limits<Value>::digits >= 53 ? 1 : -1 ];
+
+// ** inline ** //
+
+// Returns true if the fields fit in a message
+inline
+bool pnMsgFits( unsigned int placeId, PnTokens tokens )
+{
+	return placeId <= PN_MSG_MAX_PLACE_ID && tokens >= 0 &&
+	       tokens <= PN_MSG_MAX_TOKENS;
+}
+
+inline
+double pnMsgEncode( unsigned int placeId, PnTokens tokens )
+{
+	return (double) ( ( (PnTokens) placeId << PN_MSG_TOKEN_BITS ) | tokens );
+}
+
+inline
+PnTokenMsg pnMsgDecode( double value )
+{
+	PnTokens raw = (PnTokens) value;
+	PnTokenMsg msg;
+
+	msg.placeId = (unsigned int) ( raw >> PN_MSG_TOKEN_BITS );
+	msg.tokens = raw & PN_MSG_MAX_TOKENS;
+
+	return msg;
+}
+
+// Formats a token count for error messages
+inline
+string pnTokensStr( PnTokens tokens )
+{
+	char buf[32];
+
+	sprintf( buf, "%lld", tokens );
+
+	return string( buf );
+}
+
+#endif   //__PNMSG_H
@@ -0,0 +1,492 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net DEVS Atomic Model
+*
+*  This is the implementation of an atomic model which simulates
+*  a whole Petri Net by itself.  Instead of one PnPlace and one
+*  PnTrans model per place and transition exchanging messages,
+*  the net is compiled into sparse incidence matrices (see
+*  pnNetDef.h) and the transitions are fired internally by a
+*  PnEngine.  A firing costs one internal event and no message.
+*
+*  The net is read from the file given by the "netfile" parameter.
+*  It is an ordinary Petri Net .ma file so the nets written for
+*  PnPlace and PnTrans can be used as they are, or an HPSIM .hpx
+*  file which is then loaded without being converted to a .ma, or
+*  the .pni image of either written by pncompile, which loads
+*  without being parsed:
+*
+*  [top]
+*  components : net@pnNet
+*
+*  [net]
+*  netfile : pipeline.ma
+*
+*  [net]
+*  netfile : scheduling.hpx
+*
+*  [net]
+*  netfile : pipeline.pni
+*
+*  A net file may repeat another net file many times with pnSubnet
+*  components (see pnNetDef.cpp).
+*
+*  The delays of the transitions come from their "delay" parameters
+*  in the net file.  The "seed" parameter of the PnNet model selects
+*  the sequence of delays; without it the real time clock is used.
+*  Transitions with a zero delay are immediate: the engine fires
+*  them within the internal event of the firing which enabled them,
+*  by order of their "priority" parameters and drawn according to
+*  their "weight" parameters (see pnEngine.h).
+*
+*  The "eventlist" parameter selects the event list of the engine:
+*  "heap" (the default) or "ladder", a ladder queue which keeps the
+*  cost of a firing constant when many transitions are scheduled
+*  (see pnEvents.h).  The results are the same.
+*
+*  When the P-invariants of the net prove it 1-safe, which they do
+*  for mutual_exclusion.ma, the engine keeps the marking as a bitset
+*  and checks the transitions with mask operations (see pnEngine.h).
+*
+*  When the "stopwhendead" parameter is set to a non zero value the
+*  engine watches the minimal siphons of the net (see pnStruct.h)
+*  and the model passivates as soon as an empty siphon has killed
+*  every transition with an input arc, instead of letting source
+*  transitions fire until the end of the simulation.
+*
+*  When the "file" parameter of the [pntrace] section is set, the
+*  firings and the changes of the marking are recorded in that
+*  binary trace file (see pnTrace.h), numbering the places and
+*  transitions in the order of the net file.  When the "file"
+*  parameter of the [pnstats] section is set, the tokens of the
+*  places and the firings of the transitions are measured as the
+*  simulation runs and written to that file (see pnStats.h).
+*
+*  When the "save" and "at" parameters of the [pncheckpoint] section
+*  are set, the state of the net at time "at" is written to the
+*  file "save" as soon as the firing following that time is known,
+*  and when the "load" parameter is set the simulation starts from
+*  the state saved in that file instead of the initial marking (see
+*  pnCheckpoint.h).  The times of a run started from a checkpoint
+*  count from the checkpoint.
+*
+*  The model has one output port:
+*
+*  <fired>: When the "logfirings" parameter is set to a non zero
+*  value, the index (starting at 1) of every transition which
+*  fires is sent on this port.  Nothing is sent otherwise.  The
+*  immediate transitions are reported together by an extra internal
+*  event at the same time, since they are only known once the
+*  firing enabling them is done.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNet.h"  	// class PnNet
+#include "message.h"    // class ExternalMessage, InternalMessage
+#include "mainsimu.h"   // MainSimulator::Instance().getParameter()
+#include "strutil.h"   	// str2Int()
+#include "except.h"  	// for exception
+#include "pnTrace.h"  	// pnTraceFromParameters()
+#include "pnStats.h"  	// pnStatsFromParameters()
+#include "pnStruct.h"  	// pnSiphons(), pnNetSafe()
+#include "pnCheckpoint.h"  	// pnCheckpointRead(), pnCheckpointWrite()
+#include <stdlib.h>  	// strtoull(), atof()
+#include <C:\cygwin\usr\include\time.h>	// time()
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: delayTime
+* Description: Builds the Time from one time of the engine to a
+* later one.  Both are rounded to the millisecond, so the rounding
+* errors do not add up over the run, and no float is involved,
+* which would lose the milliseconds of long runs.
+********************************************************************/
+static Time delayTime( double from, double to )
+{
+	long long msecs = (long long) ( to * 1000 + 0.5 ) -
+			  (long long) ( from * 1000 + 0.5 );
+
+	return Time( (int) ( msecs / 3600000 ), (int) ( msecs / 60000 % 60 ),
+		     (int) ( msecs / 1000 % 60 ), (int) ( msecs % 1000 ) );
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnNet constructor
+* Description: This routine constructs the PnNet model.  The net
+* file named by the "netfile" parameter is loaded and compiled
+* here so errors in the net are reported before the simulation
+* starts.
+********************************************************************/
+PnNet::PnNet( const string &name )
+: Atomic( name )
+, fired( addOutputPort( "fired" ) )
+{
+	if( !MainSimulator::Instance().existsParameter( description(),
+	    "netfile" ))
+	   {
+	   MException e( string("The netfile parameter of ") + \
+	       description() + " is missing" );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	try
+	   {
+	   pnNetLoad( MainSimulator::Instance().getParameter \
+	    ( description(), "netfile" ), net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	if( MainSimulator::Instance().existsParameter( description(),
+	    "logfirings" ))
+	   logFirings = str2Int( MainSimulator::Instance().getParameter \
+	    ( description(), "logfirings" ) ) != 0;
+	else
+	   logFirings = false;
+
+	if( MainSimulator::Instance().existsParameter( description(),
+	    "seed" ))
+	   seed = strtoull( MainSimulator::Instance().getParameter \
+	    ( description(), "seed" ).c_str(), NULL, 10 );
+	else
+	   seed = (unsigned long long) time( NULL );
+
+	trace = NULL;
+	stats = NULL;
+
+	try
+	   {
+	   trace = pnTraceFromParameters();
+	   stats = pnStatsFromParameters();
+
+	   restore = MainSimulator::Instance().existsParameter( "pncheckpoint", "load" );
+
+	   if( restore )
+	      pnCheckpointRead( MainSimulator::Instance().getParameter \
+	       ( "pncheckpoint", "load" ), net, start );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	saved = false;
+	saveAt = 0;
+
+	if( MainSimulator::Instance().existsParameter( "pncheckpoint", "save" ))
+	   {
+	   if( !MainSimulator::Instance().existsParameter( "pncheckpoint", "at" ))
+	      {
+	      MException e( "The at parameter of the pncheckpoint section is missing" );
+	      e.addLocation( MEXCEPTION_LOCATION() );
+	      throw e;
+	      }
+
+	   saveName = MainSimulator::Instance().getParameter( "pncheckpoint", "save" );
+	   saveAt = atof( MainSimulator::Instance().getParameter \
+	    ( "pncheckpoint", "at" ).c_str() );
+	   }
+
+	PnEventListKind list = PN_LIST_HEAP;
+
+	if( MainSimulator::Instance().existsParameter( description(),
+	    "eventlist" ) &&
+	    !pnEventListParse( MainSimulator::Instance().getParameter \
+	    ( description(), "eventlist" ), list ))
+	   {
+	   MException e( string("The eventlist parameter of ") + \
+	       description() + " must be heap or ladder" );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	// A net the P-invariants prove 1-safe is fired on bitsets
+	pEngine = new PnEngine( net, pnNetSafe( net ), list );
+
+	if( MainSimulator::Instance().existsParameter( description(),
+	    "stopwhendead" ))
+	   stopWhenDead = str2Int( MainSimulator::Instance().getParameter \
+	    ( description(), "stopwhendead" ) ) != 0;
+	else
+	   stopWhenDead = false;
+
+	if( stopWhenDead )
+	   {
+	   // The siphons found are siphons even if the search was cut
+	   // short, so an incomplete list only delays the detection
+	   vector<PnPlaceSet> siphons;
+
+	   pnSiphons( net, siphons );
+	   pEngine->siphonsSet( siphons );
+	   }
+}
+
+/*******************************************************************
+* Function Name: PnNet destructor
+********************************************************************/
+PnNet::~PnNet()
+{
+	delete pEngine;
+}
+
+/*******************************************************************
+* Function Name: initFunction
+* Description: Sets the initial marking, or the state of the
+* checkpoint, and schedules the first firing.  The names and the
+* marking go to the trace.
+********************************************************************/
+Model &PnNet::initFunction()
+{
+	const vector<PnTokens> &marking = restore ? start.marking : net.initMarking;
+
+	try
+	   {
+	   if( restore )
+	      pEngine->stateSet( start, 0, seed );
+	   else
+	      pEngine->reset( 0, seed );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	if( trace != NULL )
+	    {
+	    unsigned int i;
+
+	    for( i = 0; i < net.places(); i++ )
+		{
+		trace->name( PN_TRACE_PLACE, i, net.placeName[i] );
+		if( marking[i] != 0 )
+		    trace->change( 0, PN_TRACE_NONE, i, marking[i] );
+		}
+
+	    for( i = 0; i < net.transitions(); i++ )
+		trace->name( PN_TRACE_TRANS, i, net.transName[i] );
+	    }
+
+	// The places start with their initial marking; the immediate
+	// firings of time 0 change it below
+	if( stats != NULL )
+	    {
+	    unsigned int i, id;
+
+	    for( i = 0; i < net.places(); i++ )
+		{
+		id = stats->add( PN_STATS_PLACE, net.placeName[i], marking[i] );
+		if( i == 0 )
+		    statsPlace = id;
+		}
+
+	    for( i = 0; i < net.transitions(); i++ )
+		{
+		id = stats->add( PN_STATS_TRANS, net.transName[i] );
+		if( i == 0 )
+		    statsTrans = id;
+		}
+	    }
+
+	// The immediate firings of the initial marking were not
+	// reported
+	reports.clear();
+	firingsDone( 0 );
+
+	return *this ;
+}
+
+/*******************************************************************
+* Function Name: externalFunction
+* Description: The model has no input port.
+********************************************************************/
+Model &PnNet::externalFunction( const ExternalMessage & )
+{
+	return *this;
+}
+
+/*******************************************************************
+* Function Name: internalFunction
+* Description: Fires the transition at the head of the event list
+* of the engine, with the immediate transitions it enables, and
+* schedules the next firing.  The engine updates the marking and
+* the enablement of the affected transitions.  The event which only
+* reported immediate firings fires nothing.
+********************************************************************/
+Model &PnNet::internalFunction( const InternalMessage & )
+{
+	if( !reports.empty() )
+	    {
+	    reports.clear();
+	    nextFiringSchedule();
+	    return *this;
+	    }
+
+	try
+	   {
+	   pEngine->fire();
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	// The scheduled transition was reported before it fired
+	firingsDone( 1 );
+
+	return *this;
+}
+
+/*******************************************************************
+* Function Name: outputFunction
+* Description: Reports the transition about to fire, or the
+* immediate firings not reported yet, if requested.
+********************************************************************/
+Model &PnNet::outputFunction( const InternalMessage &msg )
+{
+	if( !logFirings )
+	    return *this;
+
+	if( !reports.empty() )
+	    for( unsigned int i = 0; i < reports.size(); i++ )
+		sendOutput( msg.time(), fired, reports[i] + 1 );
+	else
+	    sendOutput( msg.time(), fired, pEngine->nextTransition() + 1 );
+
+	return *this ;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: nextFiringSchedule
+* Description: Holds the model until the next firing, or passivates
+* it when no transition is enabled anymore: the net is dead.  With
+* stopwhendead set it also passivates when only source transitions
+* are left alive.  A checkpoint is written as soon as the state of
+* its time is known.
+********************************************************************/
+void PnNet::nextFiringSchedule()
+{
+	if( !saveName.empty() && !saved &&
+	    ( !pEngine->pending() || pEngine->nextTime() > saveAt ||
+	      ( stopWhenDead && pEngine->dead() ) ) )
+	    checkpointWrite();
+
+	if( pEngine->pending() && !( stopWhenDead && pEngine->dead() ) )
+	    holdIn( active, delayTime( pEngine->now(), pEngine->nextTime() ) );
+	else
+	    passivate();
+}
+
+/*******************************************************************
+* Function Name: checkpointWrite
+* Description: Writes the state of the net at the time of the
+* checkpoint.  A net stopped by stopwhendead before that time is
+* saved as it stopped.
+********************************************************************/
+void PnNet::checkpointWrite()
+{
+	double time = saveAt;
+
+	if( pEngine->pending() && pEngine->nextTime() <= saveAt )
+	    time = pEngine->now();
+
+	try
+	   {
+	   pnCheckpointWrite( saveName, *pEngine, time );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	saved = true;
+}
+
+/*******************************************************************
+* Function Name: firingsDone
+* Description: Traces the firings of the last step of the engine
+* and schedules the next event.  The firings from <unreported> on
+* were not reported before they happened: they are reported at
+* once by an event at the same time.
+********************************************************************/
+void PnNet::firingsDone( unsigned int unreported )
+{
+	const vector<unsigned int> &list = pEngine->lastFired();
+	unsigned int i;
+
+	if( trace != NULL )
+	    for( i = 0; i < list.size(); i++ )
+		firingTrace( list[i] );
+
+	if( stats != NULL )
+	    for( i = 0; i < list.size(); i++ )
+		firingCount( list[i] );
+
+	if( logFirings && list.size() > unreported )
+	    {
+	    reports.assign( list.begin() + unreported, list.end() );
+	    holdIn( active, Time::Zero );
+	    }
+	else
+	    nextFiringSchedule();
+}
+
+/*******************************************************************
+* Function Name: firingTrace
+* Description: Records a firing and the changes of the marking it
+* made: one change per input and output arc.
+********************************************************************/
+void PnNet::firingTrace( unsigned int trans )
+{
+	double time = pEngine->now();
+	unsigned int a;
+
+	trace->firing( time, trans );
+
+	for( a = net.preStart[trans]; a < net.preStart[trans + 1]; a++ )
+	    if( net.preWeight[a] != 0 )
+		trace->change( time, trans, net.prePlace[a], -(long long) net.preWeight[a] );
+
+	for( a = net.postStart[trans]; a < net.postStart[trans + 1]; a++ )
+	    trace->change( time, trans, net.postPlace[a], net.postWeight[a] );
+}
+
+/*******************************************************************
+* Function Name: firingCount
+* Description: Counts a firing in the statistics and records the
+* new counts of the places it took tokens from or put tokens in.
+********************************************************************/
+void PnNet::firingCount( unsigned int trans )
+{
+	double time = pEngine->now();
+	unsigned int a;
+
+	stats->firing( statsTrans + trans, time );
+
+	for( a = net.preStart[trans]; a < net.preStart[trans + 1]; a++ )
+	    if( net.preWeight[a] != 0 )
+		stats->level( statsPlace + net.prePlace[a], time,
+			      pEngine->tokens( net.prePlace[a] ) );
+
+	for( a = net.postStart[trans]; a < net.postStart[trans + 1]; a++ )
+	    stats->level( statsPlace + net.postPlace[a], time,
+			  pEngine->tokens( net.postPlace[a] ) );
+}
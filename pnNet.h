@@ -0,0 +1,87 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net DEVS Atomic Model Header File
+*
+*******************************************************************/
+
+#ifndef __PNNET_H
+#define __PNNET_H
+
+#include "atomic.h"     // class Atomic
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEngine.h"	// class PnEngine
+#include "pnTrace.h"	// class PnTrace
+#include "pnStats.h"	// class PnStats
+#include "pnCheckpoint.h"	// struct PnEngineState
+
+// PnNet class
+
+class PnNet : public Atomic
+{
+public:
+	// Constructor
+	PnNet( const string &name = "PnNet" );
+
+	// Destructor
+	~PnNet();
+
+	virtual string className() const ;
+protected:
+	Model &initFunction();
+	Model &externalFunction( const ExternalMessage & );
+	Model &internalFunction( const InternalMessage & );
+	Model &outputFunction( const InternalMessage & );
+
+private:
+
+	// Output port
+	Port &fired;
+
+	// The compiled net and the engine firing it
+	PnNetDef net;
+	PnEngine * pEngine;
+
+	// Send a message on <fired> for every firing, and the
+	// immediate firings not reported yet
+	bool logFirings;
+	vector<unsigned int> reports;
+
+	// Seed of the firing delays
+	unsigned long long seed;
+
+	// Passivate once every transition with an input arc is dead
+	bool stopWhenDead;
+
+	// Binary trace of the firings, NULL if none
+	PnTrace *trace;
+
+	// Statistics of the places and transitions, NULL if none,
+	// and the numbers of the first place and transition in them
+	PnStats *stats;
+	unsigned int statsPlace;
+	unsigned int statsTrans;
+
+	// Checkpoint to write once the state of time saveAt is
+	// reached, empty if none, and the state to start from
+	string saveName;
+	double saveAt;
+	bool saved;
+	bool restore;
+	PnEngineState start;
+
+	void nextFiringSchedule();
+	void checkpointWrite();
+	void firingsDone( unsigned int unreported );
+	void firingTrace( unsigned int trans );
+	void firingCount( unsigned int trans );
+
+};	// class PnNet
+
+// ** inline ** //
+inline
+string PnNet::className() const
+{
+	return "PnNet" ;
+}
+
+#endif   //__PNNET_H
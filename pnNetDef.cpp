@@ -0,0 +1,615 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Definition
+*
+*  This file implements the loader which compiles a CD++ model
+*  definition file (.ma) describing a Petri Net into a PnNetDef.
+*  The file must define a flat net in its [top] section using
+*  pnPlace and pnTrans components linked the usual way:
+*
+*  Link : out@P	inK@T	input arc of weight K from P to T (K = 0
+*				is an inhibitor arc)
+*  Link : outK@T	in@P	output arc of weight K from T to P
+*  Link : fired@T	in@P	token removal link, implied by the
+*				input arc hence ignored
+*
+*  The initial marking comes from the "tokens" parameter of the
+*  place sections and the delay distributions from the "delay"
+*  parameter of the transition sections (see pnRandom.h).  The
+*  "priority" and "weight" parameters of an immediate transition
+*  settle its conflicts with the other immediate transitions.
+*
+*  A pnSubnet component stands for <replicas> copies of the net of
+*  another file, for the nets repeating the same pattern many
+*  times.  Its section gives the file, the number of copies and the
+*  places of the subnet which are not copied but shared with the
+*  including net, where they are the places of the same name:
+*
+*  [top]
+*  components : Bus@pnPlace cpu@pnSubnet
+*
+*  [cpu]
+*  netfile : processor.ma
+*  replicas : 4096
+*  shared : Bus
+*
+*  The copies are numbered from 0 and their places and transitions
+*  named after the component, as in cpu[12].Idle.  The copies of a
+*  place are given consecutive indexes, and so are the copies of a
+*  transition, so the tokens of a place of all the copies lie side
+*  by side in the marking of an engine: the copies cost the memory
+*  of their arcs and tokens and nothing else.  A subnet may itself
+*  hold subnets.  Only PnNet and the tools read pnSubnet components;
+*  the CD++ simulator does not know them.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include <fstream>	// ifstream
+#include <sstream>	// istringstream
+#include <map>
+#include <ctype.h>	// tolower(), isdigit()
+#include <stdlib.h>	// atoi(), atof()
+#include <stdio.h>	// sprintf()
+
+/** private data **/
+
+// Arcs of a net being loaded, as (transition, place, weight)
+// triplets
+struct PnArcList
+    {
+    vector<unsigned int> inTrans, inPlace, inWeight;
+    vector<unsigned int> outTrans, outPlace, outWeight;
+    };
+
+// Depth of the subnets being loaded, and its limit, which stops a
+// file including itself
+static unsigned int subnetDepth = 0;
+static const unsigned int SUBNET_DEPTH_LIMIT = 16;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: lowerCase
+* Description: Returns a lower case copy of a string.  Model names
+* are not case sensitive in CD++.
+********************************************************************/
+static string lowerCase( const string &str )
+{
+	string result( str );
+
+	for( unsigned int i = 0; i < result.size(); i++ )
+	    result[i] = tolower( result[i] );
+
+	return result;
+}
+
+/*******************************************************************
+* Function Name: trim
+* Description: Returns a copy of a string without leading and
+* trailing blanks.
+********************************************************************/
+static string trim( const string &str )
+{
+	string::size_type first = str.find_first_not_of( " \t\r\n" );
+
+	if( first == string::npos )
+	    return string();
+
+	string::size_type last = str.find_last_not_of( " \t\r\n" );
+
+	return str.substr( first, last - first + 1 );
+}
+
+/*******************************************************************
+* Function Name: nameIndex
+* Description: Linear search of a name in a list of names, not
+* case sensitive.
+********************************************************************/
+static int nameIndex( const vector<string> &names, const string &name )
+{
+	string key( lowerCase( name ) );
+
+	for( unsigned int i = 0; i < names.size(); i++ )
+	    if( lowerCase( names[i] ) == key )
+		return i;
+
+	return -1;
+}
+
+/*******************************************************************
+* Function Name: portWeight
+* Description: Returns the weight encoded in a port name such as
+* "in3" or "out2".  The prefix is the name of the port without
+* the weight.  Returns -1 if the port does not match the prefix.
+********************************************************************/
+static int portWeight( const string &port, const string &prefix )
+{
+	if( port.compare( 0, prefix.size(), prefix ) != 0 ||
+	    port.size() == prefix.size() )
+	    return -1;
+
+	for( unsigned int i = prefix.size(); i < port.size(); i++ )
+	    if( !isdigit( port[i] ) )
+		return -1;
+
+	return atoi( port.c_str() + prefix.size() );
+}
+
+/*******************************************************************
+* Function Name: lookup
+* Description: Returns the index stored in a name index, -1 if the
+* name is unknown.
+********************************************************************/
+static int lookup( const map<string, int> &ids, const string &name )
+{
+	map<string, int>::const_iterator it = ids.find( lowerCase( name ) );
+
+	return it == ids.end() ? -1 : it->second;
+}
+
+/*******************************************************************
+* Function Name: pathNear
+* Description: Returns the path of a file named in another file: a
+* relative path is taken from the directory of the other file.
+********************************************************************/
+static string pathNear( const string &fileName, const string &from )
+{
+	string::size_type slash = from.find_last_of( "/\\" );
+
+	if( slash == string::npos || fileName.empty() || fileName[0] == '/' ||
+	    fileName[0] == '\\' || fileName.find( ':' ) != string::npos )
+	    return fileName;
+
+	return from.substr( 0, slash + 1 ) + fileName;
+}
+
+/*******************************************************************
+* Function Name: subnetExpand
+* Description: Adds the copies of a subnet to a net.  The places of
+* the subnet which are not shared are numbered place after place,
+* each one followed by its copies, then the transitions likewise;
+* the arcs of every copy are the arcs of the subnet with the places
+* and transitions renumbered.  A shared place which the net lacks
+* is added once, with the tokens it has in the subnet.
+********************************************************************/
+static void subnetExpand( PnNetDef &net, map<string, int> &placeIds,
+			  const string &name, const PnNetDef &sub,
+			  unsigned int count, const vector<string> &shared,
+			  PnArcList &arcs )
+{
+	vector<unsigned int> placeBase( sub.places() );
+	vector<bool> isShared( sub.places(), false );
+	unsigned int p, t, r, a, i;
+	char copy[16];
+
+	for( i = 0; i < shared.size(); i++ )
+	    {
+	    int s = sub.placeIndex( shared[i] );
+
+	    if( s < 0 )
+		throw PnNetError( "Subnet " + name + " has no place " + shared[i] + " to share" );
+
+	    isShared[s] = true;
+
+	    int id = lookup( placeIds, shared[i] );
+
+	    if( id < 0 )
+		{
+		id = net.places();
+		net.placeName.push_back( sub.placeName[s] );
+		net.initMarking.push_back( sub.initMarking[s] );
+		placeIds[lowerCase( sub.placeName[s] )] = id;
+		}
+
+	    placeBase[s] = id;
+	    }
+
+	for( p = 0; p < sub.places(); p++ )
+	    {
+	    if( isShared[p] )
+		continue;
+
+	    placeBase[p] = net.places();
+	    for( r = 0; r < count; r++ )
+		{
+		sprintf( copy, "[%u].", r );
+		net.placeName.push_back( name + copy + sub.placeName[p] );
+		net.initMarking.push_back( sub.initMarking[p] );
+		}
+	    }
+
+	unsigned int transBase = net.transitions();
+
+	for( t = 0; t < sub.transitions(); t++ )
+	    for( r = 0; r < count; r++ )
+		{
+		sprintf( copy, "[%u].", r );
+		net.transName.push_back( name + copy + sub.transName[t] );
+		net.transDelay.push_back( sub.transDelay[t] );
+		net.transPriority.push_back( sub.transPriority[t] );
+		net.transWeight.push_back( sub.transWeight[t] );
+		}
+
+	// The arcs of the copies of a transition follow one another,
+	// so the rows of the copies do too
+	for( t = 0; t < sub.transitions(); t++ )
+	    for( r = 0; r < count; r++ )
+		{
+		unsigned int id = transBase + t * count + r;
+
+		for( a = sub.preStart[t]; a < sub.preStart[t + 1]; a++ )
+		    {
+		    p = sub.prePlace[a];
+		    arcs.inTrans.push_back( id );
+		    arcs.inPlace.push_back( placeBase[p] + ( isShared[p] ? 0 : r ) );
+		    arcs.inWeight.push_back( sub.preWeight[a] );
+		    }
+
+		for( a = sub.postStart[t]; a < sub.postStart[t + 1]; a++ )
+		    {
+		    p = sub.postPlace[a];
+		    arcs.outTrans.push_back( id );
+		    arcs.outPlace.push_back( placeBase[p] + ( isShared[p] ? 0 : r ) );
+		    arcs.outWeight.push_back( sub.postWeight[a] );
+		    }
+		}
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: placeIndex, transIndex
+* Description: Name lookups.
+********************************************************************/
+int PnNetDef::placeIndex( const string &name ) const
+{
+	return nameIndex( placeName, name );
+}
+
+int PnNetDef::transIndex( const string &name ) const
+{
+	return nameIndex( transName, name );
+}
+
+/*******************************************************************
+* Function Name: pnNetBuild
+* Description: Builds the CSR arrays of the net from lists of arcs.
+* The rows are filled with a counting sort so the order of the
+* arcs of a transition is the order in which they were declared.
+********************************************************************/
+void pnNetBuild( PnNetDef &net,
+		 const vector<unsigned int> &inTrans,
+		 const vector<unsigned int> &inPlace,
+		 const vector<unsigned int> &inWeight,
+		 const vector<unsigned int> &outTrans,
+		 const vector<unsigned int> &outPlace,
+		 const vector<unsigned int> &outWeight )
+{
+	unsigned int trans = net.transitions();
+	unsigned int places = net.places();
+	unsigned int i;
+
+	net.transDelay.resize( trans, pnDelayDefault() );
+	net.transPriority.resize( trans, 1 );
+	net.transWeight.resize( trans, 1 );
+
+	// Input arcs
+	net.preStart.assign( trans + 1, 0 );
+	for( i = 0; i < inTrans.size(); i++ )
+	    ++net.preStart[inTrans[i] + 1];
+	for( i = 0; i < trans; i++ )
+	    net.preStart[i + 1] += net.preStart[i];
+
+	vector<unsigned int> fill( net.preStart.begin(), net.preStart.end() - 1 );
+	net.prePlace.resize( inTrans.size() );
+	net.preWeight.resize( inTrans.size() );
+	for( i = 0; i < inTrans.size(); i++ )
+	    {
+	    unsigned int slot = fill[inTrans[i]]++;
+	    net.prePlace[slot] = inPlace[i];
+	    net.preWeight[slot] = inWeight[i];
+	    }
+
+	// Output arcs
+	net.postStart.assign( trans + 1, 0 );
+	for( i = 0; i < outTrans.size(); i++ )
+	    ++net.postStart[outTrans[i] + 1];
+	for( i = 0; i < trans; i++ )
+	    net.postStart[i + 1] += net.postStart[i];
+
+	fill.assign( net.postStart.begin(), net.postStart.end() - 1 );
+	net.postPlace.resize( outTrans.size() );
+	net.postWeight.resize( outTrans.size() );
+	for( i = 0; i < outTrans.size(); i++ )
+	    {
+	    unsigned int slot = fill[outTrans[i]]++;
+	    net.postPlace[slot] = outPlace[i];
+	    net.postWeight[slot] = outWeight[i];
+	    }
+
+	// Consumers of every place.  A transition appears only
+	// once in the row of a place even if it has several arcs
+	// from that place.
+	vector<unsigned int> consPlace, consTr;
+	for( unsigned int t = 0; t < trans; t++ )
+	    for( i = net.preStart[t]; i < net.preStart[t + 1]; i++ )
+		{
+		bool dup = false;
+		for( unsigned int j = net.preStart[t]; j < i; j++ )
+		    dup = dup || net.prePlace[j] == net.prePlace[i];
+		if( !dup )
+		    {
+		    consPlace.push_back( net.prePlace[i] );
+		    consTr.push_back( t );
+		    }
+		}
+
+	net.consStart.assign( places + 1, 0 );
+	for( i = 0; i < consPlace.size(); i++ )
+	    ++net.consStart[consPlace[i] + 1];
+	for( i = 0; i < places; i++ )
+	    net.consStart[i + 1] += net.consStart[i];
+
+	fill.assign( net.consStart.begin(), net.consStart.end() - 1 );
+	net.consTrans.resize( consPlace.size() );
+	for( i = 0; i < consPlace.size(); i++ )
+	    net.consTrans[fill[consPlace[i]]++] = consTr[i];
+}
+
+/*******************************************************************
+* Function Name: pnNetLoad
+* Description: Chooses the loader from the extension of the file.
+********************************************************************/
+void pnNetLoad( const string &fileName, PnNetDef &net )
+{
+	string::size_type dot = fileName.rfind( '.' );
+
+	string ext( dot != string::npos ? lowerCase( fileName.substr( dot ) ) : "" );
+
+	if( ext == ".hpx" )
+	    pnNetLoadHpx( fileName, net );
+	else if( ext == ".pni" )
+	    pnNetLoadImage( fileName, net );
+	else
+	    pnNetLoadMa( fileName, net );
+}
+
+/*******************************************************************
+* Function Name: pnNetLoadMa
+* Description: Parses a .ma file and compiles the Petri Net it
+* defines.  Lines are either section headers ("[name]") or
+* "key : value" pairs, and '%' starts a comment.  Throws a
+* PnNetError if the file cannot be read or does not describe a
+* flat Petri Net.
+********************************************************************/
+void pnNetLoadMa( const string &fileName, PnNetDef &net )
+{
+	ifstream file( fileName.c_str() );
+
+	if( !file )
+	    throw PnNetError( "Cannot open net file " + fileName );
+
+	typedef map<string, string> Params;
+	map<string, Params> sections;
+	vector<string> links;
+	vector<string> subnets;
+	string section;
+	string line;
+
+	net = PnNetDef();
+
+	while( getline( file, line ) )
+	    {
+	    string::size_type pos = line.find( '%' );
+
+	    if( pos != string::npos )
+		line.erase( pos );
+
+	    line = trim( line );
+
+	    if( line.empty() )
+		continue;
+
+	    if( line[0] == '[' )
+		{
+		section = lowerCase( trim( line.substr( 1, line.find( ']' ) - 1 ) ) );
+		continue;
+		}
+
+	    pos = line.find( ':' );
+	    if( pos == string::npos )
+		throw PnNetError( fileName + ": invalid line \"" + line + "\"" );
+
+	    string key( lowerCase( trim( line.substr( 0, pos ) ) ) );
+	    string value( trim( line.substr( pos + 1 ) ) );
+
+	    if( section != "top" )
+		{
+		sections[section][key] = value;
+		continue;
+		}
+
+	    if( key == "components" )
+		{
+		istringstream comps( value );
+		string comp;
+
+		while( comps >> comp )
+		    {
+		    pos = comp.find( '@' );
+
+		    if( pos == string::npos )
+			throw PnNetError( fileName + ": invalid component " + comp );
+
+		    string type( lowerCase( comp.substr( pos + 1 ) ) );
+
+		    if( type == "pnplace" )
+			net.placeName.push_back( comp.substr( 0, pos ) );
+		    else if( type == "pntrans" )
+			net.transName.push_back( comp.substr( 0, pos ) );
+		    else if( type == "pnsubnet" )
+			subnets.push_back( comp.substr( 0, pos ) );
+		    else
+			throw PnNetError( fileName + ": component " + comp +
+					  " is not a place or a transition" );
+		    }
+		}
+	    else if( key == "link" )
+		links.push_back( value );
+
+	    // The "in" and "out" ports of the top model are of no
+	    // interest to a closed net.
+	    }
+
+	// Index the names so links resolve quickly on large nets
+	map<string, int> placeIds, transIds;
+	unsigned int i;
+
+	for( i = 0; i < net.places(); i++ )
+	    placeIds[lowerCase( net.placeName[i] )] = i;
+	for( i = 0; i < net.transitions(); i++ )
+	    transIds[lowerCase( net.transName[i] )] = i;
+
+	// Resolve the links into arcs
+	PnArcList arcs;
+
+	for( i = 0; i < links.size(); i++ )
+	    {
+	    istringstream ends( links[i] );
+	    string src, dst;
+
+	    ends >> src >> dst;
+
+	    string::size_type srcAt = src.find( '@' );
+	    string::size_type dstAt = dst.find( '@' );
+
+	    if( srcAt == string::npos || dstAt == string::npos )
+		throw PnNetError( fileName + ": link \"" + links[i] +
+				  "\" does not connect two components" );
+
+	    string srcPort( lowerCase( src.substr( 0, srcAt ) ) );
+	    string dstPort( lowerCase( dst.substr( 0, dstAt ) ) );
+	    int srcPlace = lookup( placeIds, src.substr( srcAt + 1 ) );
+	    int srcTrans = lookup( transIds, src.substr( srcAt + 1 ) );
+	    int dstPlace = lookup( placeIds, dst.substr( dstAt + 1 ) );
+	    int dstTrans = lookup( transIds, dst.substr( dstAt + 1 ) );
+	    int weight;
+
+	    if( srcPlace >= 0 && dstTrans >= 0 && srcPort == "out" &&
+		(weight = portWeight( dstPort, "in" )) >= 0 )
+		{
+		arcs.inTrans.push_back( dstTrans );
+		arcs.inPlace.push_back( srcPlace );
+		arcs.inWeight.push_back( weight );
+		}
+	    else if( srcTrans >= 0 && dstPlace >= 0 && dstPort == "in" &&
+		     (weight = portWeight( srcPort, "out" )) > 0 )
+		{
+		arcs.outTrans.push_back( srcTrans );
+		arcs.outPlace.push_back( dstPlace );
+		arcs.outWeight.push_back( weight );
+		}
+	    else if( !( srcTrans >= 0 && dstPlace >= 0 &&
+			srcPort == "fired" && dstPort == "in" ) )
+		throw PnNetError( fileName + ": link \"" + links[i] +
+				  "\" is not a Petri Net arc" );
+	    }
+
+	// Initial marking
+	net.initMarking.assign( net.places(), 0 );
+	for( unsigned int p = 0; p < net.places(); p++ )
+	    {
+	    map<string, Params>::const_iterator sect;
+
+	    sect = sections.find( lowerCase( net.placeName[p] ) );
+	    if( sect != sections.end() && sect->second.count( "tokens" ) )
+		net.initMarking[p] = atoll( sect->second.find( "tokens" )->second.c_str() );
+	    }
+
+	// Delay distributions, priorities and weights
+	net.transDelay.assign( net.transitions(), pnDelayDefault() );
+	net.transPriority.assign( net.transitions(), 1 );
+	net.transWeight.assign( net.transitions(), 1 );
+	for( unsigned int t = 0; t < net.transitions(); t++ )
+	    {
+	    map<string, Params>::const_iterator sect;
+
+	    sect = sections.find( lowerCase( net.transName[t] ) );
+	    if( sect == sections.end() )
+		continue;
+
+	    if( sect->second.count( "delay" ) &&
+		!pnDelayParse( sect->second.find( "delay" )->second, net.transDelay[t] ) )
+		throw PnNetError( fileName + ": invalid delay \"" +
+				  sect->second.find( "delay" )->second +
+				  "\" for transition " + net.transName[t] );
+
+	    if( sect->second.count( "priority" ) )
+		net.transPriority[t] = atoi( sect->second.find( "priority" )->second.c_str() );
+
+	    if( sect->second.count( "weight" ) )
+		{
+		net.transWeight[t] = atof( sect->second.find( "weight" )->second.c_str() );
+		if( !( net.transWeight[t] > 0 ) )
+		    throw PnNetError( fileName + ": invalid weight \"" +
+				      sect->second.find( "weight" )->second +
+				      "\" for transition " + net.transName[t] );
+		}
+	    }
+
+	// Copies of the subnets, after the places and transitions
+	// of this file
+	for( i = 0; i < subnets.size(); i++ )
+	    {
+	    map<string, Params>::const_iterator sect = sections.find( lowerCase( subnets[i] ) );
+
+	    if( sect == sections.end() || !sect->second.count( "netfile" ) )
+		throw PnNetError( fileName + ": the netfile parameter of subnet " +
+				  subnets[i] + " is missing" );
+
+	    int count = 1;
+	    vector<string> shared;
+
+	    if( sect->second.count( "replicas" ) )
+		count = atoi( sect->second.find( "replicas" )->second.c_str() );
+
+	    if( count < 1 )
+		throw PnNetError( fileName + ": invalid replicas \"" +
+				  sect->second.find( "replicas" )->second +
+				  "\" for subnet " + subnets[i] );
+
+	    if( sect->second.count( "shared" ) )
+		{
+		istringstream names( sect->second.find( "shared" )->second );
+		string name;
+
+		while( names >> name )
+		    shared.push_back( name );
+		}
+
+	    if( subnetDepth == SUBNET_DEPTH_LIMIT )
+		throw PnNetError( fileName + ": subnet " + subnets[i] +
+				  " is nested too deep, does it include itself?" );
+
+	    PnNetDef sub;
+
+	    subnetDepth++;
+	    try
+	       {
+	       pnNetLoad( pathNear( sect->second.find( "netfile" )->second, fileName ), sub );
+	       }
+	    catch( PnNetError & )
+	       {
+	       subnetDepth--;
+	       throw;
+	       }
+	    subnetDepth--;
+
+	    subnetExpand( net, placeIds, subnets[i], sub, count, shared, arcs );
+	    }
+
+	pnNetBuild( net, arcs.inTrans, arcs.inPlace, arcs.inWeight,
+		    arcs.outTrans, arcs.outPlace, arcs.outWeight );
+}
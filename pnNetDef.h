@@ -0,0 +1,129 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Definition Header File
+*
+*  A PnNetDef holds a complete Petri Net in compiled form: the
+*  place and transition names, the initial marking and the arcs.
+*  The arcs are stored as sparse pre and post incidence matrices
+*  in compressed row (CSR) form, one row per transition, so that
+*  the input arcs of transition t are the entries
+*  preStart[t] .. preStart[t+1]-1 of prePlace/preWeight.  A weight
+*  of zero on an input arc denotes an inhibitor arc.  The consumers
+*  of each place (the transitions having an input or inhibitor arc
+*  from it) are stored the same way, one row per place.
+*
+*  The definition does not depend on the CD++ kernel so it can be
+*  shared by the PnNet atomic model and by stand alone tools.
+*
+*******************************************************************/
+
+#ifndef __PNNETDEF_H
+#define __PNNETDEF_H
+
+#include <string>
+#include <vector>
+#include "pnRandom.h"	// PnDelay
+
+using namespace std;
+
+// Type used to count tokens in a place
+typedef long long PnTokens;
+
+// Error raised while loading or building a net
+class PnNetError
+{
+public:
+	PnNetError( const string &msg ) : text( msg ) {}
+
+	const string &message() const
+		{return text;}
+
+private:
+	string text;
+
+};	// class PnNetError
+
+// PnNetDef class
+
+class PnNetDef
+{
+public:
+	// Places
+	vector<string> placeName;
+	vector<PnTokens> initMarking;
+
+	// Transitions and the distribution of their firing delays.
+	// When several immediate transitions are enabled, the ones
+	// with the highest priority fire first and a conflict between
+	// them is resolved at random in proportion to their weights.
+	vector<string> transName;
+	vector<PnDelay> transDelay;
+	vector<int> transPriority;
+	vector<double> transWeight;
+
+	// Input arcs (pre incidence matrix), one row per transition
+	vector<unsigned int> preStart;
+	vector<unsigned int> prePlace;
+	vector<unsigned int> preWeight;
+
+	// Output arcs (post incidence matrix), one row per transition
+	vector<unsigned int> postStart;
+	vector<unsigned int> postPlace;
+	vector<unsigned int> postWeight;
+
+	// Consumer transitions, one row per place
+	vector<unsigned int> consStart;
+	vector<unsigned int> consTrans;
+
+	unsigned int places() const
+		{return placeName.size();}
+
+	unsigned int transitions() const
+		{return transName.size();}
+
+	// Returns true if the transition has no firing delay
+	bool immediate( unsigned int trans ) const
+		{return pnDelayZero( transDelay[trans] );}
+
+	// Returns the index of a place or transition, -1 if unknown.
+	// The lookup is not case sensitive.
+	int placeIndex( const string &name ) const;
+	int transIndex( const string &name ) const;
+
+};	// class PnNetDef
+
+// Loads a net from a CD++ model definition file (.ma) made of
+// pnPlace and pnTrans components, and pnSubnet components repeating
+// the net of another file (see pnNetDef.cpp).
+void pnNetLoadMa( const string &fileName, PnNetDef &net );
+
+// Loads a net from an HPSIM model definition file (.hpx)
+void pnNetLoadHpx( const string &fileName, PnNetDef &net );
+
+// Loads a net from an image written by pnNetWriteImage (.pni), in
+// the time it takes to map it and copy its arrays
+void pnNetLoadImage( const string &fileName, PnNetDef &net );
+
+// Writes the image of a net, which pnNetLoadImage() reads back as
+// it is.  Throws a PnNetError if it cannot be written.
+void pnNetWriteImage( const string &fileName, const PnNetDef &net );
+
+// Loads a net with the loader matching the extension of the file:
+// .hpx files with pnNetLoadHpx(), .pni files with pnNetLoadImage(),
+// any other file with pnNetLoadMa().
+void pnNetLoad( const string &fileName, PnNetDef &net );
+
+// Helper used by the loaders: builds the CSR arrays of the net
+// from arc lists.  The input arcs are given as (transition, place,
+// weight) triplets, weight 0 meaning inhibitor.  Transitions
+// without a delay distribution get the default one, with a
+// priority of 1 and a weight of 1.
+void pnNetBuild( PnNetDef &net,
+		 const vector<unsigned int> &inTrans,
+		 const vector<unsigned int> &inPlace,
+		 const vector<unsigned int> &inWeight,
+		 const vector<unsigned int> &outTrans,
+		 const vector<unsigned int> &outPlace,
+		 const vector<unsigned int> &outWeight );
+
+#endif   //__PNNETDEF_H
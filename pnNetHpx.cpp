@@ -0,0 +1,315 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net HPSIM Loader
+*
+*  This file implements the loader which compiles an HPSIM model
+*  definition file (.hpx), as exported by HPSIM with
+*  File->Export->File, directly into a PnNetDef.  It reads the same
+*  objects as hpx2ma.tcl without going through a .ma file:
+*
+*  CHPosition	a place, TOKENS_START being its initial marking
+*  CHTransition	a transition, with its firing delay
+*  CHConnector	an arc from SOURCE_ID to TARGET_ID of weight
+*		ARC_WEIGHT, an inhibitor arc if ARC_TYP is 1
+*  CHLabel	the name (SUB_IDENT 0) of the place or transition
+*		OWNER_IDENT
+*
+*  The firing delays are given in milliseconds with a time mode:
+*  0 immediate, 1 fixed delay, 2 exponential and 3 equal
+*  distribution over FIRE_DELAY .. FIRE_DELAY + FIRE_DELAY_RANGE.
+*  As with hpx2ma.tcl the transitions of time mode 0 are immediate
+*  (see pnEngine.h), whatever their FIRE_DELAY, unless no transition
+*  of the net is timed.  Such an untimed HPSIM net keeps the default
+*  delay: being immediate its transitions would fire forever.
+*
+*  The whole file is read in one block and parsed in place.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include <stdio.h>	// fopen(), fread()
+#include <stdlib.h>	// strtol(), strtoll()
+#include <string.h>	// strncmp(), memchr()
+#include <map>
+
+/** private data **/
+
+// Attributes of an object of the file which are used
+struct HpxObject
+    {
+    string runtimeClass;
+    long id;		// POSITION_ID, TRANSITION_ID or ARC_ID
+    long long tokens;
+    long arcType;
+    long arcWeight;
+    long source;
+    long target;
+    long owner;
+    long subId;
+    long timeMode;
+    double fireDelay;
+    double fireRange;
+    string text;
+    };
+
+// Place or transition known by its HPSIM ID
+struct HpxNode
+    {
+    bool isPlace;
+    unsigned int index;
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: objectClear
+* Description: Resets the attributes of an object.
+********************************************************************/
+static void objectClear( HpxObject &obj )
+{
+	obj.runtimeClass.clear();
+	obj.id = -1;
+	obj.tokens = 0;
+	obj.arcType = 0;
+	obj.arcWeight = 1;
+	obj.source = -1;
+	obj.target = -1;
+	obj.owner = -1;
+	obj.subId = -1;
+	obj.timeMode = 0;
+	obj.fireDelay = 0;
+	obj.fireRange = 0;
+	obj.text.clear();
+}
+
+/*******************************************************************
+* Function Name: attributeSet
+* Description: Stores an attribute "KEY=value" in an object.  The
+* key and value are given by pointers in the file buffer.
+********************************************************************/
+static void attributeSet( HpxObject &obj, const char *key, size_t keyLen,
+			  const char *value, size_t valueLen )
+{
+	string text( value, valueLen );
+	const char *val = text.c_str();
+
+#define HPX_KEY( name ) ( keyLen == sizeof( name ) - 1 && \
+			  strncmp( key, name, keyLen ) == 0 )
+
+	if( HPX_KEY( "RUNTIME_CLASS" ) )
+	    obj.runtimeClass = text;
+	else if( HPX_KEY( "POSITION_ID" ) || HPX_KEY( "TRANSITION_ID" ) ||
+		 HPX_KEY( "ARC_ID" ) )
+	    obj.id = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "TOKENS_START" ) )
+	    obj.tokens = strtoll( val, NULL, 10 );
+	else if( HPX_KEY( "ARC_TYP" ) )
+	    obj.arcType = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "ARC_WEIGHT" ) )
+	    obj.arcWeight = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "SOURCE_ID" ) )
+	    obj.source = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "TARGET_ID" ) )
+	    obj.target = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "OWNER_IDENT" ) )
+	    obj.owner = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "SUB_IDENT" ) )
+	    obj.subId = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "TRANSITION_TIME_MODE" ) )
+	    obj.timeMode = strtol( val, NULL, 10 );
+	else if( HPX_KEY( "FIRE_DELAY" ) )
+	    obj.fireDelay = strtod( val, NULL );
+	else if( HPX_KEY( "FIRE_DELAY_RANGE" ) )
+	    obj.fireRange = strtod( val, NULL );
+	else if( HPX_KEY( "TEXT" ) )
+	    obj.text = text;
+
+#undef HPX_KEY
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnNetLoadHpx
+* Description: Parses a .hpx file and compiles the Petri Net it
+* defines.  The places and transitions are numbered in the order
+* they appear in the file, as in the .ma written by hpx2ma.tcl.
+* Throws a PnNetError if the file cannot be read or an arc does
+* not connect a place and a transition.
+********************************************************************/
+void pnNetLoadHpx( const string &fileName, PnNetDef &net )
+{
+	FILE *file = fopen( fileName.c_str(), "rb" );
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot open net file " + fileName );
+
+	string buffer;
+	char block[1 << 16];
+	size_t got;
+
+	while( ( got = fread( block, 1, sizeof( block ), file ) ) > 0 )
+	    buffer.append( block, got );
+	fclose( file );
+
+	net = PnNetDef();
+
+	map<long, HpxNode> nodes;
+	vector<HpxObject> arcs;
+	vector<HpxObject> labels;
+	HpxObject obj;
+	bool inObject = false;
+	bool timed = false;	// a transition has a time mode other than 0
+	const char *pos = buffer.data();
+	const char *end = pos + buffer.size();
+
+	objectClear( obj );
+
+	// One more pass at the end of the buffer to store the last
+	// object
+	for( ;; )
+	    {
+	    const char *eol = pos < end ? (const char *) memchr( pos, '\n', end - pos ) : NULL;
+	    const char *lineEnd = eol != NULL ? eol : end;
+	    bool last = pos >= end;
+
+	    while( lineEnd > pos && ( lineEnd[-1] == '\r' || lineEnd[-1] == ' ' ) )
+		lineEnd--;
+
+	    if( last || *pos == '[' )
+		{
+		// End of the previous object
+		if( inObject )
+		    {
+		    HpxNode node;
+
+		    if( obj.runtimeClass == "CHPosition" )
+			{
+			node.isPlace = true;
+			node.index = net.places();
+			nodes[obj.id] = node;
+			net.placeName.push_back( "" );
+			net.initMarking.push_back( obj.tokens );
+			}
+		    else if( obj.runtimeClass == "CHTransition" )
+			{
+			PnDelay delay = pnDelayDefault();
+
+			if( obj.timeMode == 0 )
+			    {
+			    delay.mode = PN_DELAY_DETERMINISTIC;
+			    delay.a = delay.b = 0;
+			    }
+			else
+			    timed = true;
+
+			if( obj.timeMode == 1 )
+			    {
+			    delay.mode = PN_DELAY_DETERMINISTIC;
+			    delay.a = delay.b = obj.fireDelay / 1000;
+			    }
+			else if( obj.timeMode == 2 )
+			    {
+			    delay.mode = PN_DELAY_EXPONENTIAL;
+			    delay.a = obj.fireDelay / 1000;
+			    delay.b = 0;
+			    }
+			else if( obj.timeMode == 3 )
+			    {
+			    delay.mode = PN_DELAY_UNIFORM;
+			    delay.a = obj.fireDelay / 1000;
+			    delay.b = ( obj.fireDelay + obj.fireRange ) / 1000;
+			    }
+
+			node.isPlace = false;
+			node.index = net.transitions();
+			nodes[obj.id] = node;
+			net.transName.push_back( "" );
+			net.transDelay.push_back( delay );
+			}
+		    else if( obj.runtimeClass == "CHConnector" )
+			arcs.push_back( obj );
+		    else if( obj.runtimeClass == "CHLabel" && obj.subId == 0 )
+			labels.push_back( obj );
+		    }
+
+		if( last )
+		    break;
+
+		inObject = strncmp( pos, "[OBJECT", 7 ) == 0;
+		objectClear( obj );
+		}
+	    else if( inObject )
+		{
+		const char *equal = (const char *) memchr( pos, '=', lineEnd - pos );
+
+		if( equal != NULL )
+		    attributeSet( obj, pos, equal - pos, equal + 1, lineEnd - equal - 1 );
+		}
+
+	    pos = eol != NULL ? eol + 1 : end;
+	    }
+
+	unsigned int i;
+
+	if( !timed )
+	    for( i = 0; i < net.transitions(); i++ )
+		net.transDelay[i] = pnDelayDefault();
+
+	// Names.  A place or transition without a label is named
+	// after its ID.
+
+	for( i = 0; i < labels.size(); i++ )
+	    {
+	    map<long, HpxNode>::const_iterator n = nodes.find( labels[i].owner );
+
+	    if( n != nodes.end() )
+		( n->second.isPlace ? net.placeName : net.transName )[n->second.index] = labels[i].text;
+	    }
+
+	for( map<long, HpxNode>::const_iterator n = nodes.begin(); n != nodes.end(); n++ )
+	    {
+	    string &name = ( n->second.isPlace ? net.placeName : net.transName )[n->second.index];
+	    char id[32];
+
+	    if( name.empty() )
+		{
+		sprintf( id, "%s%ld", n->second.isPlace ? "P" : "T", n->first );
+		name = id;
+		}
+	    }
+
+	// Arcs
+	vector<unsigned int> inTrans, inPlace, inWeight;
+	vector<unsigned int> outTrans, outPlace, outWeight;
+
+	for( i = 0; i < arcs.size(); i++ )
+	    {
+	    map<long, HpxNode>::const_iterator src = nodes.find( arcs[i].source );
+	    map<long, HpxNode>::const_iterator dst = nodes.find( arcs[i].target );
+	    char id[32];
+
+	    sprintf( id, "%ld", arcs[i].id );
+
+	    if( src == nodes.end() || dst == nodes.end() ||
+		src->second.isPlace == dst->second.isPlace || arcs[i].arcWeight < 0 )
+		throw PnNetError( fileName + ": arc " + id +
+				  " does not connect a place and a transition" );
+
+	    if( src->second.isPlace )
+		{
+		inTrans.push_back( dst->second.index );
+		inPlace.push_back( src->second.index );
+		inWeight.push_back( arcs[i].arcType == 1 ? 0 : arcs[i].arcWeight );
+		}
+	    else
+		{
+		outTrans.push_back( src->second.index );
+		outPlace.push_back( dst->second.index );
+		outWeight.push_back( arcs[i].arcWeight );
+		}
+	    }
+
+	pnNetBuild( net, inTrans, inPlace, inWeight, outTrans, outPlace, outWeight );
+}
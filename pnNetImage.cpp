@@ -0,0 +1,400 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Image Loader
+*
+*  This file implements the precompiled images of nets (.pni files)
+*  written by pncompile.  An image holds a PnNetDef as it is in
+*  memory, so loading it parses nothing: the file is mapped and its
+*  arrays copied into the net in blocks.  The file is made of:
+*
+*  - a header (PnImageHeader, 88 bytes);
+*  - the sections, each one starting on an 8 byte boundary at the
+*    offset given by the header: the initial marking (int64_t per
+*    place), the delays (PnImageDelay per transition), the
+*    priorities (int32_t) and weights (double) of the transitions,
+*    the pre, post and consumer CSR arrays (uint32_t each, as in
+*    pnNetDef.h), then the names: the offsets of the name of every
+*    place and transition in the name text, one more than their
+*    number, and the text of the names put end to end.
+*
+*  Sections are found by their offsets only, so an image can be
+*  copied anywhere.  Numbers are written in the byte order of the
+*  machine; the header records the order and the version of the
+*  format, and an image of another order or version is refused:
+*  compile the net again.  The arrays are checked before they are
+*  copied so a damaged image is an error, not a crash.
+*
+*  The pages of the file are shared by every process loading the
+*  same image.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include <stdio.h>	// fopen()
+#include <string.h>	// memcmp(), memcpy()
+#include <stdint.h>	// uint32_t, ...
+#include <sys/mman.h>	// mmap()
+#include <sys/stat.h>	// fstat()
+#include <fcntl.h>	// open()
+#include <unistd.h>	// close()
+
+/** private data **/
+
+#define PN_IMAGE_MAGIC		"PNIMAGE"
+#define PN_IMAGE_VERSION	1
+#define PN_IMAGE_ORDER		0x01020304
+
+// Sections of an image
+enum PnImageSection
+    {
+    PN_IMAGE_MARKING,
+    PN_IMAGE_DELAY,
+    PN_IMAGE_PRIORITY,
+    PN_IMAGE_WEIGHT,
+    PN_IMAGE_PRE_START,
+    PN_IMAGE_PRE_PLACE,
+    PN_IMAGE_PRE_WEIGHT,
+    PN_IMAGE_POST_START,
+    PN_IMAGE_POST_PLACE,
+    PN_IMAGE_POST_WEIGHT,
+    PN_IMAGE_CONS_START,
+    PN_IMAGE_CONS_TRANS,
+    PN_IMAGE_NAME_START,
+    PN_IMAGE_NAME_TEXT,
+    PN_IMAGE_SECTIONS
+    };
+
+struct PnImageHeader
+    {
+    char magic[8];		// PN_IMAGE_MAGIC
+    uint32_t version;		// PN_IMAGE_VERSION
+    uint32_t order;		// PN_IMAGE_ORDER
+    uint32_t places;
+    uint32_t transitions;
+    uint32_t sections;		// PN_IMAGE_SECTIONS
+    uint32_t unused;
+    uint32_t offset[PN_IMAGE_SECTIONS];	// from the start of the file
+    };
+
+// Delay distribution of a transition
+struct PnImageDelay
+    {
+    uint32_t mode;		// PnDelayMode
+    uint32_t unused;
+    double a;
+    double b;
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: sectionAdd
+* Description: Appends a section to an image being written.
+********************************************************************/
+static void sectionAdd( string &image, PnImageHeader &header, PnImageSection section,
+			const void *from, size_t size )
+{
+	image.resize( ( image.size() + 7 ) & ~(size_t) 7, '\0' );
+	header.offset[section] = image.size();
+	image.append( (const char *) from, size );
+}
+
+/*******************************************************************
+* Function Name: arrayOf
+* Description: Returns the address of the first element of a vector,
+* NULL for an empty vector, which has none.
+********************************************************************/
+template <class T>
+static const void *arrayOf( const vector<T> &list )
+{
+	return list.empty() ? NULL : &list[0];
+}
+
+// PnImageMap class: an image mapped in memory, unmapped when it is
+// destroyed
+
+class PnImageMap
+{
+public:
+	PnImageMap( const string &fileName );
+	~PnImageMap();
+
+	// Returns the section holding <count> items of type T.  Throws
+	// a PnNetError if it does not lie within the file.
+	template <class T>
+	const T *section( PnImageSection which, size_t count ) const
+		{
+		size_t at = header->offset[which];
+
+		if( at % 8 != 0 || at > size || ( size - at ) / sizeof( T ) < count )
+		    throw PnNetError( name + " is damaged" );
+
+		return (const T *) ( base + at );
+		}
+
+	const PnImageHeader *header;
+
+private:
+	string name;
+	const char *base;
+	size_t size;
+
+};	// class PnImageMap
+
+/*******************************************************************
+* Function Name: PnImageMap constructor
+* Description: Maps the file and checks its header.
+********************************************************************/
+PnImageMap::PnImageMap( const string &fileName )
+: header( NULL )
+, name( fileName )
+, base( NULL )
+, size( 0 )
+{
+	struct stat info;
+	int fd = open( fileName.c_str(), O_RDONLY );
+
+	if( fd < 0 || fstat( fd, &info ) != 0 )
+	    {
+	    if( fd >= 0 )
+		close( fd );
+	    throw PnNetError( "Cannot open the net image " + fileName );
+	    }
+
+	size = info.st_size;
+	if( size < sizeof( PnImageHeader ) )
+	    {
+	    close( fd );
+	    throw PnNetError( fileName + " is not a net image" );
+	    }
+
+	void *mapped = mmap( NULL, size, PROT_READ, MAP_SHARED, fd, 0 );
+
+	close( fd );
+	if( mapped == MAP_FAILED )
+	    throw PnNetError( "Cannot map the net image " + fileName );
+
+	base = (const char *) mapped;
+	header = (const PnImageHeader *) base;
+
+	if( memcmp( header->magic, PN_IMAGE_MAGIC, sizeof( PN_IMAGE_MAGIC ) ) != 0 )
+	    {
+	    munmap( mapped, size );
+	    throw PnNetError( fileName + " is not a net image" );
+	    }
+
+	if( header->version != PN_IMAGE_VERSION || header->order != PN_IMAGE_ORDER ||
+	    header->sections != PN_IMAGE_SECTIONS )
+	    {
+	    munmap( mapped, size );
+	    throw PnNetError( fileName + " was compiled for another version or "
+			      "machine, compile it again" );
+	    }
+
+	// Every place and transition takes more than a byte
+	if( header->places > size || header->transitions > size )
+	    {
+	    munmap( mapped, size );
+	    throw PnNetError( fileName + " is damaged" );
+	    }
+}
+
+/*******************************************************************
+* Function Name: PnImageMap destructor
+********************************************************************/
+PnImageMap::~PnImageMap()
+{
+	munmap( (void *) base, size );
+}
+
+/*******************************************************************
+* Function Name: rowsCheck
+* Description: Checks a CSR array of <rows> rows starting at 0 and
+* increasing, and returns the number of entries.  Throws a
+* PnNetError if it does not.
+********************************************************************/
+static unsigned int rowsCheck( const uint32_t *start, unsigned int rows,
+			       const string &fileName )
+{
+	if( start[0] != 0 )
+	    throw PnNetError( fileName + " is damaged" );
+
+	for( unsigned int r = 0; r < rows; r++ )
+	    if( start[r + 1] < start[r] )
+		throw PnNetError( fileName + " is damaged" );
+
+	return start[rows];
+}
+
+/*******************************************************************
+* Function Name: indexCheck
+* Description: Checks that every entry of an array is below <limit>.
+********************************************************************/
+static void indexCheck( const uint32_t *list, unsigned int count, unsigned int limit,
+			const string &fileName )
+{
+	for( unsigned int i = 0; i < count; i++ )
+	    if( list[i] >= limit )
+		throw PnNetError( fileName + " is damaged" );
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnNetWriteImage
+* Description: The image is built in memory and written at once.
+********************************************************************/
+void pnNetWriteImage( const string &fileName, const PnNetDef &net )
+{
+	PnImageHeader header;
+	string image( sizeof( PnImageHeader ), '\0' );
+	unsigned int places = net.places(), trans = net.transitions(), i;
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PN_IMAGE_MAGIC, sizeof( PN_IMAGE_MAGIC ) );
+	header.version = PN_IMAGE_VERSION;
+	header.order = PN_IMAGE_ORDER;
+	header.places = places;
+	header.transitions = trans;
+	header.sections = PN_IMAGE_SECTIONS;
+
+	vector<int64_t> marking( net.initMarking.begin(), net.initMarking.end() );
+	vector<PnImageDelay> delays( trans );
+	vector<int32_t> priorities( net.transPriority.begin(), net.transPriority.end() );
+
+	for( i = 0; i < trans; i++ )
+	    {
+	    delays[i].mode = net.transDelay[i].mode;
+	    delays[i].unused = 0;
+	    delays[i].a = net.transDelay[i].a;
+	    delays[i].b = net.transDelay[i].b;
+	    }
+
+	// Names of the places then of the transitions
+	vector<uint32_t> nameStart( 1, 0 );
+	string text;
+
+	for( i = 0; i < places; i++ )
+	    {
+	    text += net.placeName[i];
+	    nameStart.push_back( text.size() );
+	    }
+	for( i = 0; i < trans; i++ )
+	    {
+	    text += net.transName[i];
+	    nameStart.push_back( text.size() );
+	    }
+
+	sectionAdd( image, header, PN_IMAGE_MARKING, arrayOf( marking ), places * sizeof( int64_t ) );
+	sectionAdd( image, header, PN_IMAGE_DELAY, arrayOf( delays ), trans * sizeof( PnImageDelay ) );
+	sectionAdd( image, header, PN_IMAGE_PRIORITY, arrayOf( priorities ), trans * sizeof( int32_t ) );
+	sectionAdd( image, header, PN_IMAGE_WEIGHT, arrayOf( net.transWeight ), trans * sizeof( double ) );
+	sectionAdd( image, header, PN_IMAGE_PRE_START, arrayOf( net.preStart ),
+		    net.preStart.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_PRE_PLACE, arrayOf( net.prePlace ),
+		    net.prePlace.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_PRE_WEIGHT, arrayOf( net.preWeight ),
+		    net.preWeight.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_POST_START, arrayOf( net.postStart ),
+		    net.postStart.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_POST_PLACE, arrayOf( net.postPlace ),
+		    net.postPlace.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_POST_WEIGHT, arrayOf( net.postWeight ),
+		    net.postWeight.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_CONS_START, arrayOf( net.consStart ),
+		    net.consStart.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_CONS_TRANS, arrayOf( net.consTrans ),
+		    net.consTrans.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_NAME_START, arrayOf( nameStart ),
+		    nameStart.size() * sizeof( uint32_t ) );
+	sectionAdd( image, header, PN_IMAGE_NAME_TEXT, text.data(), text.size() );
+
+	memcpy( &image[0], &header, sizeof( header ) );
+
+	FILE *file = fopen( fileName.c_str(), "wb" );
+	bool done;
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot create the net image " + fileName );
+
+	done = fwrite( image.data(), image.size(), 1, file ) == 1;
+
+	if( fclose( file ) != 0 || !done )
+	    throw PnNetError( "Cannot write the net image " + fileName );
+}
+
+/*******************************************************************
+* Function Name: pnNetLoadImage
+* Description: Maps the image and copies its sections into the net
+* once they are checked.
+********************************************************************/
+void pnNetLoadImage( const string &fileName, PnNetDef &net )
+{
+	PnImageMap image( fileName );
+	unsigned int places = image.header->places;
+	unsigned int trans = image.header->transitions;
+	unsigned int i, pre, post, cons;
+
+	const uint32_t *preStart = image.section<uint32_t>( PN_IMAGE_PRE_START, trans + 1 );
+	const uint32_t *postStart = image.section<uint32_t>( PN_IMAGE_POST_START, trans + 1 );
+	const uint32_t *consStart = image.section<uint32_t>( PN_IMAGE_CONS_START, places + 1 );
+	const uint32_t *nameStart = image.section<uint32_t>( PN_IMAGE_NAME_START, places + trans + 1 );
+
+	pre = rowsCheck( preStart, trans, fileName );
+	post = rowsCheck( postStart, trans, fileName );
+	cons = rowsCheck( consStart, places, fileName );
+
+	const int64_t *marking = image.section<int64_t>( PN_IMAGE_MARKING, places );
+	const PnImageDelay *delays = image.section<PnImageDelay>( PN_IMAGE_DELAY, trans );
+	const int32_t *priorities = image.section<int32_t>( PN_IMAGE_PRIORITY, trans );
+	const double *weights = image.section<double>( PN_IMAGE_WEIGHT, trans );
+	const uint32_t *prePlace = image.section<uint32_t>( PN_IMAGE_PRE_PLACE, pre );
+	const uint32_t *preWeight = image.section<uint32_t>( PN_IMAGE_PRE_WEIGHT, pre );
+	const uint32_t *postPlace = image.section<uint32_t>( PN_IMAGE_POST_PLACE, post );
+	const uint32_t *postWeight = image.section<uint32_t>( PN_IMAGE_POST_WEIGHT, post );
+	const uint32_t *consTrans = image.section<uint32_t>( PN_IMAGE_CONS_TRANS, cons );
+	const char *text = image.section<char>( PN_IMAGE_NAME_TEXT,
+						rowsCheck( nameStart, places + trans, fileName ) );
+
+	indexCheck( prePlace, pre, places, fileName );
+	indexCheck( postPlace, post, places, fileName );
+	indexCheck( consTrans, cons, trans, fileName );
+
+	for( i = 0; i < trans; i++ )
+	    if( delays[i].mode > PN_DELAY_DISCRETE )
+		throw PnNetError( fileName + " is damaged" );
+
+	net = PnNetDef();
+
+	net.placeName.resize( places );
+	for( i = 0; i < places; i++ )
+	    net.placeName[i].assign( text + nameStart[i], nameStart[i + 1] - nameStart[i] );
+
+	net.transName.resize( trans );
+	for( i = 0; i < trans; i++ )
+	    net.transName[i].assign( text + nameStart[places + i],
+				     nameStart[places + i + 1] - nameStart[places + i] );
+
+	net.initMarking.assign( marking, marking + places );
+
+	net.transDelay.resize( trans );
+	for( i = 0; i < trans; i++ )
+	    {
+	    net.transDelay[i].mode = (PnDelayMode) delays[i].mode;
+	    net.transDelay[i].a = delays[i].a;
+	    net.transDelay[i].b = delays[i].b;
+	    }
+
+	net.transPriority.assign( priorities, priorities + trans );
+	net.transWeight.assign( weights, weights + trans );
+
+	net.preStart.assign( preStart, preStart + trans + 1 );
+	net.prePlace.assign( prePlace, prePlace + pre );
+	net.preWeight.assign( preWeight, preWeight + pre );
+	net.postStart.assign( postStart, postStart + trans + 1 );
+	net.postPlace.assign( postPlace, postPlace + post );
+	net.postWeight.assign( postWeight, postWeight + post );
+	net.consStart.assign( consStart, consStart + places + 1 );
+	net.consTrans.assign( consTrans, consTrans + cons );
+}
@@ -0,0 +1,675 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Parallel Simulation
+*
+*  Every partition is a subnet with its own PnNetDef: its places,
+*  its transitions, their input arcs and the output arcs to its own
+*  places.  The output arcs to other partitions are kept aside and
+*  turned into messages when their transition fires.  The places
+*  and transitions of a subnet keep the order of the whole net, so
+*  the ties in its event list are broken as in the whole net.
+*
+*  The promise of a partition is written with a sequence lock: the
+*  sequence is odd while the key is being written, and a reader
+*  retries until it reads the same even sequence before and after
+*  the key.  A partition pushes its messages before it publishes a
+*  promise, and reads the promises of the others before it pops
+*  their messages, so every message below a promise read is found.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnPart.h"	// class PnParallel
+#include <math.h>	// HUGE_VAL
+#include <thread>	// this_thread::yield()
+
+/** private data **/
+
+// A partition done or failed promises no more messages
+static const PnPartKey NEVER = { HUGE_VAL, ~0U };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: groupFind
+* Description: Returns the root of the group of a transition,
+* halving the path to it.
+********************************************************************/
+static unsigned int groupFind( vector<unsigned int> &parent, unsigned int t )
+{
+	while( parent[t] != t )
+	    {
+	    parent[t] = parent[parent[t]];
+	    t = parent[t];
+	    }
+
+	return t;
+}
+
+/*******************************************************************
+* Function Name: keyMin
+********************************************************************/
+static PnPartKey keyMin( const PnPartKey &a, const PnPartKey &b )
+{
+	return b < a ? b : a;
+}
+
+// Orders a priority queue of messages by increasing key
+struct PnMsgLater
+    {
+    bool operator()( const PnPartMsg &a, const PnPartMsg &b ) const
+	{return b.key < a.key;}
+    };
+
+/*******************************************************************
+* Function Name: PnChannel constructor
+* Description: The capacity is rounded up to a power of two.
+********************************************************************/
+PnChannel::PnChannel( unsigned int capacity )
+: head( 0 )
+, tail( 0 )
+{
+	unsigned int size = 1;
+
+	while( size < capacity )
+	    size *= 2;
+
+	ring.resize( size );
+	mask = size - 1;
+}
+
+/*******************************************************************
+* Function Name: push
+* Description: Called by the producer only.
+********************************************************************/
+bool PnChannel::push( const PnPartMsg &msg )
+{
+	unsigned int t = tail.load( memory_order_relaxed );
+
+	if( t - head.load( memory_order_acquire ) == ring.size() )
+	    return false;
+
+	ring[t & mask] = msg;
+	tail.store( t + 1, memory_order_release );
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: pop
+* Description: Called by the consumer only.
+********************************************************************/
+bool PnChannel::pop( PnPartMsg &msg )
+{
+	unsigned int h = head.load( memory_order_relaxed );
+
+	if( h == tail.load( memory_order_acquire ) )
+	    return false;
+
+	msg = ring[h & mask];
+	head.store( h + 1, memory_order_release );
+
+	return true;
+}
+
+// A partition: its subnet, its arcs to other partitions and the
+// state of its thread
+struct PnParallel::Part
+    {
+    PnNetDef net;
+    vector<unsigned int> placeId;	// index in the whole net
+    vector<unsigned int> transId;
+
+    // Output arcs to other partitions, one row per transition, and
+    // the transitions having some with their smallest delay
+    vector<unsigned int> remoteStart;
+    vector<unsigned int> remotePart;
+    vector<unsigned int> remotePlace;
+    vector<unsigned int> remoteWeight;
+    vector<unsigned int> crossTrans;
+    double lookahead;
+
+    vector<unsigned int> inParts;
+    PnEngine *engine;
+
+    // Published promise
+    atomic<unsigned int> seq;
+    atomic<double> promiseTime;
+    atomic<unsigned int> promiseTrans;
+
+    // Messages received and not fired yet, one list per partition
+    // of the messages not pushed yet
+    priority_queue<PnPartMsg, vector<PnPartMsg>, PnMsgLater> inbox;
+    vector<vector<PnPartMsg> > outbox;
+    unsigned long long sent;
+
+    // Measures
+    vector<double> area;
+    vector<double> since;
+    vector<PnTokens> level;
+    vector<unsigned long> fired;
+    string error;
+    };
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnParallel constructor
+* Description: Partitions the net and builds the subnets, their
+* engines and the channels between them.
+********************************************************************/
+PnParallel::PnParallel( const PnNetDef &net, unsigned int count )
+: def( net )
+, partCount( 0 )
+, cut( 0 )
+, failed( false )
+, warmupTime( 0 )
+, endTime( 0 )
+, runSeed( 0 )
+{
+	vector<unsigned int> transPart, placePart;
+	vector<unsigned int> placeLocal( net.places() ), transLocal( net.transitions() );
+	unsigned int k, t, p, a;
+
+	partition( count == 0 ? 1 : count, transPart, placePart );
+
+	for( k = 0; k < partCount; k++ )
+	    {
+	    Part *part = new Part;
+
+	    part->lookahead = HUGE_VAL;
+	    part->sent = 0;
+	    part->outbox.resize( partCount );
+	    parts.push_back( part );
+	    }
+
+	for( p = 0; p < net.places(); p++ )
+	    {
+	    Part &part = *parts[placePart[p]];
+
+	    placeLocal[p] = part.placeId.size();
+	    part.placeId.push_back( p );
+	    part.net.placeName.push_back( net.placeName[p] );
+	    part.net.initMarking.push_back( net.initMarking[p] );
+	    }
+
+	for( t = 0; t < net.transitions(); t++ )
+	    {
+	    Part &part = *parts[transPart[t]];
+
+	    transLocal[t] = part.transId.size();
+	    part.transId.push_back( t );
+	    part.net.transName.push_back( net.transName[t] );
+	    part.net.transDelay.push_back( net.transDelay[t] );
+	    part.net.transPriority.push_back( net.transPriority[t] );
+	    part.net.transWeight.push_back( net.transWeight[t] );
+	    }
+
+	channels.assign( (size_t) partCount * partCount, (PnChannel *) NULL );
+
+	for( k = 0; k < partCount; k++ )
+	    {
+	    Part &part = *parts[k];
+	    vector<unsigned int> inTrans, inPlace, inWeight, outTrans, outPlace, outWeight;
+
+	    part.remoteStart.assign( 1, 0 );
+
+	    for( unsigned int i = 0; i < part.transId.size(); i++ )
+		{
+		t = part.transId[i];
+
+		// The input places of a transition are in its partition
+		for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		    {
+		    inTrans.push_back( i );
+		    inPlace.push_back( placeLocal[net.prePlace[a]] );
+		    inWeight.push_back( net.preWeight[a] );
+		    }
+
+		for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		    {
+		    unsigned int to = placePart[net.postPlace[a]];
+
+		    if( to == k )
+			{
+			outTrans.push_back( i );
+			outPlace.push_back( placeLocal[net.postPlace[a]] );
+			outWeight.push_back( net.postWeight[a] );
+			continue;
+			}
+
+		    part.remotePart.push_back( to );
+		    part.remotePlace.push_back( placeLocal[net.postPlace[a]] );
+		    part.remoteWeight.push_back( net.postWeight[a] );
+		    cut++;
+
+		    if( channels[k * partCount + to] == NULL )
+			{
+			channels[k * partCount + to] = new PnChannel;
+			parts[to]->inParts.push_back( k );
+			}
+		    }
+
+		if( part.remotePart.size() != part.remoteStart.back() )
+		    {
+		    part.crossTrans.push_back( i );
+		    if( pnDelayMin( net.transDelay[t] ) < part.lookahead )
+			part.lookahead = pnDelayMin( net.transDelay[t] );
+		    }
+
+		part.remoteStart.push_back( part.remotePart.size() );
+		}
+
+	    pnNetBuild( part.net, inTrans, inPlace, inWeight, outTrans, outPlace, outWeight );
+
+	    part.engine = new PnEngine( part.net );
+	    part.engine->streamsSet( part.transId );
+	    }
+}
+
+/*******************************************************************
+* Function Name: PnParallel destructor
+********************************************************************/
+PnParallel::~PnParallel()
+{
+	unsigned int i;
+
+	for( i = 0; i < parts.size(); i++ )
+	    {
+	    delete parts[i]->engine;
+	    delete parts[i];
+	    }
+
+	for( i = 0; i < channels.size(); i++ )
+	    delete channels[i];
+}
+
+/*******************************************************************
+* Function Name: simulate
+* Description: Runs every partition on its own thread.  Nothing is
+* sent before time 0, which is the first promise of a partition.
+********************************************************************/
+void PnParallel::simulate( double warmup, double end, unsigned long long seed )
+{
+	const PnPartKey start = { 0, 0 };
+	unsigned int k;
+
+	warmupTime = warmup;
+	endTime = end;
+	runSeed = seed;
+	failed = false;
+
+	for( k = 0; k < partCount; k++ )
+	    {
+	    parts[k]->seq = 0;
+	    promiseWrite( *parts[k], start );
+	    parts[k]->error.clear();
+	    parts[k]->sent = 0;
+	    }
+
+	placeTokens.assign( def.places(), 0 );
+	transThroughput.assign( def.transitions(), 0 );
+
+	PnPool pool( partCount );
+
+	pool.run( partCount, *this );
+
+	for( k = 0; k < partCount; k++ )
+	    if( !parts[k]->error.empty() )
+		throw PnNetError( parts[k]->error );
+}
+
+/*******************************************************************
+* Function Name: deposits
+********************************************************************/
+unsigned long long PnParallel::deposits() const
+{
+	unsigned long long count = 0;
+
+	for( unsigned int k = 0; k < partCount; k++ )
+	    count += parts[k]->sent;
+
+	return count;
+}
+
+/*******************************************************************
+* Function Name: run
+* Description: Fires the events of a partition, its own firings and
+* the deposits it receives, in key order, as long as their key is
+* below the smallest promise of the partitions sending to it.  The
+* deposits of a firing share its key and are made together.  Then
+* pushes the messages of the firings and publishes a new promise.
+* The partition is done once nothing can happen before the end.
+********************************************************************/
+void PnParallel::run( unsigned int index, unsigned int )
+{
+	Part &part = *parts[index];
+	PnEngine &engine = *part.engine;
+	vector<pair<unsigned int, PnTokens> > batch;
+	PnPartMsg msg;
+	unsigned int i, j, a;
+
+	part.area.assign( part.placeId.size(), 0 );
+	part.since.assign( part.placeId.size(), warmupTime );
+	part.level.assign( part.placeId.size(), 0 );
+	part.fired.assign( part.transId.size(), 0 );
+
+	try
+	   {
+	   engine.reset( 0, runSeed );
+
+	   for( i = 0; i < part.placeId.size(); i++ )
+	       part.level[i] = engine.tokens( i );
+
+	   while( !failed )
+	       {
+	       PnPartKey safe = NEVER, local, next, promise;
+	       bool progress = false, queued = false;
+
+	       for( i = 0; i < part.inParts.size(); i++ )
+		   safe = keyMin( safe, promiseRead( *parts[part.inParts[i]] ) );
+
+	       for( i = 0; i < part.inParts.size(); i++ )
+		   while( channels[part.inParts[i] * partCount + index]->pop( msg ) )
+		       part.inbox.push( msg );
+
+	       for( ;; )
+		   {
+		   local = NEVER;
+		   if( engine.pending() )
+		       {
+		       local.time = engine.nextTime();
+		       local.trans = part.transId[engine.nextTransition()];
+		       }
+
+		   next = part.inbox.empty() ? NEVER : part.inbox.top().key;
+
+		   bool deposit = next < local;
+		   PnPartKey key = deposit ? next : local;
+
+		   if( !( key < safe ) || key.time > endTime )
+		       break;
+
+		   progress = true;
+
+		   if( deposit )
+		       {
+		       batch.clear();
+		       while( !part.inbox.empty() && !( key < part.inbox.top().key ) )
+			   {
+			   batch.push_back( make_pair( part.inbox.top().place, part.inbox.top().tokens ) );
+			   part.inbox.pop();
+			   }
+
+		       engine.deposit( key.time, batch );
+
+		       for( i = 0; i < batch.size(); i++ )
+			   account( part, batch[i].first, key.time );
+		       }
+		   else
+		       engine.fire();
+
+		   const vector<unsigned int> &list = engine.lastFired();
+
+		   for( i = 0; i < list.size(); i++ )
+		       {
+		       unsigned int t = list[i], tg = part.transId[t];
+
+		       if( key.time > warmupTime )
+			   part.fired[t]++;
+
+		       for( a = part.net.preStart[t]; a < part.net.preStart[t + 1]; a++ )
+			   account( part, part.net.prePlace[a], key.time );
+
+		       for( a = part.net.postStart[t]; a < part.net.postStart[t + 1]; a++ )
+			   account( part, part.net.postPlace[a], key.time );
+
+		       for( a = part.remoteStart[t]; a < part.remoteStart[t + 1]; a++ )
+			   {
+			   msg.key.time = key.time;
+			   msg.key.trans = tg;
+			   msg.place = part.remotePlace[a];
+			   msg.tokens = part.remoteWeight[a];
+			   part.outbox[part.remotePart[a]].push_back( msg );
+			   part.sent++;
+			   }
+		       }
+		   }
+
+	       // Push what the rings take; the rest is kept, and
+	       // promised, for the next round
+	       promise = NEVER;
+	       for( j = 0; j < partCount; j++ )
+		   {
+		   vector<PnPartMsg> &out = part.outbox[j];
+
+		   for( i = 0; i < out.size() && channels[index * partCount + j]->push( out[i] ); i++ )
+		       ;
+
+		   out.erase( out.begin(), out.begin() + i );
+		   if( !out.empty() )
+		       {
+		       promise = keyMin( promise, out[0].key );
+		       queued = true;
+		       }
+		   }
+
+	       if( !queued && local.time > endTime && next.time > endTime &&
+		   safe.time > endTime )
+		   break;
+
+	       // A firing not scheduled yet comes after the next event
+	       // plus the lookahead
+	       for( i = 0; i < part.crossTrans.size(); i++ )
+		   {
+		   double due = engine.due( part.crossTrans[i] );
+
+		   if( due >= 0 )
+		       {
+		       PnPartKey k = { due, part.transId[part.crossTrans[i]] };
+		       promise = keyMin( promise, k );
+		       }
+		   }
+
+	       double base = local.time;
+	       if( next.time < base )
+		   base = next.time;
+	       if( safe.time < base )
+		   base = safe.time;
+
+	       PnPartKey ahead = { base + part.lookahead, 0 };
+	       promise = keyMin( promise, ahead );
+
+	       promiseWrite( part, promise );
+
+	       if( !progress )
+		   this_thread::yield();
+	       }
+	   }
+	catch( PnNetError &err )
+	   {
+	   part.error = err.message();
+	   failed = true;
+	   }
+
+	promiseWrite( part, NEVER );
+
+	for( i = 0; i < part.placeId.size(); i++ )
+	    {
+	    account( part, i, endTime );
+	    placeTokens[part.placeId[i]] = part.area[i] / ( endTime - warmupTime );
+	    }
+
+	for( i = 0; i < part.transId.size(); i++ )
+	    transThroughput[part.transId[i]] = part.fired[i] / ( endTime - warmupTime );
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: partition
+* Description: Groups the transitions which must stay together
+* with a union-find, orders the groups breadth first along the arcs
+* and cuts the order in partitions of similar weights, a group
+* weighing one plus the arcs of its transitions.  A place goes to
+* the partition of its consumers, or of its first producer.
+********************************************************************/
+void PnParallel::partition( unsigned int count, vector<unsigned int> &transPart,
+			    vector<unsigned int> &placePart )
+{
+	unsigned int trans = def.transitions(), places = def.places();
+	vector<unsigned int> parent( trans ), producer( places, ~0U );
+	unsigned int t, p, a, c, g;
+
+	for( t = 0; t < trans; t++ )
+	    parent[t] = t;
+
+	for( p = 0; p < places; p++ )
+	    for( c = def.consStart[p] + 1; c < def.consStart[p + 1]; c++ )
+		parent[groupFind( parent, def.consTrans[c] )] =
+		    groupFind( parent, def.consTrans[def.consStart[p]] );
+
+	for( t = 0; t < trans; t++ )
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		{
+		p = def.postPlace[a];
+		if( producer[p] == ~0U )
+		    producer[p] = t;
+
+		if( pnDelayMin( def.transDelay[t] ) > 0 )
+		    continue;
+
+		for( c = def.consStart[p]; c < def.consStart[p + 1]; c++ )
+		    parent[groupFind( parent, def.consTrans[c] )] = groupFind( parent, t );
+		}
+
+	// Weights and neighbours of the groups, numbered by their root
+	vector<double> weight( trans, 0 );
+	vector<vector<unsigned int> > next( trans );
+	double total = 0;
+
+	for( t = 0; t < trans; t++ )
+	    {
+	    g = groupFind( parent, t );
+	    weight[g] += 1 + ( def.preStart[t + 1] - def.preStart[t] ) +
+			 ( def.postStart[t + 1] - def.postStart[t] );
+	    total += 1 + ( def.preStart[t + 1] - def.preStart[t] ) +
+		     ( def.postStart[t + 1] - def.postStart[t] );
+
+	    for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		{
+		p = def.postPlace[a];
+		if( def.consStart[p] == def.consStart[p + 1] )
+		    continue;
+
+		unsigned int h = groupFind( parent, def.consTrans[def.consStart[p]] );
+		if( h != g )
+		    {
+		    next[g].push_back( h );
+		    next[h].push_back( g );
+		    }
+		}
+	    }
+
+	// Breadth first order, cut in partitions
+	vector<unsigned int> groupPart( trans, ~0U ), queue;
+	double sum = 0;
+	unsigned int current = 0;
+
+	for( t = 0; t < trans; t++ )
+	    {
+	    g = groupFind( parent, t );
+	    if( groupPart[g] != ~0U )
+		continue;
+
+	    queue.assign( 1, g );
+	    groupPart[g] = 0;
+
+	    for( unsigned int q = 0; q < queue.size(); q++ )
+		{
+		g = queue[q];
+
+		if( sum >= total * ( current + 1 ) / count && current + 1 < count )
+		    current++;
+		groupPart[g] = current;
+		sum += weight[g];
+
+		for( unsigned int i = 0; i < next[g].size(); i++ )
+		    if( groupPart[next[g][i]] == ~0U )
+			{
+			groupPart[next[g][i]] = 0;
+			queue.push_back( next[g][i] );
+			}
+		}
+	    }
+
+	partCount = trans == 0 ? 1 : current + 1;
+
+	transPart.resize( trans );
+	for( t = 0; t < trans; t++ )
+	    transPart[t] = groupPart[groupFind( parent, t )];
+
+	placePart.resize( places );
+	for( p = 0; p < places; p++ )
+	    if( def.consStart[p] != def.consStart[p + 1] )
+		placePart[p] = transPart[def.consTrans[def.consStart[p]]];
+	    else if( producer[p] != ~0U )
+		placePart[p] = transPart[producer[p]];
+	    else
+		placePart[p] = 0;
+}
+
+/*******************************************************************
+* Function Name: promiseWrite
+* Description: Publishes a promise under the sequence lock.
+********************************************************************/
+void PnParallel::promiseWrite( Part &part, const PnPartKey &key )
+{
+	unsigned int s = part.seq.load( memory_order_relaxed );
+
+	part.seq.store( s + 1, memory_order_relaxed );
+	atomic_thread_fence( memory_order_release );
+	part.promiseTime.store( key.time, memory_order_relaxed );
+	part.promiseTrans.store( key.trans, memory_order_relaxed );
+	part.seq.store( s + 2, memory_order_release );
+}
+
+/*******************************************************************
+* Function Name: promiseRead
+* Description: Reads a promise, retrying while it is being written.
+********************************************************************/
+PnPartKey PnParallel::promiseRead( Part &part )
+{
+	for( ;; )
+	    {
+	    unsigned int s = part.seq.load( memory_order_acquire );
+	    PnPartKey key;
+
+	    if( s & 1 )
+		continue;
+
+	    key.time = part.promiseTime.load( memory_order_relaxed );
+	    key.trans = part.promiseTrans.load( memory_order_relaxed );
+	    atomic_thread_fence( memory_order_acquire );
+
+	    if( part.seq.load( memory_order_relaxed ) == s )
+		return key;
+	    }
+}
+
+/*******************************************************************
+* Function Name: account
+* Description: Brings the area under the tokens of a place up to a
+* time and records its new count.  Nothing is measured before the
+* warm up.
+********************************************************************/
+void PnParallel::account( Part &part, unsigned int place, double time )
+{
+	if( time > part.since[place] )
+	    {
+	    part.area[place] += part.level[place] * ( time - part.since[place] );
+	    part.since[place] = time;
+	    }
+
+	part.level[place] = part.engine->tokens( place );
+}
@@ -0,0 +1,147 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Parallel Simulation Header File
+*
+*  A PnParallel runs one long simulation of a net on several
+*  threads.  The net is split in partitions, each fired by its own
+*  PnEngine on its own thread.
+*
+*  Transitions sharing an input or inhibitor place are in conflict,
+*  so they stay together, with that place: a place belongs to the
+*  partition of its consumers.  Tokens are then only taken from a
+*  place by the partition owning it, and the only thing partitions
+*  exchange is tokens deposited by a transition in a place of
+*  another partition.  A transition which can fire without delay
+*  also stays with the consumers of its output places, so every
+*  transition with an arc to another partition has a minimum delay
+*  above zero.  The groups of transitions formed this way are
+*  ordered breadth first along the arcs and cut into partitions of
+*  similar sizes, so that groups linked by arcs mostly end up in
+*  the same partition.
+*
+*  The synchronisation is conservative.  The events are ordered by
+*  time, then by transition index as in PnEngine, and a partition
+*  only fires an event once no deposit can arrive before it.  Every
+*  partition publishes the smallest event it may still send tokens
+*  from: the earliest firing scheduled among its transitions with
+*  arcs to other partitions, or the time of its next event plus the
+*  smallest delay of those transitions (the lookahead).  The tokens
+*  go through single producer, single consumer rings, one for every
+*  pair of partitions linked by an arc.
+*
+*  The delays are drawn with the index of the transitions in the
+*  whole net: a run gives the same results whatever the number of
+*  partitions, the same as a PnEngine, unless random choices are made
+*  between immediate transitions.
+*
+*******************************************************************/
+
+#ifndef __PNPART_H
+#define __PNPART_H
+
+#include <vector>
+#include <atomic>
+#include <queue>
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEngine.h"	// class PnEngine
+#include "pnPool.h"	// class PnTask
+
+// Event key: time then index of the transition in the whole net
+struct PnPartKey
+    {
+    double time;
+    unsigned int trans;
+
+    bool operator<( const PnPartKey &k ) const
+	{return time < k.time || ( time == k.time && trans < k.trans );}
+    };
+
+// Tokens deposited by a transition in a place of another partition,
+// numbered in that partition
+struct PnPartMsg
+    {
+    PnPartKey key;
+    unsigned int place;
+    PnTokens tokens;
+    };
+
+// Ring of messages from one thread to another
+class PnChannel
+{
+public:
+	PnChannel( unsigned int capacity = 4096 );
+
+	// Return false if the ring is full or empty
+	bool push( const PnPartMsg &msg );
+	bool pop( PnPartMsg &msg );
+
+private:
+	vector<PnPartMsg> ring;
+	unsigned int mask;
+	atomic<unsigned int> head;	// next to pop, moved by the consumer
+	atomic<unsigned int> tail;	// next to push, moved by the producer
+
+};	// class PnChannel
+
+// PnParallel class
+
+class PnParallel : public PnTask
+{
+public:
+	// Constructor.  Splits the net in at most <parts> partitions.
+	// The net must outlive the simulation.
+	PnParallel( const PnNetDef &net, unsigned int parts );
+
+	~PnParallel();
+
+	unsigned int partitions() const
+		{return partCount;}
+
+	// Arcs from a transition to a place of another partition
+	unsigned int cutArcs() const
+		{return cut;}
+
+	// Simulates the net from time 0 to <end>, measuring from
+	// <warmup> on.  Throws a PnNetError if immediate transitions
+	// fire forever.
+	void simulate( double warmup, double end, unsigned long long seed );
+
+	// Time averaged tokens of the places and firings per second of
+	// the transitions
+	const vector<double> &tokens() const
+		{return placeTokens;}
+
+	const vector<double> &throughput() const
+		{return transThroughput;}
+
+	// Deposits sent between partitions
+	unsigned long long deposits() const;
+
+	// Runs a partition
+	void run( unsigned int part, unsigned int worker );
+
+private:
+	struct Part;
+
+	void partition( unsigned int parts, vector<unsigned int> &transPart,
+			vector<unsigned int> &placePart );
+	void promiseWrite( Part &part, const PnPartKey &key );
+	PnPartKey promiseRead( Part &part );
+	void account( Part &part, unsigned int place, double time );
+
+	const PnNetDef &def;
+	unsigned int partCount;
+	unsigned int cut;
+	vector<Part *> parts;
+	vector<PnChannel *> channels;	// from * partCount + to, NULL if no arc
+	atomic<bool> failed;
+	double warmupTime;
+	double endTime;
+	unsigned long long runSeed;
+
+	vector<double> placeTokens;
+	vector<double> transThroughput;
+
+};	// class PnParallel
+
+#endif   //__PNPART_H
@@ -21,6 +21,36 @@
 *  it contains so transitions that are connected to it can determine if
 *  they are enabled.
 *
+*  A transition only needs to know whether the place holds at least 
+*  the weight of its arc (or, for an inhibitor arc, whether the place
+*  is empty).  The place therefore advertises its contents only when
+*  the count crosses one of the thresholds of the arcs going to the
+*  transitions it feeds.  These are given by the "thresholds" 
+*  parameter, the list of the weights of those arcs where 0 stands
+*  for an inhibitor arc, or "none" if no transition takes tokens from
+*  the place.  The default is "0 1 2 3 4", the weights of the in0 to
+*  in4 ports of PnTrans; arcs of a greater weight must be listed.
+*
+*  When the "file" parameter of the [pntrace] section is set, every
+*  change of the count is recorded in that binary trace file (see
+*  pnTrace.h), the initial count being a change at time zero.
+*
+*  When the "file" parameter of the [pnstats] section is set, the
+*  time averaged, smallest and largest counts of the place are
+*  measured as the simulation runs and written to that file (see
+*  pnStats.h).
+*
+*  When the "file" parameter of the [pnprofile] section is set, the
+*  messages and the advertisements of the place are counted, and
+*  with "timing" the time spent in its functions measured, and
+*  written to that file (see pnProfile.h).
+*
+*  When the [pncheckpoint] section is set, the count and the level
+*  last advertised are saved in, or loaded from, a checkpoint (see
+*  pnCheckpoint.h).  A place loaded from a checkpoint only
+*  advertises its count at time zero if it had not advertised it
+*  yet when the checkpoint was taken.
+*
 *  AUTHOR: Christian Jacques
 *
 *  EMAIL: chris.jacques@videotron.ca
@@ -35,9 +65,16 @@
 #include "mainsimu.h"   // MainSimulator::Instance().getParameter()
 #include "model.h"   	// Model::id()
 #include "strutil.h"   	// str2Int()
-#include "realfunc.h"  	// trunc()
+#include "pnMsg.h"  	// pnMsgEncode(), pnMsgDecode()
+#include "pnTrace.h"  	// pnTraceFromParameters()
+#include "pnStats.h"  	// pnStatsFromParameters()
+#include "pnProfile.h"  	// pnProfileFromParameters()
+#include "pnCheckpoint.h"  	// pnCheckpointSave(), pnCheckpointLoad()
 #include "except.h"  	// for exception
 #include "process.h"  	// class Processor
+#include <stdlib.h>  	// atoll(), atof()
+#include <sstream>  	// istringstream
+#include <algorithm>  	// sort(), unique(), upper_bound()
 
 /** public functions **/
 
@@ -48,7 +85,10 @@
 * initializes the number of tokens that are contained in the 
 * place.  This value comes from the "tokens" parameter specified
 * in the .ma file.  If the parameter is not specified, the place 
-* is assumed to be empty.
+* is assumed to be empty.  The arc thresholds are read from the
+* "thresholds" parameter.  An inhibitor arc changes state when the
+* place goes from empty to one token, which is the threshold of an
+* arc of weight one, so both are stored as a threshold of one.
 ********************************************************************/
 PnPlace::PnPlace( const string &name )
 : Atomic( name )
@@ -58,11 +98,63 @@ PnPlace::PnPlace( const string &name )
 
 	if( MainSimulator::Instance().existsParameter( description(), 
 	    "tokens" ))
-	   numOfTokens = str2Int( MainSimulator::Instance().getParameter \
-	    ( description(), "tokens" ) );
+	   numOfTokens = atoll( MainSimulator::Instance().getParameter \
+	    ( description(), "tokens" ).c_str() );
 	else
 	   numOfTokens = 0;
 
+	string weights( "0 1 2 3 4" );
+
+	if( MainSimulator::Instance().existsParameter( description(), 
+	    "thresholds" ))
+	   weights = MainSimulator::Instance().getParameter \
+	    ( description(), "thresholds" );
+
+	istringstream weightList( weights );
+	string weight;
+
+	while( weightList >> weight )
+	    if( weight != "none" )
+		thresholds.push_back( max( atoll( weight.c_str() ), 1LL ) );
+
+	sort( thresholds.begin(), thresholds.end() );
+	thresholds.erase( unique( thresholds.begin(), thresholds.end() ),
+			  thresholds.end() );
+
+	// Nothing was advertised yet
+	advertisedLevel = -1;
+	updatePending = false;
+
+	saved = NULL;
+	loaded = NULL;
+
+	try
+	   {
+	   trace = pnTraceFromParameters();
+	   stats = pnStatsFromParameters();
+	   profile = pnProfileFromParameters();
+
+	   if( MainSimulator::Instance().existsParameter( "pncheckpoint", "save" ))
+	      {
+	      if( !MainSimulator::Instance().existsParameter( "pncheckpoint", "at" ))
+		 throw PnNetError( "The at parameter of the pncheckpoint section is missing" );
+
+	      saved = pnCheckpointSave( MainSimulator::Instance().getParameter \
+	       ( "pncheckpoint", "save" ), atof( MainSimulator::Instance(). \
+	       getParameter( "pncheckpoint", "at" ).c_str() ) );
+	      }
+
+	   if( MainSimulator::Instance().existsParameter( "pncheckpoint", "load" ))
+	      loaded = pnCheckpointLoad( MainSimulator::Instance().getParameter \
+	       ( "pncheckpoint", "load" ) );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
 }
 
 /*******************************************************************
@@ -72,7 +164,9 @@ PnPlace::PnPlace( const string &name )
 * number of tokens it contains so transitions that are connected
 * to it can determine if they are enabled or not.  Furthermore,
 * the model ID of the place is saved.  This is used by the
-* external and output functions. 
+* external and output functions.  A place loaded from a checkpoint
+* takes its count from it and only advertises it if it was not
+* advertised yet.
 ********************************************************************/
 Model &PnPlace::initFunction()
 {
@@ -82,9 +176,54 @@ Model &PnPlace::initFunction()
 	// yet.
 	placeId = Model::id();
 
+	if( loaded != NULL )
+	    {
+	    const PnCheckpoint::Place *state = loaded->placeFind( description() );
+
+	    if( state == NULL )
+		{
+		MException e( string("Place ") + description() + \
+		    " is not in the checkpoint" );
+		e.addLocation( MEXCEPTION_LOCATION() );
+		throw e;
+		}
+
+	    numOfTokens = state->tokens;
+	    advertisedLevel = state->level;
+	    }
+
+	if( trace != NULL )
+	    {
+	    trace->name( PN_TRACE_PLACE, placeId, description() );
+	    if( numOfTokens != 0 )
+		trace->change( 0, PN_TRACE_NONE, placeId, numOfTokens );
+	    }
+
+	if( stats != NULL )
+	    statsId = stats->add( PN_STATS_PLACE, description(), numOfTokens );
+
+	if( profile != NULL )
+	    profileId = profile->add( PN_PROFILE_PLACE, description() );
+
+	if( saved != NULL )
+	    {
+	    savedId = saved->placeAdd( description() );
+	    saved->place( savedId, 0, numOfTokens, advertisedLevel );
+	    }
+
+	if( levelGet( numOfTokens ) == advertisedLevel )
+	    {
+	    passivate();
+	    return *this;
+	    }
+
 	// Advertise the number of tokens contained in this place
+	updatePending = true;
 	holdIn( active, Time::Zero );
 
+	if( profile != NULL )
+	    profile->reactivation( profileId );
+
 	return *this ;
 }
 
@@ -99,55 +238,82 @@ Model &PnPlace::initFunction()
 * token count by a given amount.  The messages coming into this port 
 * actually contain two pieces of information.  The first one being
 * the number of tokens to subtract the second being the ID of the
-* place to which the message is destined.  The format is "XYYY" 
-* where X is the model ID of the place and YYY is the number 
-* of tokens.  For example, 5003 is a message meaning that the place
-* whose ID is 5 must subtract 3 tokens.  Therefore, the maximum
-* number of tokens a place can advertize is 999.  However, internally
-* the proper number of tokens is kept.
+* place to which the message is destined.  Both are packed in the
+* message as described in pnMsg.h.  Deposits carry a place ID of
+* zero.
+*
+* Several transitions may deposit or remove tokens at the same
+* simulated time.  Each change is applied to the count as it 
+* arrives but the place is scheduled at most once to advertise 
+* the result, so the net change of the instant produces a single
+* zero-time event and a single advertisement.  A removal may 
+* therefore make the count negative for a while, e.g. when it
+* arrives before a deposit of the same instant; the count is only
+* checked when the place advertises, once every change of the 
+* instant has been received.
 ********************************************************************/
 Model &PnPlace::externalFunction( const ExternalMessage &msg )
 {
-	Real destId;	// Place the message is for.
+	PnTokenMsg tokenMsg;	// Decoded message
+	PnProfileTimer timer( profile, profileId, PN_PROFILE_EXTERNAL );
+
+	if( profile != NULL )
+	    profile->received( profileId, msg.time().asMsecs() / 1000.0 );
  
 	if( msg.port() == in )
 	   {
 	   // Check who the message is for
-	   destId = trunc( msg.value() / 1000 );
+	   tokenMsg = pnMsgDecode( msg.value() );
 		
-	   if( (ModelId) destId.value() == placeId )
+	   if( tokenMsg.placeId == (unsigned int) placeId )
 		{
 		// Message is specifically for this place. 
-		// Decrement the number of tokens.  It is an 
-		// error condition to attempt to remove more 
-		// tokens then there are in the place.
-		if( numOfTokens >= ((int) msg.value() % 1000) )
-		    {
-	   	    numOfTokens -= (int) msg.value() % 1000;
-		    }
-		else  // Throw an exception
-		    {
-		    MException e( string("An attempt was made to remove " \
-		    "more tokens (") + ((int) msg.value() % 1000) + ") than " \
-		    "the number of tokens (" \
-		    + numOfTokens + ")contained in place " \
-		    + description() + \
-		    ".  Please ensure the in port of the place is " \
-		    "connected to the proper transition(s)");
-		    e.addLocation( MEXCEPTION_LOCATION() );
-		    throw e;
-		    }
+		// Decrement the number of tokens.
+	   	numOfTokens -= tokenMsg.tokens;
+
+		if( trace != NULL )
+		    trace->change( msg.time().asMsecs() / 1000.0, 
+				   PN_TRACE_NONE, placeId, -tokenMsg.tokens );
+
+		if( stats != NULL )
+		    stats->level( statsId, msg.time().asMsecs() / 1000.0,
+				  numOfTokens );
 		} 
-	   else if( (ModelId) destId.value() == 0 )
+	   else if( tokenMsg.placeId == 0 )
 		{
 		// This is a generic message.  A transition wants to
 		// deposit tokens
-		numOfTokens += (int) msg.value();
+		numOfTokens += tokenMsg.tokens;
+
+		if( trace != NULL )
+		    trace->change( msg.time().asMsecs() / 1000.0, 
+				   PN_TRACE_NONE, placeId, tokenMsg.tokens );
+
+		if( stats != NULL )
+		    stats->level( statsId, msg.time().asMsecs() / 1000.0,
+				  numOfTokens );
 		}
+
+	   if( saved != NULL )
+		saved->place( savedId, msg.time().asMsecs() / 1000.0,
+			      numOfTokens, advertisedLevel );
 	}
 	// Immediately tell all transitions receiving tokens 
-	// from this place there is a new number of tokens
-	holdIn( active, Time::Zero );
+	// from this place there is a new number of tokens, but
+	// only if the change crossed an arc threshold: otherwise
+	// no transition can change state.  When there is nothing 
+	// to advertise the model is left as it is, passive or 
+	// already scheduled to advertise.  A negative count is
+	// scheduled too so that it gets checked.
+	if( !updatePending && ( numOfTokens < 0 ||
+	    levelGet( numOfTokens ) != advertisedLevel ) )
+	    {
+	    updatePending = true;
+	    holdIn( active, Time::Zero );
+
+	    if( profile != NULL )
+		profile->reactivation( profileId );
+	    }
 
 	return *this;
 }
@@ -157,9 +323,17 @@ Model &PnPlace::externalFunction( const ExternalMessage &msg )
 * Description: This method always passivates the model because 
 * after activating the output function, the place waits forever
 * for a transition to deposit or remove tokens from its contents.
+* It also records the level which was just advertised.
 ********************************************************************/
-Model &PnPlace::internalFunction( const InternalMessage & )
+Model &PnPlace::internalFunction( const InternalMessage &msg )
 {
+	advertisedLevel = levelGet( numOfTokens );
+	updatePending = false;
+
+	if( saved != NULL )
+	    saved->place( savedId, msg.time().asMsecs() / 1000.0,
+			  numOfTokens, advertisedLevel );
+
 	passivate();
 
 	return *this;
@@ -168,20 +342,64 @@ Model &PnPlace::internalFunction( const InternalMessage & )
 /*******************************************************************
 * Function Name: outputFunction
 * Description: This routines outputs the number of tokens contained
-* in the place on the output port <out>.  The format of the message
-* is "XYYY" where X is the model ID of this place and YYY is the
-* number of tokens it contains.  For example, 2011 means the ID of
-* this place is 2 and it contains 11 tokens.  The maximum number
-* of tokens that can be advertised is 999.
+* in the place on the output port <out>.  The message carries the
+* model ID of this place and the number of tokens it contains,
+* packed as described in pnMsg.h.  A count which does not fit in
+* the message is an error rather than being clamped, because a
+* clamped count could be wrong for an arc of any weight.  If the
+* changes of the instant cancelled each other out with respect to
+* the arc thresholds there is nothing to advertise.
 ********************************************************************/
 Model &PnPlace::outputFunction( const InternalMessage &msg )
 {
-	// If there are more than 999 tokens, advertise that 
-	// there are only 999.  This should not affect the
-	// state of the transtion(s) which depend on this place
-	// to be enabled.
-	sendOutput( msg.time(), out, placeId * 1000 + \
-		  ( numOfTokens > 999 ? 999 : numOfTokens ) );
+	PnProfileTimer timer( profile, profileId, PN_PROFILE_OUTPUT );
+
+	// It is an error condition to remove more tokens than
+	// there are in the place.
+	if( numOfTokens < 0 )
+	    {
+	    MException e( string("An attempt was made to remove " \
+		"more tokens than the number of tokens contained in " \
+		"place ") + description() + " (" + \
+		pnTokensStr( numOfTokens ) + " tokens left)" \
+		".  Please ensure the in port of the place is " \
+		"connected to the proper transition(s)");
+	    e.addLocation( MEXCEPTION_LOCATION() );
+	    throw e;
+	    }
+
+	if( levelGet( numOfTokens ) == advertisedLevel )
+	    {
+	    if( profile != NULL )
+		profile->silent( profileId );
+	    return *this;
+	    }
+
+	if( !pnMsgFits( placeId, numOfTokens ) )
+	    {
+	    MException e( string("Place ") + description() + " (ID " \
+		+ placeId + ") holds " + pnTokensStr( numOfTokens ) + " tokens which " \
+		"cannot be advertised in a token message");
+	    e.addLocation( MEXCEPTION_LOCATION() );
+	    throw e;
+	    }
+
+	sendOutput( msg.time(), out, pnMsgEncode( placeId, numOfTokens ) );
+
+	if( profile != NULL )
+	    profile->sent( profileId, 1 );
 
 	return *this ;
 }
+
+/*******************************************************************
+* Function Name: levelGet
+* Description: This routine returns the number of arc thresholds
+* reached by a token count.  Two counts with the same level 
+* satisfy exactly the same arcs.
+********************************************************************/
+int PnPlace::levelGet( PnTokens tokens ) const
+{
+	return upper_bound( thresholds.begin(), thresholds.end(), tokens ) -
+	       thresholds.begin();
+}
@@ -14,8 +14,14 @@
 #define __PNPLACE_H
 
 #include <list>
+#include <vector>
 #include "atomic.h"     // class Atomic
 #include "modelid.h"    // definition of ModelId
+#include "pnMsg.h"	// PnTokens
+#include "pnTrace.h"	// class PnTrace
+#include "pnStats.h"	// class PnStats
+#include "pnProfile.h"	// class PnProfile
+#include "pnCheckpoint.h"	// class PnCheckpoint
 
 // PnPlace class
 
@@ -31,6 +37,7 @@ protected:
 	Model &externalFunction( const ExternalMessage & );
 	Model &internalFunction( const InternalMessage & );
 	Model &outputFunction( const InternalMessage & );
+	int levelGet( PnTokens tokens ) const;
 
 private:
 
@@ -41,11 +48,35 @@ private:
 	Port &out;
 
 	// state variables
-	int numOfTokens;	// number of token in the place
+	PnTokens numOfTokens;	// number of token in the place
+	int advertisedLevel;	// level of the last advertised count
+	bool updatePending;	// advertisement scheduled at this time
+
+	// Sorted thresholds of the arcs going to transitions
+	vector<PnTokens> thresholds;
 
 	// ID of the place
 	ModelId placeId;
 
+	// Binary trace of the changes of the count, NULL if none
+	PnTrace *trace;
+
+	// Statistics of the count, NULL if none, and the number of
+	// the place in them
+	PnStats *stats;
+	unsigned int statsId;
+
+	// Profile of the work of the model, NULL if none, and the
+	// number of the model in it
+	PnProfile *profile;
+	unsigned int profileId;
+
+	// Checkpoint the state is saved in, NULL if none, with the
+	// number of the place in it, and the checkpoint the state
+	// is loaded from, NULL if none
+	PnCheckpoint *saved;
+	unsigned int savedId;
+	const PnCheckpoint *loaded;
 
 };	// class PnPlace
 
@@ -0,0 +1,150 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Work Stealing Pool
+*
+*  Each worker owns a share of task numbers protected by its own
+*  lock, so the workers only contend when one of them steals.
+*  A thief picks the largest share, takes its back half and makes
+*  it its own share.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnPool.h"	// class PnPool
+#include <thread>	// thread
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: workerCountGet
+* Description: Returns the number of workers to start.
+********************************************************************/
+static unsigned int workerCountGet( unsigned int workers )
+{
+	if( workers == 0 )
+	    workers = thread::hardware_concurrency();
+
+	return workers == 0 ? 1 : workers;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnPool constructor
+********************************************************************/
+PnPool::PnPool( unsigned int workers )
+: workerCount( workerCountGet( workers ) )
+, shares( workerCount )
+{
+}
+
+/*******************************************************************
+* Function Name: run
+* Description: Splits the tasks into one share per worker, starts
+* the workers and waits for them.  The calling thread is worker 0.
+********************************************************************/
+void PnPool::run( unsigned int tasks, PnTask &work )
+{
+	vector<thread> threads;
+	unsigned int w;
+
+	for( w = 0; w < workerCount; w++ )
+	    {
+	    shares[w].first = (unsigned int) ( (unsigned long long) tasks * w / workerCount );
+	    shares[w].last = (unsigned int) ( (unsigned long long) tasks * ( w + 1 ) / workerCount );
+	    }
+
+	for( w = 1; w < workerCount; w++ )
+	    threads.push_back( thread( &PnPool::workerRun, this, w, ref( work ) ) );
+
+	workerRun( 0, work );
+
+	for( w = 0; w < threads.size(); w++ )
+	    threads[w].join();
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: workerRun
+* Description: Runs the tasks of a worker, stealing more until no
+* share has any task left.
+********************************************************************/
+void PnPool::workerRun( unsigned int worker, PnTask &work )
+{
+	unsigned int task;
+
+	do
+	    {
+	    while( taskTake( worker, task ) )
+		work.run( task, worker );
+	    }
+	while( taskSteal( worker ) );
+}
+
+/*******************************************************************
+* Function Name: taskTake
+* Description: Takes the first task of the share of a worker.
+********************************************************************/
+bool PnPool::taskTake( unsigned int worker, unsigned int &task )
+{
+	Share &share = shares[worker];
+	lock_guard<mutex> guard( share.lock );
+
+	if( share.first == share.last )
+	    return false;
+
+	task = share.first++;
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: taskSteal
+* Description: Moves the back half of the largest share to the
+* share of the worker.  Returns false when every share is empty.
+* The victim may have run some tasks since its size was read so
+* the size is checked again before stealing.
+********************************************************************/
+bool PnPool::taskSteal( unsigned int worker )
+{
+	for( ;; )
+	    {
+	    unsigned int victim = worker;
+	    unsigned int largest = 0;
+	    unsigned int first, last;
+
+	    for( unsigned int w = 0; w < workerCount; w++ )
+		{
+		lock_guard<mutex> guard( shares[w].lock );
+		unsigned int size = shares[w].last - shares[w].first;
+
+		if( size > largest )
+		    {
+		    largest = size;
+		    victim = w;
+		    }
+		}
+
+	    if( largest == 0 )
+		return false;
+
+	    {
+	    lock_guard<mutex> guard( shares[victim].lock );
+	    unsigned int size = shares[victim].last - shares[victim].first;
+
+	    if( size == 0 )
+		continue;
+
+	    last = shares[victim].last;
+	    first = last - ( size + 1 ) / 2;
+	    shares[victim].last = first;
+	    }
+
+	    lock_guard<mutex> guard( shares[worker].lock );
+	    shares[worker].first = first;
+	    shares[worker].last = last;
+
+	    return true;
+	    }
+}
@@ -0,0 +1,70 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Work Stealing Pool Header File
+*
+*  A PnPool runs a batch of independent tasks, numbered 0 .. n-1,
+*  on a fixed number of worker threads.  Each worker starts with an
+*  even share of the task numbers and takes them one by one from
+*  the front of its share.  A worker which runs out of tasks steals
+*  the back half of the largest remaining share, so workers finish
+*  together even when the tasks do not take the same time.
+*
+*  The pool is used by the stand alone tools; it does not depend
+*  on the CD++ kernel.
+*
+*******************************************************************/
+
+#ifndef __PNPOOL_H
+#define __PNPOOL_H
+
+#include <vector>
+#include <mutex>
+
+using namespace std;
+
+// Work done by the pool: task is the number of the task to run and
+// worker the number (0 .. workers-1) of the thread running it.
+class PnTask
+{
+public:
+	virtual ~PnTask() {}
+
+	virtual void run( unsigned int task, unsigned int worker ) = 0;
+
+};	// class PnTask
+
+// PnPool class
+
+class PnPool
+{
+public:
+	// Constructor.  With 0 workers the pool uses one worker per
+	// processor.
+	PnPool( unsigned int workers = 0 );
+
+	unsigned int workers() const
+		{return workerCount;}
+
+	// Runs tasks 0 .. tasks-1 and returns when all of them are
+	// done.
+	void run( unsigned int tasks, PnTask &work );
+
+private:
+	// Task numbers first .. last-1 still to be run by a worker
+	struct Share
+	    {
+	    mutex lock;
+	    unsigned int first;
+	    unsigned int last;
+	    };
+
+	void workerRun( unsigned int worker, PnTask &work );
+	bool taskTake( unsigned int worker, unsigned int &task );
+	bool taskSteal( unsigned int worker );
+
+	unsigned int workerCount;
+	vector<Share> shares;
+
+};	// class PnPool
+
+#endif   //__PNPOOL_H
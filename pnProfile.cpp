@@ -0,0 +1,248 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Profile
+*
+*  This file implements the profile described in pnProfile.h.  The
+*  models only add to the counts of the current interval; they are
+*  added to the counts of the run when a snapshot is written, so an
+*  event costs an increment whatever the size of the net.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnProfile.h"	// class PnProfile
+#include "mainsimu.h"	// MainSimulator::Instance().getParameter()
+#include <stdlib.h>	// atexit(), atof(), atoi()
+#include <string.h>	// memset()
+#include <C:\cygwin\usr\include\time.h>	// clock_gettime()
+#include <map>
+
+/** private data **/
+
+// The profiles opened by pnProfileOpen()
+static map<string, PnProfile *> openProfiles;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: profilesClose
+* Description: Closes the profiles opened by pnProfileOpen() when
+* the program exits.
+********************************************************************/
+static void profilesClose()
+{
+	for( map<string, PnProfile *>::iterator i = openProfiles.begin();
+	     i != openProfiles.end(); i++ )
+	    delete i->second;
+
+	openProfiles.clear();
+}
+
+/*******************************************************************
+* Function Name: countAdd
+* Description: Adds the counts of a period to the counts of another.
+********************************************************************/
+static void countAdd( PnProfile::Count &to, const PnProfile::Count &from )
+{
+	to.received += from.received;
+	to.sent += from.sent;
+	to.firings += from.firings;
+	to.reactivations += from.reactivations;
+	to.flips += from.flips;
+	to.silent += from.silent;
+	to.draws += from.draws;
+	for( int f = 0; f < PN_PROFILE_TIMED; f++ )
+	    to.seconds[f] += from.seconds[f];
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnProfile constructor
+********************************************************************/
+PnProfile::PnProfile( const string &fileName, double span, bool time )
+: interval( span > 0 ? span : 0 )
+, timing( time )
+, next( span > 0 ? span : 0 )
+, last( 0 )
+{
+	file = fopen( fileName.c_str(), "w" );
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot create the profile file " + fileName );
+
+	fprintf( file, "time,scope,kind,name,received,sent,firings,reactivations,"
+		 "flips,silent,draws,inputs,inputplaces,external_s,output_s,draw_s\n" );
+}
+
+/*******************************************************************
+* Function Name: PnProfile destructor
+********************************************************************/
+PnProfile::~PnProfile()
+{
+	close();
+}
+
+/*******************************************************************
+* Function Name: add
+********************************************************************/
+unsigned int PnProfile::add( int kind, const string &name, unsigned int limit )
+{
+	Entry entry;
+
+	entry.kind = kind;
+	entry.name = name;
+	entry.inputs = 0;
+	entry.limit = limit;
+	memset( &entry.count, 0, sizeof( entry.count ) );
+	memset( &entry.total, 0, sizeof( entry.total ) );
+
+	entries.push_back( entry );
+
+	return entries.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: close
+* Description: Writes the counts of the whole run, which ends with
+* the last message received.
+********************************************************************/
+void PnProfile::close()
+{
+	if( file == NULL )
+	    return;
+
+	for( unsigned int i = 0; i < entries.size(); i++ )
+	    {
+	    Entry &entry = entries[i];
+
+	    countAdd( entry.total, entry.count );
+	    write( last, "total", entry, entry.total );
+	    }
+
+	fclose( file );
+	file = NULL;
+}
+
+/*******************************************************************
+* Function Name: pnProfileClock
+********************************************************************/
+double pnProfileClock()
+{
+	struct timespec now;
+
+	clock_gettime( CLOCK_MONOTONIC, &now );
+
+	return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+/*******************************************************************
+* Function Name: pnProfileOpen
+* Description: Returns the profile writing to a file.  The interval
+* and timing given the first time are kept.
+********************************************************************/
+PnProfile *pnProfileOpen( const string &fileName, double interval, bool timing )
+{
+	map<string, PnProfile *>::iterator i = openProfiles.find( fileName );
+
+	if( i != openProfiles.end() )
+	    return i->second;
+
+	if( openProfiles.empty() )
+	    atexit( profilesClose );
+
+	PnProfile *profile = new PnProfile( fileName, interval, timing );
+
+	openProfiles[fileName] = profile;
+
+	return profile;
+}
+
+/*******************************************************************
+* Function Name: pnProfileFromParameters
+* Description: Reads the [pnprofile] section for the first model
+* only; the others get the profile it opened.
+********************************************************************/
+PnProfile *pnProfileFromParameters()
+{
+	static bool read = false;
+	static PnProfile *profile = NULL;
+
+	if( read )
+	    return profile;
+
+	if( MainSimulator::Instance().existsParameter( "pnprofile", "file" ))
+	    {
+	    double interval = 0;
+	    bool timing = false;
+
+	    if( MainSimulator::Instance().existsParameter( "pnprofile", "interval" ))
+		interval = atof( MainSimulator::Instance().getParameter \
+		 ( "pnprofile", "interval" ).c_str() );
+
+	    if( MainSimulator::Instance().existsParameter( "pnprofile", "timing" ))
+		timing = atoi( MainSimulator::Instance().getParameter \
+		 ( "pnprofile", "timing" ).c_str() ) != 0;
+
+	    profile = pnProfileOpen( MainSimulator::Instance().getParameter \
+	     ( "pnprofile", "file" ), interval, timing );
+	    }
+
+	read = true;
+
+	return profile;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: advance
+* Description: Writes the snapshots of the intervals ending at or
+* before a time and adds their counts to the counts of the run.
+* The counts of an interval are those of the events before it ends.
+********************************************************************/
+void PnProfile::advance( double time )
+{
+	while( time >= next && file != NULL )
+	    {
+	    for( unsigned int i = 0; i < entries.size(); i++ )
+		{
+		Entry &entry = entries[i];
+
+		write( next, "interval", entry, entry.count );
+		countAdd( entry.total, entry.count );
+		memset( &entry.count, 0, sizeof( entry.count ) );
+		}
+
+	    next += interval;
+	    }
+}
+
+/*******************************************************************
+* Function Name: write
+* Description: Writes the line of a place or transition.  The times
+* are left empty without timing.
+********************************************************************/
+void PnProfile::write( double time, const char *scope, const Entry &entry,
+		       const Count &count )
+{
+	fprintf( file, "%g,%s,%s,%s,%lu,%lu,", time, scope,
+		 entry.kind == PN_PROFILE_PLACE ? "place" : "trans",
+		 entry.name.c_str(), count.received, count.sent );
+
+	if( entry.kind == PN_PROFILE_PLACE )
+	    fprintf( file, ",%lu,,%lu,,,,", count.reactivations, count.silent );
+	else
+	    fprintf( file, "%lu,%lu,%lu,,%lu,%u,%u,", count.firings,
+		     count.reactivations, count.flips, count.draws,
+		     entry.inputs, entry.limit );
+
+	if( !timing )
+	    fprintf( file, ",,\n" );
+	else if( entry.kind == PN_PROFILE_PLACE )
+	    fprintf( file, "%.9f,%.9f,\n", count.seconds[PN_PROFILE_EXTERNAL],
+		     count.seconds[PN_PROFILE_OUTPUT] );
+	else
+	    fprintf( file, "%.9f,%.9f,%.9f\n", count.seconds[PN_PROFILE_EXTERNAL],
+		     count.seconds[PN_PROFILE_OUTPUT], count.seconds[PN_PROFILE_DRAW] );
+}
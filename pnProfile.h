@@ -0,0 +1,211 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Profile Header File
+*
+*  A PnProfile counts the work done by every PnPlace and PnTrans
+*  model while the simulation runs, to find the places and
+*  transitions where the time of a large net goes and to size their
+*  parameters:
+*
+*  - received, sent: the messages received and sent by the model;
+*  - firings: the firings of a transition;
+*  - reactivations: the events scheduled in zero time, the
+*    advertisements of a place and the firings of a transition
+*    drawing a zero delay;
+*  - flips: the firings a transition scheduled and cancelled when
+*    one of its input arcs stopped being satisfied;
+*  - silent: the advertisements of a place the changes of the
+*    instant made useless;
+*  - draws: the delays drawn by a transition, one per firing
+*    scheduled, including the ones cancelled;
+*  - inputs: the largest number of input places a transition held,
+*    next to its "inputplaces" parameter (0 for none);
+*  - external_s, output_s, draw_s: when timing is on, the seconds
+*    spent in the external and output functions of the model and
+*    in drawing delays.  Reading the clock costs more than most of
+*    these functions, so the times are only for comparing models.
+*
+*  The counts are written to a text file in CSV form, one line per
+*  place or transition:
+*
+*  time,scope,kind,name,received,sent,firings,reactivations,flips,
+*  silent,draws,inputs,inputplaces,external_s,output_s,draw_s
+*
+*  with the columns which do not apply to the kind left empty.  As
+*  with pnStats.h, a snapshot of the counts of the last interval is
+*  written every interval seconds with the scope "interval", and
+*  the counts of the whole run with the scope "total" when the file
+*  is closed.  Counting is a few increments per event; nothing is
+*  counted without the section.
+*
+*  The profile is given to the models by the [pnprofile] section of
+*  the .ma file, "timing" being 1 to measure the times:
+*
+*  [pnprofile]
+*  file : pipeline_profile.csv
+*  interval : 3600
+*  timing : 1
+*
+*******************************************************************/
+
+#ifndef __PNPROFILE_H
+#define __PNPROFILE_H
+
+#include <stdio.h>	// FILE
+#include <string>
+#include <vector>
+#include "pnNetDef.h"	// class PnNetError
+
+// Kinds of entries
+#define PN_PROFILE_PLACE	0
+#define PN_PROFILE_TRANS	1
+
+// Functions timed
+#define PN_PROFILE_EXTERNAL	0
+#define PN_PROFILE_OUTPUT	1
+#define PN_PROFILE_DRAW		2
+#define PN_PROFILE_TIMED	3
+
+// PnProfile class
+
+class PnProfile
+{
+public:
+	// Creates the file.  Throws a PnNetError if it cannot be
+	// created.  An interval of 0 writes no snapshot.
+	PnProfile( const string &fileName, double interval, bool timing );
+
+	// Closes the file
+	~PnProfile();
+
+	// Adds a place, or a transition allowing <limit> input places,
+	// and returns its number
+	unsigned int add( int kind, const string &name, unsigned int limit = 0 );
+
+	// Returns true if the functions are to be timed
+	bool timed() const
+		{return timing;}
+
+	// Count the events of a model.  A message received at a time
+	// past the end of an interval first writes its snapshot.
+	void received( unsigned int id, double time )
+		{
+		if( time >= next && interval > 0 )
+		    advance( time );
+		if( time > last )
+		    last = time;
+		entries[id].count.received++;
+		}
+
+	void sent( unsigned int id, unsigned long messages )
+		{entries[id].count.sent += messages;}
+
+	void firing( unsigned int id )
+		{entries[id].count.firings++;}
+
+	void reactivation( unsigned int id )
+		{entries[id].count.reactivations++;}
+
+	void flip( unsigned int id )
+		{entries[id].count.flips++;}
+
+	void silent( unsigned int id )
+		{entries[id].count.silent++;}
+
+	void draw( unsigned int id )
+		{entries[id].count.draws++;}
+
+	void inputs( unsigned int id, unsigned int places )
+		{
+		if( places > entries[id].inputs )
+		    entries[id].inputs = places;
+		}
+
+	void spent( unsigned int id, int what, double seconds )
+		{entries[id].count.seconds[what] += seconds;}
+
+	// Writes the counts of the run.  Nothing can be counted
+	// afterwards.
+	void close();
+
+	// Counts of a model over a period
+	struct Count
+	    {
+	    unsigned long received;
+	    unsigned long sent;
+	    unsigned long firings;
+	    unsigned long reactivations;
+	    unsigned long flips;
+	    unsigned long silent;
+	    unsigned long draws;
+	    double seconds[PN_PROFILE_TIMED];
+	    };
+
+private:
+	// Counts of a model over the current interval and over the
+	// intervals before it
+	struct Entry
+	    {
+	    int kind;
+	    string name;
+	    unsigned int inputs;	// largest number of input places
+	    unsigned int limit;		// "inputplaces", 0 if none
+	    Count count;
+	    Count total;
+	    };
+
+	void advance( double time );
+	void write( double time, const char *scope, const Entry &entry,
+		    const Count &count );
+
+	FILE *file;
+	double interval;
+	bool timing;
+	double next;		// time of the next snapshot
+	double last;		// time of the last message
+	vector<Entry> entries;
+
+};	// class PnProfile
+
+// Returns the seconds of a clock which only goes forward
+double pnProfileClock();
+
+// PnProfileTimer class: adds the time it lives to a function of a
+// model when the profile is timed.  Without a profile, or without
+// timing, it does not read the clock.
+
+class PnProfileTimer
+{
+public:
+	PnProfileTimer( PnProfile *profile, unsigned int id, int what )
+	: prof( profile != NULL && profile->timed() ? profile : NULL )
+	, entry( id )
+	, function( what )
+	, start( prof != NULL ? pnProfileClock() : 0 )
+		{}
+
+	~PnProfileTimer()
+		{
+		if( prof != NULL )
+		    prof->spent( entry, function, pnProfileClock() - start );
+		}
+
+private:
+	PnProfile *prof;
+	unsigned int entry;
+	int function;
+	double start;
+
+};	// class PnProfileTimer
+
+// Returns the profile writing to a file, creating it the first
+// time.  Every model naming the same file shares the same profile.
+// It is closed when the program exits.
+PnProfile *pnProfileOpen( const string &fileName, double interval, bool timing );
+
+// Returns the profile of the [pnprofile] section of the .ma file,
+// NULL without the section.  The section is only read by the first
+// call.  Throws a PnNetError if the file cannot be created.
+PnProfile *pnProfileFromParameters();
+
+#endif   //__PNPROFILE_H
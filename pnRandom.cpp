@@ -0,0 +1,101 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Random Delays
+*
+*  This file implements the delay distributions of the transitions.
+*  Each draw consumes exactly one 64 bit value of the counter-based
+*  generator: uniform integers are obtained by a multiplication and
+*  a shift instead of a rejection loop, and exponential delays by
+*  inversion.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnRandom.h"	// PnDelay
+#include <math.h>	// log(), floor()
+#include <sstream>	// istringstream
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnDelayDraw
+* Description: Draws a delay, in seconds, from a distribution.
+********************************************************************/
+double pnDelayDraw( const PnDelay &delay, unsigned long long seed,
+		    unsigned long long stream, unsigned long long counter )
+{
+	unsigned long long bits = pnRand64( seed, stream, counter );
+	unsigned long long span;
+
+	switch( delay.mode )
+	    {
+	    case PN_DELAY_DETERMINISTIC:
+		return delay.a;
+
+	    case PN_DELAY_UNIFORM:
+		return delay.a + ( delay.b - delay.a ) * pnRandUnit( bits );
+
+	    case PN_DELAY_EXPONENTIAL:
+		return -delay.a * log( 1.0 - pnRandUnit( bits ) );
+
+	    case PN_DELAY_DISCRETE:
+	    default:
+		// The 32 upper bits scaled to the number of values
+		span = (unsigned long long) ( delay.b - delay.a ) + 1;
+		return delay.a + (double) ( ( ( bits >> 32 ) * span ) >> 32 );
+	    }
+}
+
+/*******************************************************************
+* Function Name: pnDelayParse
+* Description: Parses the text of a delay parameter.  Negative
+* delays and empty ranges are rejected.
+********************************************************************/
+bool pnDelayParse( const string &text, PnDelay &delay )
+{
+	istringstream words( text );
+	string mode;
+	PnDelay result;
+
+	if( !( words >> mode ) )
+	    return false;
+
+	result.b = 0;
+
+	if( mode == "deterministic" )
+	    {
+	    result.mode = PN_DELAY_DETERMINISTIC;
+	    if( !( words >> result.a ) )
+		return false;
+	    result.b = result.a;
+	    }
+	else if( mode == "immediate" )
+	    {
+	    result.mode = PN_DELAY_DETERMINISTIC;
+	    result.a = 0;
+	    }
+	else if( mode == "exponential" )
+	    {
+	    result.mode = PN_DELAY_EXPONENTIAL;
+	    if( !( words >> result.a ) )
+		return false;
+	    }
+	else if( mode == "uniform" || mode == "discrete" )
+	    {
+	    result.mode = mode == "uniform" ? PN_DELAY_UNIFORM : PN_DELAY_DISCRETE;
+	    if( !( words >> result.a >> result.b ) || result.b < result.a )
+		return false;
+	    if( result.mode == PN_DELAY_DISCRETE &&
+		( result.a != floor( result.a ) || result.b != floor( result.b ) ) )
+		return false;
+	    }
+	else
+	    return false;
+
+	if( result.a < 0 )
+	    return false;
+
+	delay = result;
+
+	return true;
+}
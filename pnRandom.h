@@ -0,0 +1,117 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Random Delays Header File
+*
+*  Firing delays are drawn from a counter-based generator: the
+*  n-th draw of a transition is a hash of the seed of the run, the
+*  ID of the transition and n.  There is no shared generator state
+*  so transitions, and whole replications of a net, can draw
+*  their delays independently and in any order while a run stays
+*  reproducible from its seed.
+*
+*  The delay of a transition follows one of these distributions,
+*  written as the "delay" parameter of the transition:
+*
+*  deterministic D	always D seconds
+*  uniform A B		uniformly distributed between A and B seconds
+*  exponential M	exponentially distributed with a mean of M
+*			seconds
+*  discrete A B		integer number of seconds between A and B
+*  immediate		no delay, same as "deterministic 0"
+*
+*  The default is "discrete 1 60", the delays used by PnTrans from
+*  the beginning.  A transition whose delay is always zero is
+*  immediate (see pnEngine.h).
+*
+*******************************************************************/
+
+#ifndef __PNRANDOM_H
+#define __PNRANDOM_H
+
+#include <string>
+
+using namespace std;
+
+// Delay distributions
+enum PnDelayMode
+    {
+    PN_DELAY_DETERMINISTIC,
+    PN_DELAY_UNIFORM,
+    PN_DELAY_EXPONENTIAL,
+    PN_DELAY_DISCRETE
+    };
+
+// Delay distribution of a transition
+struct PnDelay
+    {
+    PnDelayMode mode;
+    double a;		// delay, lower bound or mean
+    double b;		// upper bound
+    };
+
+// ** inline ** //
+
+// Finalizer of the SplitMix64 generator.  A bijection of the 64
+// bit integers whose output bits all depend on all input bits.
+inline
+unsigned long long pnRandMix( unsigned long long z )
+{
+	z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ULL;
+	z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBULL;
+
+	return z ^ ( z >> 31 );
+}
+
+// Returns the draw number <counter> of stream <stream>
+inline
+unsigned long long pnRand64( unsigned long long seed, unsigned long long stream,
+			     unsigned long long counter )
+{
+	unsigned long long key = pnRandMix( seed ^ pnRandMix( stream + 0x9E3779B97F4A7C15ULL ) );
+
+	return pnRandMix( key + counter * 0x9E3779B97F4A7C15ULL );
+}
+
+// Maps a draw onto [0, 1) using its 53 upper bits
+inline
+double pnRandUnit( unsigned long long bits )
+{
+	return ( bits >> 11 ) * ( 1.0 / 9007199254740992.0 );
+}
+
+// The default delay distribution
+inline
+PnDelay pnDelayDefault()
+{
+	PnDelay delay;
+
+	delay.mode = PN_DELAY_DISCRETE;
+	delay.a = 1;
+	delay.b = 60;
+
+	return delay;
+}
+
+// Returns true if a delay is always zero
+inline
+bool pnDelayZero( const PnDelay &delay )
+{
+	return delay.a == 0 && ( delay.b == 0 || delay.mode == PN_DELAY_EXPONENTIAL );
+}
+
+// Returns the smallest delay a distribution can draw
+inline
+double pnDelayMin( const PnDelay &delay )
+{
+	return delay.mode == PN_DELAY_EXPONENTIAL ? 0 : delay.a;
+}
+
+// Returns the delay of draw <counter> of transition <stream>
+double pnDelayDraw( const PnDelay &delay, unsigned long long seed,
+		    unsigned long long stream, unsigned long long counter );
+
+// Parses a delay parameter such as "exponential 5".  Returns false
+// if the text is not a valid distribution.
+bool pnDelayParse( const string &text, PnDelay &delay );
+
+#endif   //__PNRANDOM_H
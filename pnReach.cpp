@@ -0,0 +1,508 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Reachability Explorer
+*
+*  This file implements the parallel breadth first exploration of
+*  the markings of a net.  A level is split in chunks of states
+*  which the workers of the pool expand; the new states each worker
+*  finds make up its part of the next level.  The visited set is
+*  split in 2^SHARD_BITS shards chosen by the upper bits of the hash
+*  of a marking, and each shard is an open addressing table with
+*  linear probing which grows when it is 70% full.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnReach.h"	// class PnReach
+#include "pnRandom.h"	// pnRandMix()
+#include <string.h>	// memcpy(), memcmp()
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: bitsFor
+* Description: Returns the number of bits needed to hold a count,
+* at least one.
+********************************************************************/
+static unsigned int bitsFor( PnTokens count )
+{
+	unsigned int bits = 1;
+
+	while( bits < 62 && ( count >> bits ) != 0 )
+	    bits++;
+
+	return bits;
+}
+
+/*******************************************************************
+* Function Name: keyHash
+* Description: Hashes a packed marking.
+********************************************************************/
+static uint64_t keyHash( const uint64_t *key, unsigned int words )
+{
+	uint64_t h = 0;
+
+	for( unsigned int i = 0; i < words; i++ )
+	    h = pnRandMix( h ^ key[i] );
+
+	return h;
+}
+
+/*******************************************************************
+* Function Name: markingEnables
+* Description: Returns true if a transition is enabled by a marking.
+********************************************************************/
+static bool markingEnables( const PnNetDef &net, const vector<PnTokens> &marking,
+			    unsigned int trans )
+{
+	for( unsigned int a = net.preStart[trans]; a < net.preStart[trans + 1]; a++ )
+	    {
+	    PnTokens tokens = marking[net.prePlace[a]];
+
+	    if( net.preWeight[a] == 0 ? tokens != 0 : tokens < net.preWeight[a] )
+		return false;
+	    }
+
+	return true;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnReach constructor
+* Description: Every place starts with the bits of its initial
+* count.
+********************************************************************/
+PnReach::PnReach( const PnNetDef &net, unsigned int workerCount )
+: def( net )
+, pool( workerCount )
+, workers( pool.workers() )
+, shards( new Shard[1 << SHARD_BITS] )
+, immediates( false )
+, maxStates( 0 )
+, truncated( false )
+, stateCount( 0 )
+, edgeCount( 0 )
+, levelCount( 0 )
+, deadlockCount( 0 )
+{
+	for( unsigned int p = 0; p < net.places(); p++ )
+	    width.push_back( bitsFor( net.initMarking[p] ) );
+
+	for( unsigned int t = 0; t < net.transitions(); t++ )
+	    if( net.immediate( t ) )
+		immediates = true;
+}
+
+/*******************************************************************
+* Function Name: PnReach destructor
+********************************************************************/
+PnReach::~PnReach()
+{
+	delete [] shards;
+}
+
+/*******************************************************************
+* Function Name: invariantsUse
+* Description: Picks the places to leave out.  The place picked for
+* an invariant must not appear in the invariants picked before, so
+* that unpacking can compute the places left out in the order of
+* their invariants from places already known.
+********************************************************************/
+unsigned int PnReach::invariantsUse( const vector<PnInvariant> &inv )
+{
+	vector<unsigned char> used( def.places(), 0 );
+	unsigned int i, j;
+
+	for( i = 0; i < inv.size(); i++ )
+	    {
+	    int pick = -1;
+
+	    // Prefer a place of weight 1
+	    for( j = 0; j < inv[i].index.size(); j++ )
+		if( !used[inv[i].index[j]] &&
+		    ( pick < 0 || ( inv[i].weight[j] == 1 && inv[i].weight[pick] != 1 ) ) )
+		    pick = j;
+
+	    if( pick < 0 )
+		continue;
+
+	    for( j = 0; j < inv[i].index.size(); j++ )
+		used[inv[i].index[j]] = 1;
+
+	    pivot.push_back( inv[i].index[pick] );
+	    pivotInv.push_back( inv[i] );
+	    pivotSum.push_back( pnInvariantSum( inv[i], def.initMarking ) );
+	    width[inv[i].index[pick]] = 0;
+	    }
+
+	return pivot.size();
+}
+
+/*******************************************************************
+* Function Name: explore
+* Description: Explores the state space, starting over with wider
+* fields as long as some place outgrows its field.
+********************************************************************/
+bool PnReach::explore()
+{
+	while( !attempt() )
+	    {
+	    bool widened = false;
+
+	    if( truncated )
+		return false;
+
+	    for( unsigned int p = 0; p < def.places(); p++ )
+		if( overflow[p] )
+		    {
+		    if( width[p] == 62 )
+			{
+			truncated = true;
+			return false;
+			}
+
+		    width[p] = width[p] * 2 > 62 ? 62 : width[p] * 2;
+		    widened = true;
+		    }
+
+	    if( !widened )
+		return false;
+	    }
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: run
+* Description: Expands the states of a chunk of the current level.
+* Every enabled transition is fired on the unpacked marking and
+* the resulting marking is added to the visited set.  The markings
+* which were not there yet go to the frontier of the worker.  A
+* state enabling no transition is a deadlock.  A state enabling
+* immediate transitions only fires the ones with the highest
+* priority.
+********************************************************************/
+void PnReach::run( unsigned int chunk, unsigned int worker )
+{
+	Worker &w = workers[worker];
+	size_t first = (size_t) chunk * CHUNK_STATES;
+	size_t last = first + CHUNK_STATES;
+	unsigned int a;
+
+	if( last * words > level.size() )
+	    last = level.size() / words;
+
+	for( size_t s = first; s < last && !stop; s++ )
+	    {
+	    bool dead = true, vanishing = false;
+	    int top = 0;
+
+	    unpack( &level[s * words], w.marking );
+
+	    for( unsigned int t = 0; t < def.transitions() && immediates; t++ )
+		if( def.immediate( t ) && ( !vanishing || def.transPriority[t] > top ) &&
+		    markingEnables( def, w.marking, t ) )
+		    {
+		    top = def.transPriority[t];
+		    vanishing = true;
+		    }
+
+	    for( unsigned int t = 0; t < def.transitions(); t++ )
+		{
+		if( vanishing && ( !def.immediate( t ) || def.transPriority[t] != top ) )
+		    continue;
+
+		if( !markingEnables( def, w.marking, t ) )
+		    continue;
+
+		dead = false;
+		w.edges++;
+		w.next = w.marking;
+
+		for( a = def.preStart[t]; a < def.preStart[t + 1]; a++ )
+		    w.next[def.prePlace[a]] -= def.preWeight[a];
+
+		for( a = def.postStart[t]; a < def.postStart[t + 1]; a++ )
+		    {
+		    unsigned int p = def.postPlace[a];
+
+		    w.next[p] += def.postWeight[a];
+
+		    if( width[p] != 0 && ( w.next[p] >> width[p] ) != 0 )
+			{
+			lock_guard<mutex> guard( resultLock );
+			overflow[p] = 1;
+			stop = true;
+			}
+		    }
+
+		if( stop )
+		    return;
+
+		pack( w.next, &w.key[0] );
+
+		if( insert( &w.key[0] ) )
+		    {
+		    w.frontier.insert( w.frontier.end(), w.key.begin(), w.key.end() );
+		    stateCheck( w, w.next );
+		    }
+		}
+
+	    if( dead )
+		deadlockAdd( w.marking );
+	    }
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: attempt
+* Description: Explores the state space with the current field
+* widths.  Returns false if a place outgrew its field or the state
+* limit was reached.
+********************************************************************/
+bool PnReach::attempt()
+{
+	unsigned int p, i;
+
+	// Layout of the packed markings
+	offset.resize( def.places() );
+	totalBits = 1;
+	for( p = 0; p < def.places(); p++ )
+	    {
+	    offset[p] = totalBits;
+	    totalBits += width[p];
+	    }
+	words = ( totalBits + 63 ) / 64;
+
+	for( i = 0; i < ( 1U << SHARD_BITS ); i++ )
+	    {
+	    shards[i].capacity = 64;
+	    shards[i].count = 0;
+	    shards[i].slots.assign( shards[i].capacity * words, 0 );
+	    }
+
+	for( i = 0; i < workers.size(); i++ )
+	    {
+	    workers[i].marking.resize( def.places() );
+	    workers[i].key.resize( words );
+	    workers[i].frontier.clear();
+	    workers[i].bound.assign( def.places(), 0 );
+	    workers[i].edges = 0;
+	    }
+
+	overflow.assign( def.places(), 0 );
+	stop = false;
+	stored = 0;
+	deadlockCount = 0;
+	deadlockList.clear();
+	for( i = 0; i < checks.size(); i++ )
+	    {
+	    checks[i].violations = 0;
+	    checks[i].example.clear();
+	    }
+
+	// The initial marking is the first level
+	level.assign( words, 0 );
+	pack( def.initMarking, &level[0] );
+	insert( &level[0] );
+	stateCheck( workers[0], def.initMarking );
+	levelCount = 0;
+
+	while( !level.empty() && !stop )
+	    {
+	    size_t states = level.size() / words;
+
+	    levelCount++;
+	    pool.run( ( states + CHUNK_STATES - 1 ) / CHUNK_STATES, *this );
+
+	    level.clear();
+	    for( i = 0; i < workers.size(); i++ )
+		{
+		level.insert( level.end(), workers[i].frontier.begin(),
+			      workers[i].frontier.end() );
+		workers[i].frontier.clear();
+		}
+	    }
+
+	// Results
+	stateCount = stored;
+	edgeCount = 0;
+	placeBound.assign( def.places(), 0 );
+	for( i = 0; i < workers.size(); i++ )
+	    {
+	    edgeCount += workers[i].edges;
+	    for( p = 0; p < def.places(); p++ )
+		if( workers[i].bound[p] > placeBound[p] )
+		    placeBound[p] = workers[i].bound[p];
+	    }
+
+	for( p = 0; p < def.places(); p++ )
+	    if( overflow[p] )
+		return false;
+
+	return !stop;
+}
+
+/*******************************************************************
+* Function Name: stateCheck
+* Description: Updates the bounds and the checks with a new state.
+********************************************************************/
+void PnReach::stateCheck( Worker &w, const vector<PnTokens> &marking )
+{
+	unsigned int p, i;
+
+	for( p = 0; p < def.places(); p++ )
+	    if( marking[p] > w.bound[p] )
+		w.bound[p] = marking[p];
+
+	for( i = 0; i < checks.size(); i++ )
+	    {
+	    PnTokens sum = 0;
+
+	    for( p = 0; p < checks[i].places.size(); p++ )
+		sum += marking[checks[i].places[p]];
+
+	    if( sum > checks[i].limit )
+		{
+		lock_guard<mutex> guard( resultLock );
+
+		if( checks[i].violations++ == 0 )
+		    checks[i].example = marking;
+		}
+	    }
+}
+
+/*******************************************************************
+* Function Name: deadlockAdd
+* Description: Counts a deadlock and keeps the first ones.
+********************************************************************/
+void PnReach::deadlockAdd( const vector<PnTokens> &marking )
+{
+	lock_guard<mutex> guard( resultLock );
+
+	if( deadlockCount++ < DEADLOCK_EXAMPLES )
+	    deadlockList.push_back( marking );
+}
+
+/*******************************************************************
+* Function Name: pack
+* Description: Packs a marking.  Bit 0 is always set.
+********************************************************************/
+void PnReach::pack( const vector<PnTokens> &marking, uint64_t *key ) const
+{
+	memset( key, 0, words * sizeof( uint64_t ) );
+	key[0] = 1;
+
+	for( unsigned int p = 0; p < marking.size(); p++ )
+	    {
+	    uint64_t value = marking[p];
+	    unsigned int word = offset[p] >> 6;
+	    unsigned int shift = offset[p] & 63;
+
+	    if( width[p] == 0 )
+		continue;
+
+	    key[word] |= value << shift;
+	    if( shift + width[p] > 64 )
+		key[word + 1] |= value >> ( 64 - shift );
+	    }
+}
+
+/*******************************************************************
+* Function Name: unpack
+* Description: Unpacks a marking, then computes the places left
+* out from their invariants.
+********************************************************************/
+void PnReach::unpack( const uint64_t *key, vector<PnTokens> &marking ) const
+{
+	unsigned int p, i, j;
+
+	for( p = 0; p < marking.size(); p++ )
+	    {
+	    unsigned int word = offset[p] >> 6;
+	    unsigned int shift = offset[p] & 63;
+	    uint64_t value = key[word] >> shift;
+
+	    if( width[p] == 0 )
+		continue;
+
+	    if( shift + width[p] > 64 )
+		value |= key[word + 1] << ( 64 - shift );
+
+	    marking[p] = (PnTokens) ( value & ( ( 1ULL << width[p] ) - 1 ) );
+	    }
+
+	for( i = 0; i < pivot.size(); i++ )
+	    {
+	    const PnInvariant &inv = pivotInv[i];
+	    PnTokens rest = pivotSum[i];
+	    long long weight = 1;
+
+	    for( j = 0; j < inv.index.size(); j++ )
+		if( inv.index[j] == pivot[i] )
+		    weight = inv.weight[j];
+		else
+		    rest -= inv.weight[j] * marking[inv.index[j]];
+
+	    marking[pivot[i]] = rest / weight;
+	    }
+}
+
+/*******************************************************************
+* Function Name: insert
+* Description: Adds a packed marking to the visited set.  Returns
+* true if it was not there yet.  Once the state limit is reached
+* nothing is added and the exploration is stopped.
+********************************************************************/
+bool PnReach::insert( const uint64_t *key )
+{
+	uint64_t h = keyHash( key, words );
+	Shard &shard = shards[h >> ( 64 - SHARD_BITS )];
+	lock_guard<mutex> guard( shard.lock );
+	size_t mask, slot;
+
+	if( ( shard.count + 1 ) * 10 > shard.capacity * 7 )
+	    {
+	    // Grow the shard
+	    vector<uint64_t> old;
+	    size_t i;
+
+	    old.swap( shard.slots );
+	    shard.capacity *= 2;
+	    shard.slots.assign( shard.capacity * words, 0 );
+	    mask = shard.capacity - 1;
+
+	    for( i = 0; i < old.size(); i += words )
+		if( old[i] != 0 )
+		    {
+		    slot = keyHash( &old[i], words ) & mask;
+		    while( shard.slots[slot * words] != 0 )
+			slot = ( slot + 1 ) & mask;
+		    memcpy( &shard.slots[slot * words], &old[i], words * sizeof( uint64_t ) );
+		    }
+	    }
+
+	mask = shard.capacity - 1;
+	slot = h & mask;
+
+	while( shard.slots[slot * words] != 0 )
+	    {
+	    if( memcmp( &shard.slots[slot * words], key, words * sizeof( uint64_t ) ) == 0 )
+		return false;
+	    slot = ( slot + 1 ) & mask;
+	    }
+
+	if( maxStates != 0 && stored >= maxStates )
+	    {
+	    stop = true;
+	    return false;
+	    }
+
+	memcpy( &shard.slots[slot * words], key, words * sizeof( uint64_t ) );
+	shard.count++;
+	stored++;
+
+	return true;
+}
@@ -0,0 +1,191 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Reachability Explorer Header File
+*
+*  A PnReach enumerates every marking reachable from the initial
+*  marking of a net, with the firing rule of PnTrans: a transition
+*  is enabled when each input place holds at least the weight of its
+*  arc and each inhibitor place is empty.  Time is ignored, so the
+*  markings found are all the markings the timed net may reach.
+*  Only priorities are kept: in a marking enabling immediate
+*  transitions (see pnEngine.h), only the immediate transitions
+*  with the highest priority may fire.
+*
+*  The markings are explored breadth first, one level at a time,
+*  the states of a level being expanded in parallel by the workers
+*  of a PnPool.  Each marking is stored bit packed: every place gets
+*  just enough bits for the largest count seen so far.  When a
+*  count outgrows its field the place gets twice as many bits and
+*  the exploration starts over.  The visited markings are kept in a
+*  hash set split in shards, each with its own lock, so the workers
+*  rarely wait for each other.
+*
+*  The P-invariants of the net (see pnStruct.h) make some places
+*  redundant: with P1 + P2 = 1, P2 is 1 - P1 in every marking.  Given
+*  the invariants, the explorer picks one such place per invariant
+*  and leaves it out of the packed markings, computing it back when
+*  a marking is unpacked.
+*
+*  Besides the number of states the explorer reports the deadlocks
+*  (markings enabling no transition), the bound of every place and
+*  the markings breaking linear checks such as P3 + P7 <= 1.
+*
+*******************************************************************/
+
+#ifndef __PNREACH_H
+#define __PNREACH_H
+
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>	// uint64_t
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnPool.h"	// class PnPool
+#include "pnStruct.h"	// struct PnInvariant
+
+// Linear check: the sum of the tokens of the places must not
+// exceed the limit
+struct PnReachCheck
+    {
+    string text;			// as given by the user
+    vector<unsigned int> places;
+    PnTokens limit;
+    unsigned long long violations;
+    vector<PnTokens> example;		// first marking found breaking it
+    };
+
+// PnReach class
+
+class PnReach : public PnTask
+{
+public:
+	// Constructor.  The net must outlive the explorer.  With 0
+	// workers one worker per processor is used.
+	PnReach( const PnNetDef &net, unsigned int workers = 0 );
+
+	// Destructor
+	~PnReach();
+
+	// Stops the exploration after that many states (0 for no
+	// limit)
+	void maxStatesSet( unsigned long long states )
+		{maxStates = states;}
+
+	// Adds a check; must be called before explore()
+	void checkAdd( const PnReachCheck &check )
+		{checks.push_back( check );}
+
+	// Leaves out of the packed markings one place per invariant,
+	// usually the ones of pnInvariantsP(); must be called before
+	// explore().  Returns the number of places left out.
+	unsigned int invariantsUse( const vector<PnInvariant> &inv );
+
+	// Explores the state space.  Returns false if it was stopped
+	// by the state limit or because a place needs more than 62
+	// bits, in which case the results only cover part of it.
+	bool explore();
+
+	// Results
+	unsigned long long states() const
+		{return stateCount;}
+
+	unsigned long long edges() const
+		{return edgeCount;}
+
+	unsigned int levels() const
+		{return levelCount;}
+
+	unsigned long long deadlocks() const
+		{return deadlockCount;}
+
+	// The first deadlocks found, at most DEADLOCK_EXAMPLES
+	const vector<vector<PnTokens> > &deadlockExamples() const
+		{return deadlockList;}
+
+	const vector<PnTokens> &bounds() const
+		{return placeBound;}
+
+	const vector<PnReachCheck> &checkResults() const
+		{return checks;}
+
+	// Number of bits of the packed markings
+	unsigned int markingBits() const
+		{return totalBits;}
+
+	// Expands the states of a chunk of the current level
+	void run( unsigned int chunk, unsigned int worker );
+
+	enum { DEADLOCK_EXAMPLES = 10 };
+
+private:
+	enum { SHARD_BITS = 8, CHUNK_STATES = 256 };
+
+	// Shard of the visited set: open addressing table of packed
+	// markings.  Word 0 of a marking always has bit 0 set so a
+	// zero word marks a free slot.
+	struct Shard
+	    {
+	    mutex lock;
+	    vector<uint64_t> slots;
+	    size_t capacity;
+	    size_t count;
+	    };
+
+	// Per worker state
+	struct Worker
+	    {
+	    vector<PnTokens> marking;
+	    vector<PnTokens> next;
+	    vector<uint64_t> key;
+	    vector<uint64_t> frontier;		// new states found
+	    vector<PnTokens> bound;
+	    unsigned long long edges;
+	    };
+
+	bool attempt();
+	void pack( const vector<PnTokens> &marking, uint64_t *key ) const;
+	void unpack( const uint64_t *key, vector<PnTokens> &marking ) const;
+	bool insert( const uint64_t *key );
+	void stateCheck( Worker &w, const vector<PnTokens> &marking );
+	void deadlockAdd( const vector<PnTokens> &marking );
+
+	const PnNetDef &def;
+	PnPool pool;
+	vector<Worker> workers;
+	Shard *shards;
+	bool immediates;	// the net has immediate transitions
+
+	// Layout of the packed markings.  A place left out has no
+	// bits.
+	vector<unsigned int> width;
+	vector<unsigned int> offset;
+	unsigned int totalBits;
+	unsigned int words;
+
+	// Places left out, computed back from their invariant and its
+	// sum in the initial marking
+	vector<unsigned int> pivot;
+	vector<PnInvariant> pivotInv;
+	vector<PnTokens> pivotSum;
+
+	// Exploration
+	vector<uint64_t> level;
+	atomic<unsigned long long> stored;
+	atomic<bool> stop;
+	vector<unsigned char> overflow;	// places which outgrew their bits
+	mutex resultLock;
+	unsigned long long maxStates;
+	bool truncated;
+
+	// Results
+	unsigned long long stateCount;
+	unsigned long long edgeCount;
+	unsigned int levelCount;
+	unsigned long long deadlockCount;
+	vector<vector<PnTokens> > deadlockList;
+	vector<PnTokens> placeBound;
+	vector<PnReachCheck> checks;
+
+};	// class PnReach
+
+#endif   //__PNREACH_H
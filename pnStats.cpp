@@ -0,0 +1,285 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Statistics
+*
+*  This file implements the online statistics described in
+*  pnStats.h.  The area under the count of a place is only brought
+*  up to date when the count changes or a snapshot is written, so
+*  a change costs a few additions whatever the size of the net.
+*  The simulator delivers the changes in time order, so a change
+*  past the end of an interval first writes the snapshots of the
+*  intervals it crossed.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnStats.h"	// class PnStats
+#include "mainsimu.h"	// MainSimulator::Instance().getParameter()
+#include "root.h"	// Root::Instance().stopTime()
+#include <stdlib.h>	// atexit(), atof()
+#include <limits.h>	// LLONG_MAX
+#include <map>
+
+/** private data **/
+
+// The statistics opened by pnStatsOpen()
+static map<string, PnStats *> openStats;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: statsClose
+* Description: Closes the statistics opened by pnStatsOpen() when
+* the program exits, the simulation having run until its stop time.
+********************************************************************/
+static void statsClose()
+{
+	double end = 0;
+
+	if( !( Root::Instance().stopTime() == Time::Inf ) )
+	    end = Root::Instance().stopTime().asMsecs() / 1000.0;
+
+	for( map<string, PnStats *>::iterator i = openStats.begin();
+	     i != openStats.end(); i++ )
+	    {
+	    i->second->close( end );
+	    delete i->second;
+	    }
+
+	openStats.clear();
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnStats constructor
+********************************************************************/
+PnStats::PnStats( const string &fileName, double span )
+: interval( span > 0 ? span : 0 )
+, next( span > 0 ? span : 0 )
+, last( 0 )
+{
+	file = fopen( fileName.c_str(), "w" );
+
+	if( file == NULL )
+	    throw PnNetError( "Cannot create the statistics file " + fileName );
+
+	fprintf( file, "time,scope,kind,name,mean,min,max,firings,rate\n" );
+}
+
+/*******************************************************************
+* Function Name: PnStats destructor
+********************************************************************/
+PnStats::~PnStats()
+{
+	close();
+}
+
+/*******************************************************************
+* Function Name: add
+********************************************************************/
+unsigned int PnStats::add( int kind, const string &name, PnTokens tokens )
+{
+	Entry entry;
+
+	entry.kind = kind;
+	entry.name = name;
+	entry.tokens = tokens;
+	entry.since = 0;
+	entry.area = entry.areaAll = 0;
+	entry.low = entry.lowAll = LLONG_MAX;
+	entry.high = entry.highAll = LLONG_MIN;
+	entry.fired = entry.firedAll = 0;
+
+	entries.push_back( entry );
+
+	return entries.size() - 1;
+}
+
+/*******************************************************************
+* Function Name: level
+* Description: Closes the period the previous count was held for.
+********************************************************************/
+void PnStats::level( unsigned int id, double time, PnTokens tokens )
+{
+	Entry &entry = entries[id];
+
+	advance( time );
+	hold( entry, time );
+	entry.tokens = tokens;
+}
+
+/*******************************************************************
+* Function Name: firing
+********************************************************************/
+void PnStats::firing( unsigned int id, double time )
+{
+	Entry &entry = entries[id];
+
+	advance( time );
+	entry.fired++;
+	entry.firedAll++;
+}
+
+/*******************************************************************
+* Function Name: close
+* Description: Writes the measures of the whole run, from time 0 to
+* its end.  The snapshots of the intervals ending before it are
+* written first.
+********************************************************************/
+void PnStats::close( double end )
+{
+	if( file == NULL )
+	    return;
+
+	advance( end );
+
+	for( unsigned int i = 0; i < entries.size(); i++ )
+	    {
+	    Entry &entry = entries[i];
+
+	    hold( entry, last );
+	    write( last, "total", entry, entry.areaAll, entry.lowAll,
+		   entry.highAll, entry.firedAll, last );
+	    }
+
+	fclose( file );
+	file = NULL;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: advance
+* Description: Writes the snapshots of the intervals ending at or
+* before a time, then restarts the measures of the interval.
+********************************************************************/
+void PnStats::advance( double time )
+{
+	while( interval > 0 && time >= next && file != NULL )
+	    {
+	    for( unsigned int i = 0; i < entries.size(); i++ )
+		{
+		Entry &entry = entries[i];
+
+		hold( entry, next );
+		write( next, "interval", entry, entry.area, entry.low,
+		       entry.high, entry.fired, interval );
+
+		entry.area = 0;
+		entry.low = LLONG_MAX;
+		entry.high = LLONG_MIN;
+		entry.fired = 0;
+		}
+
+	    next += interval;
+	    }
+
+	if( time > last )
+	    last = time;
+}
+
+/*******************************************************************
+* Function Name: hold
+* Description: Accounts for the count of a place being held from
+* the time it was reached until <time>.
+********************************************************************/
+void PnStats::hold( Entry &entry, double time )
+{
+	if( time <= entry.since )
+	    return;
+
+	double area = entry.tokens * ( time - entry.since );
+
+	entry.area += area;
+	entry.areaAll += area;
+
+	if( entry.tokens < entry.low )
+	    entry.low = entry.tokens;
+	if( entry.tokens > entry.high )
+	    entry.high = entry.tokens;
+	if( entry.tokens < entry.lowAll )
+	    entry.lowAll = entry.tokens;
+	if( entry.tokens > entry.highAll )
+	    entry.highAll = entry.tokens;
+
+	entry.since = time;
+}
+
+/*******************************************************************
+* Function Name: write
+* Description: Writes the line of a place or transition over a
+* period of <span> seconds.  A place which held no count for some
+* time, in a run of no length, reports its current count.
+********************************************************************/
+void PnStats::write( double time, const char *scope, const Entry &entry,
+		     double area, PnTokens low, PnTokens high,
+		     unsigned long fired, double span )
+{
+	fprintf( file, "%g,%s,%s,%s,", time, scope,
+		 entry.kind == PN_STATS_PLACE ? "place" : "trans",
+		 entry.name.c_str() );
+
+	if( entry.kind == PN_STATS_PLACE )
+	    {
+	    if( low > high )
+		low = high = entry.tokens;
+
+	    fprintf( file, "%g,%lld,%lld,,\n",
+		     span > 0 ? area / span : (double) entry.tokens, low, high );
+	    }
+	else
+	    fprintf( file, ",,,%lu,%g\n", fired, span > 0 ? fired / span : 0 );
+}
+
+/*******************************************************************
+* Function Name: pnStatsOpen
+* Description: Returns the statistics writing to a file.  The
+* interval given the first time is kept.
+********************************************************************/
+PnStats *pnStatsOpen( const string &fileName, double interval )
+{
+	map<string, PnStats *>::iterator i = openStats.find( fileName );
+
+	if( i != openStats.end() )
+	    return i->second;
+
+	if( openStats.empty() )
+	    atexit( statsClose );
+
+	PnStats *stats = new PnStats( fileName, interval );
+
+	openStats[fileName] = stats;
+
+	return stats;
+}
+
+/*******************************************************************
+* Function Name: pnStatsFromParameters
+* Description: Reads the [pnstats] section for the first model only;
+* the others get the statistics it opened.
+********************************************************************/
+PnStats *pnStatsFromParameters()
+{
+	static bool read = false;
+	static PnStats *stats = NULL;
+
+	if( read )
+	    return stats;
+
+	if( MainSimulator::Instance().existsParameter( "pnstats", "file" ))
+	    {
+	    double interval = 0;
+
+	    if( MainSimulator::Instance().existsParameter( "pnstats", "interval" ))
+		interval = atof( MainSimulator::Instance().getParameter \
+		 ( "pnstats", "interval" ).c_str() );
+
+	    stats = pnStatsOpen( MainSimulator::Instance().getParameter \
+	     ( "pnstats", "file" ), interval );
+	    }
+
+	read = true;
+
+	return stats;
+}
@@ -0,0 +1,122 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Statistics Header File
+*
+*  A PnStats accumulates the measures of the places and transitions
+*  while the simulation runs, so neither the log nor a trace has to
+*  be written and read again to get them:
+*
+*  - for a place, the time averaged number of tokens and the
+*    smallest and largest number held for some time;
+*  - for a transition, the number of firings and the firings per
+*    second.
+*
+*  A count which only lasts for an instant, such as a place going
+*  through several counts while the changes of the same time come
+*  in, is not taken as a minimum or maximum.
+*
+*  The measures are written to a text file in CSV form, one line
+*  per place or transition:
+*
+*  time,scope,kind,name,mean,min,max,firings,rate
+*
+*  where kind is "place" or "trans" and the columns which do not
+*  apply to the kind are left empty.  When an interval is given, a
+*  snapshot of the measures over the last interval is written every
+*  interval seconds with the scope "interval".  The summary of the
+*  whole run, with the scope "total", is written when the file is
+*  closed.  The run is taken to end at the stop time of the
+*  simulation, so the counts held at the end weigh for the time
+*  they lasted; without a stop time it ends with the last change.
+*
+*  The statistics are given to the models by the [pnstats] section
+*  of the .ma file:
+*
+*  [pnstats]
+*  file : pipeline.csv
+*  interval : 3600
+*
+*******************************************************************/
+
+#ifndef __PNSTATS_H
+#define __PNSTATS_H
+
+#include <stdio.h>	// FILE
+#include <string>
+#include <vector>
+#include "pnNetDef.h"	// PnTokens, class PnNetError
+
+// Kinds of entries
+#define PN_STATS_PLACE		0
+#define PN_STATS_TRANS		1
+
+// PnStats class
+
+class PnStats
+{
+public:
+	// Creates the file.  Throws a PnNetError if it cannot be
+	// created.  An interval of 0 writes no snapshot.
+	PnStats( const string &fileName, double interval );
+
+	// Closes the file
+	~PnStats();
+
+	// Adds a place holding <tokens> at time 0, or a transition,
+	// and returns its number
+	unsigned int add( int kind, const string &name, PnTokens tokens = 0 );
+
+	// Records the new count of a place
+	void level( unsigned int id, double time, PnTokens tokens );
+
+	// Records the firing of a transition
+	void firing( unsigned int id, double time );
+
+	// Writes the summary of the run up to <end>, or up to the last
+	// change if it came later.  Nothing can be recorded afterwards.
+	void close( double end = 0 );
+
+private:
+	// Measures of a place or transition, over the current
+	// interval and over the run
+	struct Entry
+	    {
+	    int kind;
+	    string name;
+	    PnTokens tokens;
+	    double since;		// time the count was reached
+	    double area;
+	    double areaAll;
+	    PnTokens low;
+	    PnTokens high;
+	    PnTokens lowAll;
+	    PnTokens highAll;
+	    unsigned long fired;
+	    unsigned long firedAll;
+	    };
+
+	void advance( double time );
+	void hold( Entry &entry, double time );
+	void write( double time, const char *scope, const Entry &entry,
+		    double area, PnTokens low, PnTokens high,
+		    unsigned long fired, double span );
+
+	FILE *file;
+	double interval;
+	double next;		// time of the next snapshot
+	double last;		// time of the last change or snapshot
+	vector<Entry> entries;
+
+};	// class PnStats
+
+// Returns the statistics writing to a file, creating them the first
+// time.  Every model naming the same file shares the same
+// statistics.  They are closed when the program exits.
+PnStats *pnStatsOpen( const string &fileName, double interval );
+
+// Returns the statistics of the [pnstats] section of the .ma file,
+// NULL without the section.  The section is only read by the first
+// call.  Throws a PnNetError if the file cannot be created.
+PnStats *pnStatsFromParameters();
+
+#endif   //__PNSTATS_H
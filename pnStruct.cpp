@@ -0,0 +1,752 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Structural Analysis
+*
+*  The Farkas algorithm starts from the rows [A | I], one per place
+*  (or transition), and cancels the columns of A one at a time by
+*  adding pairs of rows with coefficients of opposite signs.  The
+*  rows left when A is zero are the invariants.  The column with
+*  the fewest pairs is cancelled first, and a new row is only kept
+*  if no other row has a support included in its support (the
+*  adjacency test) so that only minimal invariants are built.  The
+*  rows are sparse: they only hold their non zero entries.
+*
+*  The siphons are found by a depth first search: starting from a
+*  single place, while some transition puts tokens in the set
+*  without taking any from it, one of its input places is added,
+*  each choice being a branch of the search.  The traps are the
+*  siphons of the reversed net.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnStruct.h"	// pnInvariantsP(), ...
+#include <algorithm>	// includes(), sort()
+#include <iterator>	// back_inserter()
+#include <map>
+#include <set>
+#include <stdlib.h>	// llabs()
+
+/** private types **/
+
+// Sparse vector: (index, value) pairs sorted by index
+typedef vector<pair<unsigned int, long long> > Sparse;
+
+// Row of the Farkas algorithm: the part of A not cancelled yet and
+// the invariant being built
+struct FarkasRow
+    {
+    Sparse a;
+    Sparse y;
+    PnPlaceSet support;		// indexes of y
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: gcd
+********************************************************************/
+static long long gcd( long long a, long long b )
+{
+	a = llabs( a );
+	b = llabs( b );
+
+	while( b != 0 )
+	    {
+	    long long r = a % b;
+	    a = b;
+	    b = r;
+	    }
+
+	return a;
+}
+
+/*******************************************************************
+* Function Name: sparseCombine
+* Description: Returns ka * a + kb * b, dropping the zero entries.
+* Throws a PnNetError if a coefficient overflows.
+********************************************************************/
+static Sparse sparseCombine( long long ka, const Sparse &a, long long kb, const Sparse &b )
+{
+	Sparse result;
+	unsigned int i = 0, j = 0;
+
+	while( i < a.size() || j < b.size() )
+	    {
+	    long long x = 0, y = 0, sum;
+	    unsigned int index;
+
+	    if( j == b.size() || ( i < a.size() && a[i].first < b[j].first ) )
+		{
+		index = a[i].first;
+		x = a[i++].second;
+		}
+	    else if( i == a.size() || b[j].first < a[i].first )
+		{
+		index = b[j].first;
+		y = b[j++].second;
+		}
+	    else
+		{
+		index = a[i].first;
+		x = a[i++].second;
+		y = b[j++].second;
+		}
+
+	    if( __builtin_mul_overflow( x, ka, &x ) ||
+		__builtin_mul_overflow( y, kb, &y ) ||
+		__builtin_add_overflow( x, y, &sum ) )
+		throw PnNetError( "Invariant coefficient overflow" );
+
+	    if( sum != 0 )
+		result.push_back( make_pair( index, sum ) );
+	    }
+
+	return result;
+}
+
+/*******************************************************************
+* Function Name: coefficient
+* Description: Returns the entry of a sparse vector, 0 if absent.
+********************************************************************/
+static long long coefficient( const Sparse &v, unsigned int index )
+{
+	for( unsigned int i = 0; i < v.size() && v[i].first <= index; i++ )
+	    if( v[i].first == index )
+		return v[i].second;
+
+	return 0;
+}
+
+// State of the Farkas algorithm.  The rows never change once built:
+// a cancelled column removes rows and adds new ones.  Every row is
+// listed under each column of its A part and under the first index
+// of its support, so the rows of a column and the rows whose support
+// may be included in a given one are found without a full scan.
+class Farkas
+{
+public:
+	Farkas( const vector<Sparse> &a, unsigned int maxRows );
+
+	void solve( vector<PnInvariant> &inv );
+
+private:
+	void rowAdd( const FarkasRow &row );
+	void rowKill( unsigned int r );
+	bool subsetFound( const PnPlaceSet &support, unsigned int skip1,
+			  unsigned int skip2, bool strict ) const;
+	FarkasRow combine( const FarkasRow &p, const FarkasRow &n, unsigned int col ) const;
+
+	vector<FarkasRow> rows;
+	vector<unsigned char> dead;
+	vector<vector<unsigned int> > colRows;
+	vector<vector<unsigned int> > firstRows;
+	vector<unsigned int> posCount;
+	vector<unsigned int> negCount;
+	unsigned int live;
+	unsigned int limit;
+
+};	// class Farkas
+
+/*******************************************************************
+* Function Name: Farkas constructor
+* Description: Starts from the rows [A | I].
+********************************************************************/
+Farkas::Farkas( const vector<Sparse> &a, unsigned int maxRows )
+: firstRows( a.size() )
+, live( 0 )
+, limit( maxRows )
+{
+	unsigned int i, columns = 0;
+
+	for( i = 0; i < a.size(); i++ )
+	    if( !a[i].empty() && a[i].back().first >= columns )
+		columns = a[i].back().first + 1;
+
+	colRows.resize( columns );
+	posCount.assign( columns, 0 );
+	negCount.assign( columns, 0 );
+
+	for( i = 0; i < a.size(); i++ )
+	    {
+	    FarkasRow row;
+
+	    row.a = a[i];
+	    row.y.push_back( make_pair( i, 1LL ) );
+	    row.support.push_back( i );
+	    rowAdd( row );
+	    }
+}
+
+/*******************************************************************
+* Function Name: solve
+* Description: Cancels the column producing the fewest new rows
+* until A is zero and returns the minimal rows left.
+********************************************************************/
+void Farkas::solve( vector<PnInvariant> &inv )
+{
+	unsigned int i, j, col;
+
+	for( ;; )
+	    {
+	    // A column cancelled with p positive and n negative rows
+	    // replaces p + n rows with at most p * n rows
+	    bool found = false;
+	    long long best = 0;
+
+	    col = 0;
+	    for( i = 0; i < colRows.size(); i++ )
+		if( posCount[i] + negCount[i] != 0 )
+		    {
+		    long long cost = (long long) posCount[i] * negCount[i] -
+				     posCount[i] - negCount[i];
+		    if( !found || cost < best )
+			{
+			found = true;
+			best = cost;
+			col = i;
+			}
+		    }
+
+	    if( !found )
+		break;
+
+	    vector<unsigned int> pos, neg;
+	    vector<FarkasRow> added;
+
+	    for( i = 0; i < colRows[col].size(); i++ )
+		{
+		unsigned int r = colRows[col][i];
+
+		if( !dead[r] )
+		    ( coefficient( rows[r].a, col ) > 0 ? pos : neg ).push_back( r );
+		}
+
+	    for( i = 0; i < pos.size(); i++ )
+		for( j = 0; j < neg.size(); j++ )
+		    {
+		    const FarkasRow &p = rows[pos[i]];
+		    const FarkasRow &n = rows[neg[j]];
+		    PnPlaceSet support;
+
+		    set_union( p.support.begin(), p.support.end(),
+			       n.support.begin(), n.support.end(),
+			       back_inserter( support ) );
+
+		    // Adjacency test: no other row may have a support
+		    // included in the support of the combination
+		    if( subsetFound( support, pos[i], neg[j], false ) )
+			continue;
+
+		    added.push_back( combine( p, n, col ) );
+
+		    if( live + added.size() > limit )
+			throw PnNetError( "Too many rows while computing the invariants" );
+		    }
+
+	    for( i = 0; i < pos.size(); i++ )
+		rowKill( pos[i] );
+	    for( i = 0; i < neg.size(); i++ )
+		rowKill( neg[i] );
+	    for( i = 0; i < added.size(); i++ )
+		rowAdd( added[i] );
+	    }
+
+	// Keep the rows whose support does not include another one
+	inv.clear();
+	for( i = 0; i < rows.size(); i++ )
+	    if( !dead[i] && !subsetFound( rows[i].support, i, i, true ) )
+		{
+		PnInvariant v;
+
+		for( j = 0; j < rows[i].y.size(); j++ )
+		    {
+		    v.index.push_back( rows[i].y[j].first );
+		    v.weight.push_back( rows[i].y[j].second );
+		    }
+		inv.push_back( v );
+		}
+}
+
+/*******************************************************************
+* Function Name: rowAdd
+********************************************************************/
+void Farkas::rowAdd( const FarkasRow &row )
+{
+	unsigned int r = rows.size();
+
+	rows.push_back( row );
+	dead.push_back( 0 );
+	live++;
+
+	firstRows[row.support[0]].push_back( r );
+	for( unsigned int i = 0; i < row.a.size(); i++ )
+	    {
+	    unsigned int col = row.a[i].first;
+
+	    colRows[col].push_back( r );
+	    if( row.a[i].second > 0 )
+		posCount[col]++;
+	    else
+		negCount[col]++;
+	    }
+}
+
+/*******************************************************************
+* Function Name: rowKill
+* Description: Removes a row.  It stays in the index lists, which
+* skip the dead rows, but its entries are freed.
+********************************************************************/
+void Farkas::rowKill( unsigned int r )
+{
+	FarkasRow &row = rows[r];
+
+	dead[r] = 1;
+	live--;
+
+	for( unsigned int i = 0; i < row.a.size(); i++ )
+	    if( row.a[i].second > 0 )
+		posCount[row.a[i].first]--;
+	    else
+		negCount[row.a[i].first]--;
+
+	Sparse().swap( row.a );
+	Sparse().swap( row.y );
+	PnPlaceSet().swap( row.support );
+}
+
+/*******************************************************************
+* Function Name: subsetFound
+* Description: Returns true if a live row other than skip1 and
+* skip2 has a support included in the given one.  With strict set
+* a row with the same support only counts if it comes first, so
+* one of several equal rows is kept.
+********************************************************************/
+bool Farkas::subsetFound( const PnPlaceSet &support, unsigned int skip1,
+			  unsigned int skip2, bool strict ) const
+{
+	for( unsigned int i = 0; i < support.size(); i++ )
+	    {
+	    const vector<unsigned int> &list = firstRows[support[i]];
+
+	    for( unsigned int j = 0; j < list.size(); j++ )
+		{
+		unsigned int r = list[j];
+
+		if( dead[r] || r == skip1 || r == skip2 ||
+		    rows[r].support.size() > support.size() ||
+		    !includes( support.begin(), support.end(),
+			       rows[r].support.begin(), rows[r].support.end() ) )
+		    continue;
+
+		if( !strict || rows[r].support != support || r < skip1 )
+		    return true;
+		}
+	    }
+
+	return false;
+}
+
+/*******************************************************************
+* Function Name: combine
+* Description: Adds a positive and a negative row so that the
+* column cancels and divides the result by the gcd of its entries.
+********************************************************************/
+FarkasRow Farkas::combine( const FarkasRow &p, const FarkasRow &n, unsigned int col ) const
+{
+	long long kp = -coefficient( n.a, col );
+	long long kn = coefficient( p.a, col );
+	long long g = gcd( kp, kn );
+	FarkasRow row;
+	unsigned int i;
+
+	kp /= g;
+	kn /= g;
+	row.a = sparseCombine( kp, p.a, kn, n.a );
+	row.y = sparseCombine( kp, p.y, kn, n.y );
+
+	long long d = 0;
+	for( i = 0; i < row.a.size(); i++ )
+	    d = gcd( d, row.a[i].second );
+	for( i = 0; i < row.y.size(); i++ )
+	    d = gcd( d, row.y[i].second );
+
+	if( d > 1 )
+	    {
+	    for( i = 0; i < row.a.size(); i++ )
+		row.a[i].second /= d;
+	    for( i = 0; i < row.y.size(); i++ )
+		row.y[i].second /= d;
+	    }
+
+	for( i = 0; i < row.y.size(); i++ )
+	    row.support.push_back( row.y[i].first );
+
+	return row;
+}
+
+/*******************************************************************
+* Function Name: incidence
+* Description: Builds the rows of the incidence matrix, one per
+* place (transposed false) or per transition (transposed true).
+********************************************************************/
+static void incidence( const PnNetDef &net, bool transposed, vector<Sparse> &rows )
+{
+	vector<map<unsigned int, long long> > dense( transposed ? net.transitions() : net.places() );
+	unsigned int t, a;
+
+	for( t = 0; t < net.transitions(); t++ )
+	    {
+	    for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		if( transposed )
+		    dense[t][net.prePlace[a]] -= net.preWeight[a];
+		else
+		    dense[net.prePlace[a]][t] -= net.preWeight[a];
+
+	    for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		if( transposed )
+		    dense[t][net.postPlace[a]] += net.postWeight[a];
+		else
+		    dense[net.postPlace[a]][t] += net.postWeight[a];
+	    }
+
+	rows.assign( dense.size(), Sparse() );
+	for( unsigned int i = 0; i < dense.size(); i++ )
+	    for( map<unsigned int, long long>::iterator e = dense[i].begin();
+		 e != dense[i].end(); e++ )
+		if( e->second != 0 )
+		    rows[i].push_back( *e );
+}
+
+// Depth first search of the siphons of a net given, for every
+// place, the transitions putting tokens in it and, for every
+// transition, the places it takes tokens from.  A search from a
+// place only adds places with a greater index: a minimal siphon is
+// found from its first place.
+class SiphonSearch
+{
+public:
+	SiphonSearch( const vector<vector<unsigned int> > &prod,
+		      const vector<vector<unsigned int> > &need,
+		      unsigned int limit )
+	: producers( prod ), needs( need ), nodes( 0 ), maxNodes( limit )
+	{}
+
+	bool search( vector<PnPlaceSet> &sets );
+
+private:
+	void expand( PnPlaceSet s, vector<unsigned int> pending );
+
+	const vector<vector<unsigned int> > &producers;
+	const vector<vector<unsigned int> > &needs;
+	set<PnPlaceSet> visited;
+	vector<PnPlaceSet> found;
+	unsigned int start;
+	unsigned int nodes;
+	unsigned int maxNodes;
+
+};	// class SiphonSearch
+
+/*******************************************************************
+* Function Name: search
+* Description: Searches the siphons from every place and keeps the
+* minimal ones.
+********************************************************************/
+bool SiphonSearch::search( vector<PnPlaceSet> &sets )
+{
+	unsigned int i, j;
+
+	for( start = 0; start < producers.size() && nodes < maxNodes; start++ )
+	    expand( PnPlaceSet( 1, start ), vector<unsigned int>( 1, start ) );
+
+	sort( found.begin(), found.end() );
+	sets.clear();
+	for( i = 0; i < found.size(); i++ )
+	    {
+	    bool minimal = true;
+
+	    for( j = 0; j < found.size() && minimal; j++ )
+		if( j != i && found[j] != found[i] &&
+		    includes( found[i].begin(), found[i].end(),
+			      found[j].begin(), found[j].end() ) )
+		    minimal = false;
+
+	    if( minimal && ( sets.empty() || sets.back() != found[i] ) )
+		sets.push_back( found[i] );
+	    }
+
+	return nodes < maxNodes;
+}
+
+/*******************************************************************
+* Function Name: expand
+* Description: Looks among the producers of the pending places for
+* a transition breaking the siphon property of a set, and adds one
+* of its input places.  A single choice is taken in place; several
+* choices are branches of the search, each set being expanded once.
+* Sets including a siphon already found are not expanded: they
+* cannot lead to a smaller one.
+********************************************************************/
+void SiphonSearch::expand( PnPlaceSet s, vector<unsigned int> pending )
+{
+	unsigned int i, k;
+
+	while( nodes < maxNodes )
+	    {
+	    int bad = -1;
+
+	    while( !pending.empty() && bad < 0 )
+		{
+		const vector<unsigned int> &prod = producers[pending.back()];
+
+		for( i = 0; i < prod.size() && bad < 0; i++ )
+		    {
+		    const vector<unsigned int> &in = needs[prod[i]];
+		    bool takes = false;
+
+		    for( k = 0; k < in.size() && !takes; k++ )
+			takes = binary_search( s.begin(), s.end(), in[k] );
+
+		    if( !takes )
+			bad = prod[i];
+		    }
+
+		if( bad < 0 )
+		    pending.pop_back();
+		}
+
+	    if( bad < 0 )
+		{
+		found.push_back( s );
+		return;
+		}
+
+	    vector<unsigned int> choices;
+	    for( k = 0; k < needs[bad].size(); k++ )
+		if( needs[bad][k] > start )
+		    choices.push_back( needs[bad][k] );
+
+	    sort( choices.begin(), choices.end() );
+	    choices.erase( unique( choices.begin(), choices.end() ), choices.end() );
+
+	    if( choices.size() == 1 )
+		{
+		s.insert( lower_bound( s.begin(), s.end(), choices[0] ), choices[0] );
+		pending.push_back( choices[0] );
+		nodes++;
+		continue;
+		}
+
+	    if( !visited.insert( s ).second )
+		return;
+
+	    for( i = 0; i < found.size(); i++ )
+		if( includes( s.begin(), s.end(), found[i].begin(), found[i].end() ) )
+		    return;
+
+	    for( k = 0; k < choices.size() && nodes < maxNodes; k++ )
+		{
+		PnPlaceSet bigger( s );
+		vector<unsigned int> next( pending );
+
+		bigger.insert( lower_bound( bigger.begin(), bigger.end(), choices[k] ), choices[k] );
+		next.push_back( choices[k] );
+		nodes++;
+		expand( bigger, next );
+		}
+
+	    return;
+	    }
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnInvariantsP
+********************************************************************/
+void pnInvariantsP( const PnNetDef &net, vector<PnInvariant> &inv,
+		    unsigned int maxRows )
+{
+	vector<Sparse> rows;
+
+	incidence( net, false, rows );
+	Farkas( rows, maxRows ).solve( inv );
+}
+
+/*******************************************************************
+* Function Name: pnInvariantsT
+********************************************************************/
+void pnInvariantsT( const PnNetDef &net, vector<PnInvariant> &inv,
+		    unsigned int maxRows )
+{
+	vector<Sparse> rows;
+
+	incidence( net, true, rows );
+	Farkas( rows, maxRows ).solve( inv );
+}
+
+/*******************************************************************
+* Function Name: pnInvariantSum
+********************************************************************/
+PnTokens pnInvariantSum( const PnInvariant &inv, const vector<PnTokens> &marking )
+{
+	PnTokens sum = 0;
+
+	for( unsigned int i = 0; i < inv.index.size(); i++ )
+	    sum += inv.weight[i] * marking[inv.index[i]];
+
+	return sum;
+}
+
+/*******************************************************************
+* Function Name: pnNetSafe
+* Description: A P-invariant y with y.M0 = k bounds place p to
+* k / y(p) tokens.  The net is safe when each place has a bound of
+* at most one.  The invariants cost much more than the whole run of
+* some nets, so the nets which cheaper tests reject never get to
+* them.
+********************************************************************/
+bool pnNetSafe( const PnNetDef &net, unsigned int maxRows )
+{
+	vector<PnInvariant> inv;
+	vector<bool> safe( net.places(), false );
+	unsigned int i, j;
+
+	for( i = 0; i < net.places(); i++ )
+	    if( net.initMarking[i] > 1 )
+		return false;
+
+	for( i = 0; i < net.preWeight.size(); i++ )
+	    if( net.preWeight[i] > 1 )
+		return false;
+
+	for( i = 0; i < net.postWeight.size(); i++ )
+	    if( net.postWeight[i] > 1 )
+		return false;
+
+	// The masks of safe mode hold one bit per place: two arcs
+	// between a transition and a place would count as one
+	vector<unsigned int> seenPre( net.places(), 0 );
+	vector<unsigned int> seenPost( net.places(), 0 );
+
+	for( i = 0; i < net.transitions(); i++ )
+	    {
+	    for( j = net.preStart[i]; j < net.preStart[i + 1]; j++ )
+		{
+		if( seenPre[net.prePlace[j]] == i + 1 )
+		    return false;
+		seenPre[net.prePlace[j]] = i + 1;
+		}
+
+	    for( j = net.postStart[i]; j < net.postStart[i + 1]; j++ )
+		{
+		if( seenPost[net.postPlace[j]] == i + 1 )
+		    return false;
+		seenPost[net.postPlace[j]] = i + 1;
+		}
+	    }
+
+	// A reachable marking with two tokens in a place proves no
+	// invariant bounds it.  A few sweeps of the token game, each
+	// firing in turn the transitions it finds enabled, find one
+	// in most unsafe nets for a few passes over the arcs.
+	vector<PnTokens> marking( net.initMarking );
+
+	for( unsigned int sweep = 0; sweep < 8; sweep++ )
+	    for( i = 0; i < net.transitions(); i++ )
+		{
+		bool enabled = true;
+
+		for( j = net.preStart[i]; j < net.preStart[i + 1] && enabled; j++ )
+		    if( net.preWeight[j] == 0 ? marking[net.prePlace[j]] != 0 :
+			marking[net.prePlace[j]] < net.preWeight[j] )
+			enabled = false;
+
+		if( !enabled )
+		    continue;
+
+		for( j = net.preStart[i]; j < net.preStart[i + 1]; j++ )
+		    marking[net.prePlace[j]] -= net.preWeight[j];
+
+		for( j = net.postStart[i]; j < net.postStart[i + 1]; j++ )
+		    if( ++marking[net.postPlace[j]] > 1 )
+			return false;
+		}
+
+	try
+	   {
+	   pnInvariantsP( net, inv, maxRows );
+	   }
+	catch( PnNetError & )
+	   {
+	   return false;
+	   }
+
+	for( i = 0; i < inv.size(); i++ )
+	    {
+	    PnTokens sum = pnInvariantSum( inv[i], net.initMarking );
+
+	    for( j = 0; j < inv[i].index.size(); j++ )
+		if( sum / inv[i].weight[j] <= 1 )
+		    safe[inv[i].index[j]] = true;
+	    }
+
+	for( i = 0; i < net.places(); i++ )
+	    if( !safe[i] )
+		return false;
+
+	return true;
+}
+
+/*******************************************************************
+* Function Name: pnSiphons
+* Description: A set is a siphon when every transition with an
+* output arc to it has an input arc from it.
+********************************************************************/
+bool pnSiphons( const PnNetDef &net, vector<PnPlaceSet> &sets,
+		unsigned int maxNodes )
+{
+	vector<vector<unsigned int> > producers( net.places() );
+	vector<vector<unsigned int> > needs( net.transitions() );
+	unsigned int t, a;
+
+	for( t = 0; t < net.transitions(); t++ )
+	    {
+	    for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		producers[net.postPlace[a]].push_back( t );
+	    for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		if( net.preWeight[a] != 0 )
+		    needs[t].push_back( net.prePlace[a] );
+	    }
+
+	SiphonSearch search( producers, needs, maxNodes );
+
+	return search.search( sets );
+}
+
+/*******************************************************************
+* Function Name: pnTraps
+* Description: A set is a trap when every transition with an input
+* arc from it has an output arc to it: a siphon of the net with
+* its arcs reversed.
+********************************************************************/
+bool pnTraps( const PnNetDef &net, vector<PnPlaceSet> &sets,
+	      unsigned int maxNodes )
+{
+	vector<vector<unsigned int> > consumers( net.places() );
+	vector<vector<unsigned int> > outputs( net.transitions() );
+	unsigned int t, a;
+
+	for( t = 0; t < net.transitions(); t++ )
+	    {
+	    for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		if( net.preWeight[a] != 0 )
+		    consumers[net.prePlace[a]].push_back( t );
+	    for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		outputs[t].push_back( net.postPlace[a] );
+	    }
+
+	SiphonSearch search( consumers, outputs, maxNodes );
+
+	return search.search( sets );
+}
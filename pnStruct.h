@@ -0,0 +1,71 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Structural Analysis Header File
+*
+*  These functions analyse the structure of a net, its incidence
+*  matrix C = Post - Pre, without exploring its markings.
+*
+*  A P-invariant is a vector y >= 0 of place weights with y.C = 0:
+*  the weighted sum of the tokens of its places never changes.  A
+*  T-invariant is a vector x >= 0 of transition counts with C.x = 0:
+*  firing each transition that many times restores the marking.
+*  Both are computed with the Farkas algorithm on sparse integer
+*  rows and only the minimal support invariants are kept.
+*
+*  A siphon is a set of places S such that every transition putting
+*  tokens in S takes tokens from S: once empty it stays empty and
+*  every transition taking tokens from it is dead.  A trap is a set
+*  of places such that every transition taking tokens from it puts
+*  tokens back: once marked it stays marked.  Only the minimal ones
+*  are computed.  Inhibitor arcs take no token so they are ignored
+*  by the incidence matrix, the siphons and the traps.
+*
+*******************************************************************/
+
+#ifndef __PNSTRUCT_H
+#define __PNSTRUCT_H
+
+#include <vector>
+#include "pnNetDef.h"	// class PnNetDef
+
+// Invariant: the indexes (places or transitions) of its support
+// and their weights
+struct PnInvariant
+    {
+    vector<unsigned int> index;
+    vector<long long> weight;
+    };
+
+// Set of places, sorted
+typedef vector<unsigned int> PnPlaceSet;
+
+// Computes the minimal P-invariants (place weights) or T-invariants
+// (transition counts) of a net.  Throws a PnNetError when there are
+// more than maxRows intermediate rows or a coefficient overflows.
+void pnInvariantsP( const PnNetDef &net, vector<PnInvariant> &inv,
+		    unsigned int maxRows = 100000 );
+void pnInvariantsT( const PnNetDef &net, vector<PnInvariant> &inv,
+		    unsigned int maxRows = 100000 );
+
+// Returns the weighted sum of the tokens of the places of a
+// P-invariant in a marking
+PnTokens pnInvariantSum( const PnInvariant &inv, const vector<PnTokens> &marking );
+
+// Returns true if the P-invariants prove the net 1-safe: every
+// place is covered by an invariant bounding it to one token and
+// every arc has a weight of one.  Nets with two arcs between the
+// same transition and place, or reaching a marking with more than
+// one token in a few steps of the token game, are refused before
+// computing any invariant.  Gives up, returning false, when the
+// invariants need more than maxRows intermediate rows.
+bool pnNetSafe( const PnNetDef &net, unsigned int maxRows = 100000 );
+
+// Computes the minimal siphons or traps of a net.  Returns false if
+// the search was stopped after maxNodes steps, the sets found so
+// far being minimal but maybe not all of them.
+bool pnSiphons( const PnNetDef &net, vector<PnPlaceSet> &sets,
+		unsigned int maxNodes = 1000000 );
+bool pnTraps( const PnNetDef &net, vector<PnPlaceSet> &sets,
+	      unsigned int maxNodes = 1000000 );
+
+#endif   //__PNSTRUCT_H
@@ -2,5 +2,5 @@
 
 simu -mpnTest4_hpx.ma -lpnTest4_hpx.log -w10-3 -t00:10:00:000
 
-"C:\Program Files\Tcl\bin\wish80.exe" pnmark.tcl pnTest4_hpx.ma pnTest4_hpx.log pnTest4_hpx.pn 
+pnmark pnTest4_hpx.ma pnTest4_hpx.log pnTest4_hpx.pn 
 pause
\ No newline at end of file
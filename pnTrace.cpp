@@ -0,0 +1,199 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Binary Trace
+*
+*  This file implements the writer of the binary traces described
+*  in pnTrace.h.  The records are buffered and appended to the file
+*  a buffer at a time; the header and the names are only written
+*  when the trace is closed.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnTrace.h"	// class PnTrace
+#include "mainsimu.h"	// MainSimulator::Instance().getParameter()
+#include <string.h>	// memcpy()
+#include <stdlib.h>	// atexit()
+#include <map>
+
+/** private data **/
+
+// The traces opened by pnTraceOpen()
+static map<string, PnTrace *> openTraces;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: tracesClose
+* Description: Closes the traces opened by pnTraceOpen() when the
+* program exits.
+********************************************************************/
+static void tracesClose()
+{
+	for( map<string, PnTrace *>::iterator i = openTraces.begin();
+	     i != openTraces.end(); i++ )
+	    delete i->second;
+
+	openTraces.clear();
+}
+
+/*******************************************************************
+* Function Name: headerWrite
+* Description: Writes the header at the beginning of the file.
+********************************************************************/
+static bool headerWrite( FILE *file, uint64_t records, uint64_t namesOffset )
+{
+	PnTraceHeader header;
+
+	memset( &header, 0, sizeof( header ) );
+	memcpy( header.magic, PN_TRACE_MAGIC, sizeof( PN_TRACE_MAGIC ) );
+	header.version = PN_TRACE_VERSION;
+	header.recordSize = sizeof( PnTraceRecord );
+	header.records = records;
+	header.namesOffset = namesOffset;
+
+	return fseek( file, 0, SEEK_SET ) == 0 &&
+	       fwrite( &header, sizeof( header ), 1, file ) == 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: PnTrace constructor
+* Description: Creates the file and writes a header telling the
+* trace is not closed yet.
+********************************************************************/
+PnTrace::PnTrace( const string &fileName )
+: failed( false )
+, used( 0 )
+, records( 0 )
+{
+	file = fopen( fileName.c_str(), "wb" );
+
+	if( file == NULL || !headerWrite( file, 0, 0 ) )
+	    throw PnNetError( "Cannot create the trace file " + fileName );
+}
+
+/*******************************************************************
+* Function Name: PnTrace destructor
+********************************************************************/
+PnTrace::~PnTrace()
+{
+	close();
+}
+
+/*******************************************************************
+* Function Name: name
+* Description: Stores the name of a place or transition.  The names
+* are written when the trace is closed.
+********************************************************************/
+void PnTrace::name( int kind, int id, const string &text )
+{
+	PnTraceName entry;
+
+	entry.kind = kind;
+	entry.id = id;
+	entry.length = text.size();
+
+	names.push_back( entry );
+	nameText += text;
+}
+
+/*******************************************************************
+* Function Name: close
+* Description: Appends the records left in the buffer and the
+* names, then writes the final header.  After a failed write the
+* header keeps a zero name offset, so the trace reads as one which
+* was not closed.
+********************************************************************/
+void PnTrace::close()
+{
+	if( file == NULL )
+	    return;
+
+	flush();
+
+	uint64_t namesOffset = sizeof( PnTraceHeader ) + records * sizeof( PnTraceRecord );
+	string::size_type text = 0;
+
+	for( unsigned int i = 0; i < names.size() && !failed; i++ )
+	    {
+	    if( fwrite( &names[i], sizeof( PnTraceName ), 1, file ) != 1 ||
+		fwrite( nameText.data() + text, 1, names[i].length, file ) != names[i].length )
+		failed = true;
+	    text += names[i].length;
+	    }
+
+	if( fflush( file ) != 0 )
+	    failed = true;
+
+	headerWrite( file, records, failed ? 0 : namesOffset );
+	fclose( file );
+	file = NULL;
+}
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: flush
+* Description: Appends the buffered records to the file.  Only the
+* records written in full are counted; after a short write the
+* records are dropped.
+********************************************************************/
+void PnTrace::flush()
+{
+	if( used != 0 && file != NULL && !failed )
+	    {
+	    size_t written = fwrite( buffer, sizeof( PnTraceRecord ), used, file );
+
+	    records += written;
+	    if( written != used )
+		failed = true;
+	    }
+
+	used = 0;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: pnTraceOpen
+* Description: Returns the trace of a file, creating it if needed.
+********************************************************************/
+PnTrace *pnTraceOpen( const string &fileName )
+{
+	map<string, PnTrace *>::iterator i = openTraces.find( fileName );
+
+	if( i != openTraces.end() )
+	    return i->second;
+
+	if( openTraces.empty() )
+	    atexit( tracesClose );
+
+	PnTrace *trace = new PnTrace( fileName );
+	openTraces[fileName] = trace;
+
+	return trace;
+}
+
+/*******************************************************************
+* Function Name: pnTraceFromParameters
+* Description: Reads the [pntrace] section for the first model only;
+* the others get the trace it opened.
+********************************************************************/
+PnTrace *pnTraceFromParameters()
+{
+	static bool read = false;
+	static PnTrace *trace = NULL;
+
+	if( read )
+	    return trace;
+
+	if( MainSimulator::Instance().existsParameter( "pntrace", "file" ))
+	    trace = pnTraceOpen( MainSimulator::Instance().getParameter \
+	     ( "pntrace", "file" ) );
+
+	read = true;
+
+	return trace;
+}
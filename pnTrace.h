@@ -0,0 +1,141 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Binary Trace Header File
+*
+*  A binary trace records the firings of the transitions and the
+*  changes of the markings of the places as fixed width records,
+*  instead of the text log of the simulator.  The file is made of:
+*
+*  - a header (PnTraceHeader, 32 bytes)
+*  - the records (PnTraceRecord, 24 bytes each) in the order they
+*    happened, appended through a buffer as the simulation runs
+*  - the names of the places and transitions, written when the
+*    trace is closed
+*
+*  A record is either the firing of a transition (place is
+*  PN_TRACE_NONE and delta is 1) or a change of the number of
+*  tokens of a place by delta.  The transition of a change is
+*  given when it is known, otherwise it is PN_TRACE_NONE and the
+*  change belongs to the last firing of the same time.  The
+*  numbers of the places and transitions are the ones of the
+*  writer: model IDs for PnPlace and PnTrans, indexes in the net
+*  for PnNet.
+*
+*  The header is rewritten when the trace is closed with the number
+*  of records and the offset of the names.  A trace which was not
+*  closed has a zero name offset; its records are still readable
+*  since they are all complete records of the same size.  A trace
+*  whose file could not be written, e.g. on a full disk, stops
+*  recording and is left with a zero name offset too, the header
+*  counting the records written in full.  The file
+*  can be mapped in memory and read in place (see pntrace.cpp).
+*
+*  Numbers are written in the byte order of the machine.
+*
+*******************************************************************/
+
+#ifndef __PNTRACE_H
+#define __PNTRACE_H
+
+#include <stdio.h>	// FILE
+#include <stdint.h>	// int32_t, ...
+#include <string>
+#include <vector>
+#include "pnNetDef.h"	// class PnNetError
+
+#define PN_TRACE_MAGIC		"PNTRACE"
+#define PN_TRACE_VERSION	1
+#define PN_TRACE_NONE		(-1)
+
+// Kinds of names
+#define PN_TRACE_PLACE		0
+#define PN_TRACE_TRANS		1
+
+struct PnTraceHeader
+    {
+    char magic[8];		// PN_TRACE_MAGIC
+    uint32_t version;		// PN_TRACE_VERSION
+    uint32_t recordSize;	// sizeof( PnTraceRecord )
+    uint64_t records;		// number of records
+    uint64_t namesOffset;	// offset of the names, 0 if not closed
+    };
+
+struct PnTraceRecord
+    {
+    double time;		// seconds
+    int32_t trans;		// transition, PN_TRACE_NONE if unknown
+    int32_t place;		// place, PN_TRACE_NONE for a firing
+    int64_t delta;		// change of the number of tokens
+    };
+
+// Entry of the name table.  The name follows, length bytes long.
+struct PnTraceName
+    {
+    int32_t kind;		// PN_TRACE_PLACE or PN_TRACE_TRANS
+    int32_t id;
+    uint32_t length;
+    };
+
+// PnTrace class
+
+class PnTrace
+{
+public:
+	// Creates the trace file.  Throws a PnNetError if it cannot
+	// be created.
+	PnTrace( const string &fileName );
+
+	// Closes the trace
+	~PnTrace();
+
+	// Gives a name to a place or transition number
+	void name( int kind, int id, const string &text );
+
+	void firing( double time, int trans )
+		{record( time, trans, PN_TRACE_NONE, 1 );}
+
+	void change( double time, int trans, int place, long long delta )
+		{record( time, trans, place, delta );}
+
+	// Writes the buffered records, the names and the final
+	// header.  Nothing can be recorded afterwards.
+	void close();
+
+private:
+	enum { BUFFER_RECORDS = 4096 };
+
+	void record( double time, int trans, int place, long long delta )
+		{
+		if( used == BUFFER_RECORDS )
+		    flush();
+
+		buffer[used].time = time;
+		buffer[used].trans = trans;
+		buffer[used].place = place;
+		buffer[used].delta = delta;
+		used++;
+		}
+
+	void flush();
+
+	FILE *file;
+	bool failed;		// a write failed, nothing more is written
+	PnTraceRecord buffer[BUFFER_RECORDS];
+	unsigned int used;
+	uint64_t records;
+	vector<PnTraceName> names;
+	string nameText;
+
+};	// class PnTrace
+
+// Returns the trace writing to a file, creating it the first time.
+// Every model naming the same file shares the same trace.  The
+// traces are closed when the program exits.
+PnTrace *pnTraceOpen( const string &fileName );
+
+// Returns the trace of the [pntrace] section of the .ma file, NULL
+// without the section.  The section is only read by the first call.
+// Throws a PnNetError if the file cannot be created.
+PnTrace *pnTraceFromParameters();
+
+#endif   //__PNTRACE_H
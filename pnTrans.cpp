@@ -50,6 +50,48 @@
 *  places which have their <fired> input port connected to this
 *  port.
 *
+*  Arcs of a weight greater than four use extra ports declared
+*  with the "inweights" and "outweights" parameters.  For instance
+*  "inweights : 6" adds an <in6> input port for arcs taking six 
+*  tokens from their place and "outweights : 5 12" adds the <out5> 
+*  and <out12> output ports depositing five and twelve tokens.  
+*  Tokens are only sent on the output ports which are linked to a
+*  place.
+*
+*  A transition has enabling memory, as the transitions of PnNet
+*  (see pnEngine.h): the delay is drawn when the transition becomes
+*  enabled or fires and stays enabled, and the firing it schedules
+*  stands while the transition remains enabled, whatever its input
+*  places advertise meanwhile.  It is cancelled when the transition
+*  is disabled.
+*
+*  The firing delays follow the distribution given by the "delay"
+*  parameter, one of "deterministic D", "uniform A B", 
+*  "exponential M" or "discrete A B" in seconds (see pnRandom.h).
+*  The default is "discrete 1 60".  An "immediate" transition
+*  fires after a zero delay, through the event queue: its 
+*  "priority" and "weight" parameters are only honoured by PnNet.
+*  The "seed" parameter, or the "seed" parameter of the [pnrandom]
+*  section for all transitions, makes the delays reproducible.
+*
+*  When the "file" parameter of the [pntrace] section is set, every
+*  firing is recorded in that binary trace file (see pnTrace.h).
+*  When the "file" parameter of the [pnstats] section is set, the
+*  firings are counted as they happen and their number and rate
+*  written to that file (see pnStats.h).
+*
+*  When the "file" parameter of the [pnprofile] section is set, the
+*  messages, firings, cancelled firings, delays drawn and input
+*  places of the transition are counted, and with "timing" the time
+*  spent in its functions measured, and written to that file (see
+*  pnProfile.h).
+*
+*  When the [pncheckpoint] section is set, the input places, the
+*  number of delays drawn and the time of the next firing are saved
+*  in, or loaded from, a checkpoint (see pnCheckpoint.h).  A
+*  transition loaded from a checkpoint keeps the firing it had
+*  scheduled.
+*
 *  AUTHOR: Christian Jacques
 *
 *  EMAIL: chris.jacques@videotron.ca
@@ -63,24 +105,31 @@
 #include "message.h"    // class ExternalMessage, InternalMessage
 #include "mainsimu.h"   // MainSimulator::Instance().getParameter( ... )
 #include "time.h"	// class Time
-#include "realfunc.h"   // trunc()
-#include "real.h"   	// class Real
+#include "pnMsg.h"   	// pnMsgEncode(), pnMsgDecode()
+#include "pnTrace.h"   	// pnTraceFromParameters()
+#include "pnStats.h"   	// pnStatsFromParameters()
+#include "pnProfile.h"   	// pnProfileFromParameters()
+#include "pnCheckpoint.h"   	// pnCheckpointSave(), pnCheckpointLoad()
 #include "except.h"   	// for exceptions
+#include "strutil.h"   	// str2Int(), int2Str()
 #include <C:\cygwin\usr\include\time.h>	// time()
-#include <stdlib.h>	// srand(), rand()
-
-static unsigned int inPlaces;	// This variable indicates the maximum 
-				// number of inputs places this transition 
-				// can deal with.
+#include <stdlib.h>	// strtoull(), atof()
+#include <sstream>	// istringstream
 
 /** public functions **/
 
 /*******************************************************************
 * Function Name: PnTrans constructor
 * Description: This routine constructs the PnTrans model.  In 
-* addition to creating the ports, it allocates the memory to
-* store the array of input places used by the transition.  Also,
-* the number of input places is initialized to zero.
+* addition to creating the ports, including the ones for the weights
+* listed in the "inweights" and "outweights" parameters, it 
+* reserves the memory to
+* store the input places used by the transition when their 
+* number is given by the "inputplaces" parameter.  The storage
+* then has exactly the size needed by this transition and the
+* parameter is the maximum number of input places allowed.
+* Without the parameter the storage grows as input places are 
+* discovered.
 ********************************************************************/
 PnTrans::PnTrans( const string &name )
 : Atomic( name )
@@ -96,19 +145,129 @@ PnTrans::PnTrans( const string &name )
 , fired( addOutputPort( "fired" ) )
 {
 
+	unsigned int weight;
+
+	// Ports of the usual weights
+	inPorts.push_back( &in0 );
+	inPorts.push_back( &in1 );
+	inPorts.push_back( &in2 );
+	inPorts.push_back( &in3 );
+	inPorts.push_back( &in4 );
+	for( weight = 0; weight <= 4; weight++ )
+	    inWeights.push_back( weight );
+
+	outPorts.push_back( &out1 );
+	outPorts.push_back( &out2 );
+	outPorts.push_back( &out3 );
+	outPorts.push_back( &out4 );
+	for( weight = 1; weight <= 4; weight++ )
+	    outWeights.push_back( weight );
+
+	// Ports of the declared weights
+	if( MainSimulator::Instance().existsParameter( description(), 
+	    "inweights" ))
+	   {
+	   istringstream weights( MainSimulator::Instance().getParameter \
+	    ( description(), "inweights" ) );
+
+	   while( weights >> weight )
+		if( weight > 4 )
+		    {
+		    inPorts.push_back( &addInputPort( string("in") + \
+			int2Str( weight ) ) );
+		    inWeights.push_back( weight );
+		    }
+	   }
+
+	if( MainSimulator::Instance().existsParameter( description(), 
+	    "outweights" ))
+	   {
+	   istringstream weights( MainSimulator::Instance().getParameter \
+	    ( description(), "outweights" ) );
+
+	   while( weights >> weight )
+		if( weight > 4 )
+		    {
+		    outPorts.push_back( &addOutputPort( string("out") + \
+			int2Str( weight ) ) );
+		    outWeights.push_back( weight );
+		    }
+	   }
+
 	if( MainSimulator::Instance().existsParameter( description(), 
 	    "inputplaces" ))
-	   inPlaces = str2Int( MainSimulator::Instance().getParameter \
+	   maxInputs = str2Int( MainSimulator::Instance().getParameter \
 	    ( description(), "inputplaces" ) );
 	else
-	   // The default is to allocate for ten input places
-	   // (for this transition alone) which should be 
-	   // more than enough.
-	   inPlaces = 10;
+	   maxInputs = 0;
+
+	inPlaces.reserve( maxInputs );
+	slotIndex.assign( 4, -1 );
+	while( slotIndex.size() < 2 * maxInputs )
+	    slotIndex.resize( 2 * slotIndex.size(), -1 );
+
+	unsatisfied = 0;
+	transEnabled = false;
+	fireTime = -1;
 
-	pArrayStart = new( inputPlaceInfo[inPlaces] );
+	// Distribution of the firing delays
+	delay = pnDelayDefault();
 
-	numOfInputs = 0;
+	if( MainSimulator::Instance().existsParameter( description(), 
+	    "delay" ) && !pnDelayParse( MainSimulator::Instance(). \
+	    getParameter( description(), "delay" ), delay ))
+	   {
+	   MException e( string("Invalid delay parameter for transition ") \
+	       + description() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
+
+	// The seed is given to the transition, or to every 
+	// transition in the [pnrandom] section.  Without a seed 
+	// the real time clock is used so every run is different.
+	if( MainSimulator::Instance().existsParameter( description(), 
+	    "seed" ))
+	   seed = strtoull( MainSimulator::Instance().getParameter \
+	    ( description(), "seed" ).c_str(), NULL, 10 );
+	else if( MainSimulator::Instance().existsParameter( "pnrandom", 
+	    "seed" ))
+	   seed = strtoull( MainSimulator::Instance().getParameter \
+	    ( "pnrandom", "seed" ).c_str(), NULL, 10 );
+	else
+	   seed = (unsigned long long) time( NULL );
+
+	draws = 0;
+
+	saved = NULL;
+	loaded = NULL;
+
+	try
+	   {
+	   trace = pnTraceFromParameters();
+	   stats = pnStatsFromParameters();
+	   profile = pnProfileFromParameters();
+
+	   if( MainSimulator::Instance().existsParameter( "pncheckpoint", "save" ))
+	      {
+	      if( !MainSimulator::Instance().existsParameter( "pncheckpoint", "at" ))
+		 throw PnNetError( "The at parameter of the pncheckpoint section is missing" );
+
+	      saved = pnCheckpointSave( MainSimulator::Instance().getParameter \
+	       ( "pncheckpoint", "save" ), atof( MainSimulator::Instance(). \
+	       getParameter( "pncheckpoint", "at" ).c_str() ) );
+	      }
+
+	   if( MainSimulator::Instance().existsParameter( "pncheckpoint", "load" ))
+	      loaded = pnCheckpointLoad( MainSimulator::Instance().getParameter \
+	       ( "pncheckpoint", "load" ) );
+	   }
+	catch( PnNetError &err )
+	   {
+	   MException e( err.message() );
+	   e.addLocation( MEXCEPTION_LOCATION() );
+	   throw e;
+	   }
 }
 
 /*******************************************************************
@@ -118,11 +277,43 @@ PnTrans::PnTrans( const string &name )
 * This is necessary in case the transition is a source.  That is,
 * it is always enabled.  If it is not, external messages will
 * come in from input places at simulation time 0 such that this 
-* scheduled internal event will never occur.
+* scheduled internal event will never occur.  A transition loaded
+* from a checkpoint takes its state from it instead.
 ********************************************************************/
 Model &PnTrans::initFunction()
 {
-	holdIn( active, (float) this->randNumGet() );
+	// The links are known by now.  Keep the output ports which
+	// are linked to a place so firings only send on them.
+	linkedOuts.clear();
+	linkedWeights.clear();
+	for( unsigned int i = 0; i < outPorts.size(); i++ )
+	    if( !outPorts[i]->influences().empty() )
+		{
+		linkedOuts.push_back( outPorts[i] );
+		linkedWeights.push_back( outWeights[i] );
+		}
+
+	if( trace != NULL )
+	    trace->name( PN_TRACE_TRANS, Model::id(), description() );
+
+	if( stats != NULL )
+	    statsId = stats->add( PN_STATS_TRANS, description() );
+
+	if( profile != NULL )
+	    profileId = profile->add( PN_PROFILE_TRANS, description(), maxInputs );
+
+	if( saved != NULL )
+	    savedId = saved->transAdd( description() );
+
+	if( loaded != NULL )
+	    stateLoad();
+	else
+	    {
+	    float wait = this->randNumGet();
+
+	    holdIn( active, wait );
+	    stateSave( 0, wait );
+	    }
 
 	return *this ;
 }
@@ -130,110 +321,103 @@ Model &PnTrans::initFunction()
 /*******************************************************************
 * Function Name: externalFunction
 * Description: This method handles external events coming from 
-* any one of the fice input ports.  The format of the messages
-* received is "XYYY" where X is the the model ID of the place
-* which sent the message.  YYY is the number of tokens contained
-* in that place.  For example, 12007 means that the place whose ID
-* is 12 contains 7 tokens.  This routine uses the ID  to keep track 
-* of all the places which feed tokens to this transition.
+* any one of the fice input ports.  The messages received carry
+* the model ID of the place which sent the message and the number
+* of tokens contained in that place, packed as described in
+* pnMsg.h.  This routine uses the ID to keep track of all the
+* places which feed tokens to this transition.
 ********************************************************************/
 Model &PnTrans::externalFunction( const ExternalMessage &msg )
 {
-	Real 		placeId;	// Place the message came from
-	unsigned int 	numOfTokens;	// Number of tokens in that place
+	PnTokenMsg 	tokenMsg;	// Place the message came from and
+					// number of tokens in that place
 	unsigned int 	arcWidth;	// Width of arc connecting input place
 					// to this transition
-	bool 		placeIdMatch;	// Flag indicating if placeId match occured
-	unsigned int 	i;		// array index
+	int 		slot;		// Slot of the place in inPlaces
+	bool 		satisfied;	// Arc satisfied by the place
+	bool		wasEnabled;	// Enabled before the message
+	double		now;		// Time of the message, in seconds
+	PnProfileTimer	timer( profile, profileId, PN_PROFILE_EXTERNAL );
 
-	placeIdMatch = false;
-	transEnabled = true;
+	if( profile != NULL )
+	    profile->received( profileId, msg.time().asMsecs() / 1000.0 );
 
 	// The width of the connecting arc depends on the port 
 	// tokens are received from.
-	if( msg.port() == in0 ) {arcWidth = 0;}
-	else if( msg.port() == in1 ) {arcWidth = 1;}
-	else if( msg.port() == in2 ) {arcWidth = 2;}
-	else if( msg.port() == in3 ) {arcWidth = 3;}
-	else if( msg.port() == in4 ) {arcWidth = 4;}
-
-	// Determine which input place sent the message and how many tokens 
-	// are contained in that place.
-	placeId = trunc( msg.value() / 1000 );
-	numOfTokens = (int) msg.value() %  1000;
-
-	// Set pInArray to point to the start of the array of input 
-	// places.
-	pInArray = pArrayStart;
-
-	// Check to see if the place the message comes from is already
-	// in the input place array
-	for( i = 0; i < numOfInputs; i++ )
-	    {
-	    if( (!placeIdMatch) && (pInArray->placeId == \
-		(int) placeId.value()) )
+	arcWidth = 0;
+	for( unsigned int i = 0; i < inPorts.size(); i++ )
+	    if( msg.port() == *inPorts[i] )
 		{
-		// We have a match.  Determine if the transition
-		// is potentially enabled because of this
-		// message.
-		if( (arcWidth != 0) && (numOfTokens >= arcWidth) )
-		    pInArray->enabled = true;
-		else if( (arcWidth == 0) && (numOfTokens == 0) )
-		    pInArray->enabled = true;
-		else
-		    pInArray->enabled = false;
-			   	
-		placeIdMatch = true;
+		arcWidth = inWeights[i];
+		break;
 		}
 
-	    // Determine if the transition is enabled.  Note that
-	    // there is a case where transEnabled is set to true
-	    // but should not:  When this is the first time a message
-	    // is received from placeId and all other input places in 
-	    // the array of input places have enough tokens to make 
-	    // the transition enabled.  This situation is dealt with below.
-	    transEnabled = transEnabled && pInArray->enabled;
+	// Determine which input place sent the message and how many tokens 
+	// are contained in that place.
+	tokenMsg = pnMsgDecode( msg.value() );
 
-	    ++pInArray;
+	if( arcWidth != 0 )
+	    satisfied = tokenMsg.tokens >= arcWidth;
+	else
+	    satisfied = tokenMsg.tokens == 0;
 
-	    } // End of for loop
+	// Find the place in the index of input places.  If it is
+	// not there this is the first message received from that 
+	// place.  Therefore store the place along with the arc 
+	// width, counting its arc as not satisfied until the 
+	// update below.
+	slot = slotFind( tokenMsg.placeId );
 
-	// If there was no match for placeId it is because this is the
-	// first message received from that place. Therefore store 
-	// placeId in the array of input places along with the
-	// arc width and determine if the transition is potentially
-	// enabled from that place.
-	if( !placeIdMatch )	
+	if( slot < 0 )
 	    {
-	    // Check to make sure we have space left in the array
-	    // before adding the new placeId.
-	    if( numOfInputs == inPlaces )
+	    // Check to make sure we have space left before adding
+	    // the new place.
+	    if( maxInputs != 0 && inPlaces.size() == maxInputs )
 	    	{
 		// Throw an exception 
-		++numOfInputs;
-		MException e( string("inputplaces parameter (") + inPlaces + \
-		    ") is too small to handle all the places (" + numOfInputs + \
-		    ") connected to transition " + description() + \
+		MException e( string("inputplaces parameter (") + maxInputs + \
+		    ") is too small to handle all the places (" + \
+		    (maxInputs + 1) + ") connected to transition " + \
+		    description() + \
 		    ".  Please specify a larger inputplaces parameter");
 		e.addLocation( MEXCEPTION_LOCATION() );
 		throw e;
 		}
 
-	    pInArray->placeId = (int) placeId.value();
-	    pInArray->arcWidth = arcWidth;
+	    slot = slotAdd( tokenMsg.placeId, arcWidth );
+	    ++unsatisfied;
 
-	    if( (arcWidth != 0) && (numOfTokens >= arcWidth) )
-		pInArray->enabled = true;
-	    else if( (arcWidth == 0) && (numOfTokens == 0) )
-		pInArray->enabled = true;
+	    if( profile != NULL )
+		profile->inputs( profileId, inPlaces.size() );
+	    }
+
+	// Only a change of the state of the arc changes the
+	// number of unsatisfied arcs, so the enablement of the
+	// transition is known without looking at its other input
+	// places.
+	if( satisfied != inPlaces[slot].enabled )
+	    {
+	    inPlaces[slot].enabled = satisfied;
+
+	    if( satisfied )
+		--unsatisfied;
 	    else
-		{
-		pInArray->enabled = false;
-		transEnabled = false;
-		}
-	    numOfInputs++;
+		++unsatisfied;
 	    }
 
+	if( saved != NULL )
+	    saved->transArc( savedId, msg.time().asMsecs() / 1000.0, slot,
+			     tokenMsg.placeId, inPlaces[slot].arcWidth, satisfied );
+
+	// A transition which stops being enabled cancels the firing
+	// it had scheduled
+	if( profile != NULL && transEnabled && unsatisfied != 0 )
+	    profile->flip( profileId );
+
+	wasEnabled = transEnabled;
+	transEnabled = ( unsatisfied == 0 );
+	now = msg.time().asMsecs() / 1000.0;
+
 	// If the transition is enabled, schedule an internal
 	// event to fire the transition some time in the future.
 	// Because this transition schedules its firing independantly
@@ -243,13 +427,26 @@ Model &PnTrans::externalFunction( const ExternalMessage &msg )
 	// would be processed as discrete events therefore it would
 	// not be a problem.  The only odd thing would be that the 
 	// log and output files would show more than one firing at 
-	// the same time index.
-	if( transEnabled )
+	// the same time index.  A transition which was already 
+	// enabled keeps the firing it scheduled, for the remaining
+	// time.
+	if( transEnabled && wasEnabled && fireTime >= now )
 	    {
-	    holdIn( active, (float) this->randNumGet() );
+	    holdIn( active, (float) ( fireTime - now ) );
+	    stateSave( now, fireTime );
+	    }
+	else if( transEnabled )
+	    {
+	    float wait = this->randNumGet();
+
+	    holdIn( active, wait );
+	    stateSave( now, now + wait );
 	    }
 	else
+	    {
 	    passivate();
+	    stateSave( now, -1 );
+	    }
 
 
 	return *this;
@@ -259,24 +456,32 @@ Model &PnTrans::externalFunction( const ExternalMessage &msg )
 * Function Name: internalFunction
 * Description: This method implements the internal transition
 * function of the model.  It is activated only when the transition
-* fires.  In the case of a transition with input places, the model
-* simply passivates, waiting for those places to re-advertise
-* the number of tokens they contain.  In the case of a source
-* transition, which are always enabled, the next firing is 
-* scheduled. 
+* fires.  Input places only advertise their contents when it 
+* crosses the threshold of an arc, so a place which still holds 
+* enough tokens after the firing stays silent.  Hence the 
+* transition schedules its next firing as if it was still enabled;
+* if a place becomes unable to satisfy its arc, it advertises its 
+* new contents at the same time and the transition passivates
+* upon receiving the message.  Source transitions, which are 
+* always enabled, simply schedule their next firing.
 ********************************************************************/
-Model &PnTrans::internalFunction( const InternalMessage & )
+Model &PnTrans::internalFunction( const InternalMessage &msg )
 {
-	// Check to see if this is a source transition.  If it
-	// is, schedule the next firing.
-	if( numOfInputs == 0 )
+	if( transEnabled || inPlaces.empty() )
 	    {
-	    holdIn( active, (float) this->randNumGet() );
+	    float wait = this->randNumGet();
+
+	    holdIn( active, wait );
+	    stateSave( msg.time().asMsecs() / 1000.0,
+		       msg.time().asMsecs() / 1000.0 + wait );
 	    }
 	else 
+	    {
 	    // Wait for the input places to let the transition know 
 	    // the number of tokens they contain.
 	    passivate();
+	    stateSave( msg.time().asMsecs() / 1000.0, -1 );
+	    }
 
 	return *this;
 }
@@ -285,80 +490,197 @@ Model &PnTrans::internalFunction( const InternalMessage & )
 * Function Name: outputFunction
 * Description: This routine is activated when the transition fires.
 * It deposits tokens in the places which have their <in> port 
-* connected to the <out1>, <out2>, <out3> and <out4> output ports
-* of this model.  The number of tokens deposited in the output places 
-* depends on the port they are connected to.  The ones connected to 
-* <out1> receive one token, the ones connected to <out2> receive two 
-* tokens and so on.  The messages sent out of those ports simply 
-* contain the number of tokens to be deposited.  The routine also
+* connected to the <out1>, <out2>, <out3>, <out4> and declared
+* output ports of this model.  The number of tokens deposited in the
+* output places depends on the port they are connected to.  The ones
+* connected to <out1> receive one token, the ones connected to <out2>
+* receive two tokens and so on.  The messages sent out of those ports
+* simply contain the number of tokens to be deposited.  Ports which
+* are not linked to any place are skipped.  The routine also
 * indicates that it fired by sending a message to all of its inputs
 * places which are connected to the <fired> output port.  The
 * transition knows exactly who the inputs places are because
-* it keeps track of them using their ID.  The format of the message
-* sent on the <fired> port is "XYYY" where X is the place to which
-* the message is destined and YYY is the number of tokens the place
-* must subtract from its contents.
+* it keeps track of them using their ID.  The message sent on the
+* <fired> port carries the ID of the place to which the message is
+* destined and the number of tokens the place must subtract from
+* its contents, packed as described in pnMsg.h.
 ********************************************************************/
 Model &PnTrans::outputFunction( const InternalMessage &msg )
 {
 	unsigned int i;		// array index
+	PnProfileTimer timer( profile, profileId, PN_PROFILE_OUTPUT );
+
+	if( profile != NULL )
+	    {
+	    profile->firing( profileId );
+	    profile->sent( profileId, linkedOuts.size() +
+			   ( inPlaces.empty() ? 1 : inPlaces.size() ) );
+	    }
+
+	if( trace != NULL )
+	    trace->firing( msg.time().asMsecs() / 1000.0, Model::id() );
+
+	if( stats != NULL )
+	    stats->firing( statsId, msg.time().asMsecs() / 1000.0 );
 
-	// Set pInArray to the start of the array of input places.
-	pInArray = pArrayStart;	
-	
 	// Deposit tokens in all output places
-    	sendOutput( msg.time(), out1, 1 );
-    	sendOutput( msg.time(), out2, 2 );
-    	sendOutput( msg.time(), out3, 3 );
-    	sendOutput( msg.time(), out4, 4 );
+	for( i = 0; i < linkedOuts.size(); i++ )
+	    sendOutput( msg.time(), *linkedOuts[i], linkedWeights[i] );
 
 	// Remove tokens from all input places
-	for( i = 0; i < numOfInputs; i++ )
+	for( i = 0; i < inPlaces.size(); i++ )
 	    {
 	    sendOutput( msg.time(), fired, 
-			pInArray->placeId * 1000 + pInArray->arcWidth );
-	    ++pInArray;
+			pnMsgEncode( inPlaces[i].placeId, inPlaces[i].arcWidth ) );
 	    }
 
 	// Even source transitions send a "fired" message to
 	// indicate the firing. 
-	if( numOfInputs == 0 )
+	if( inPlaces.empty() )
 	    sendOutput( msg.time(), fired, 0 );
 
 
     	return *this ;
 }
 
+/*******************************************************************
+* Function Name: stateLoad
+* Description: This routine restores the state of the transition
+* from the checkpoint: its input places with the state of their
+* arcs, the number of delays drawn and the firing it had scheduled,
+* if any, at the same time from the checkpoint.  The places loaded
+* from the checkpoint do not advertise a count the transition
+* already knows.
+********************************************************************/
+void PnTrans::stateLoad()
+{
+	const PnCheckpoint::Trans *state = loaded->transFind( description() );
+	double due;
+
+	if( state == NULL )
+	    {
+	    MException e( string("Transition ") + description() + \
+		" is not in the checkpoint" );
+	    e.addLocation( MEXCEPTION_LOCATION() );
+	    throw e;
+	    }
+
+	for( unsigned int i = 0; i < state->arcs.size(); i++ )
+	    {
+	    unsigned int slot = slotAdd( state->arcs[i].placeId, state->arcs[i].arcWidth );
+
+	    inPlaces[slot].enabled = state->arcs[i].enabled != 0;
+
+	    if( saved != NULL )
+		saved->transArc( savedId, 0, slot, inPlaces[slot].placeId,
+				 inPlaces[slot].arcWidth, inPlaces[slot].enabled );
+	    }
+
+	if( profile != NULL )
+	    profile->inputs( profileId, inPlaces.size() );
+
+	draws = state->draws;
+	unsatisfied = state->unsatisfied;
+	transEnabled = !inPlaces.empty() && unsatisfied == 0;
+
+	if( state->due >= 0 )
+	    {
+	    due = state->due - loaded->time();
+	    holdIn( active, (float) due );
+	    }
+	else
+	    {
+	    due = -1;
+	    passivate();
+	    }
+
+	stateSave( 0, due );
+}
+
 /*******************************************************************
 * Function Name: randNumGet
-* Description: This routine returns a random number between one
-* and 60.  It is used by the transition to schedule its firings.
+* Description: This routine returns the delay, in seconds, of the
+* next firing of the transition.  It is drawn from the distribution
+* given by the "delay" parameter (see pnRandom.h) using a 
+* counter-based generator: the delay is a function of the seed, the
+* ID of the transition and the number of delays drawn so far.  A
+* zero delay fires the transition in zero time.
 ********************************************************************/
-unsigned int PnTrans::randNumGet( void )
+float PnTrans::randNumGet( void )
 {
-	unsigned int value = 0;
+	PnProfileTimer timer( profile, profileId, PN_PROFILE_DRAW );
+	float wait = (float) pnDelayDraw( delay, seed, Model::id(), draws++ );
 
-	// Seed the random number generator the first time this 
-	// method is called.
-	if (!randGenSeeded)
+	if( profile != NULL )
 	    {
-	    time_t seed;	// Seed for the random number generator
+	    profile->draw( profileId );
+	    if( wait == 0 )
+		profile->reactivation( profileId );
+	    }
 
-	    // Use real time clock to generate seeds
-	    time( &seed );
+	return wait;
+}
+
+/*******************************************************************
+* Function Name: slotFind
+* Description: This routine returns the slot of an input place in
+* the inPlaces array, or -1 if the place is unknown.  The slot is
+* found in an open addressing index whose size is a power of two
+* at least twice the number of input places, so a lookup takes
+* constant time whatever the number of input places.
+********************************************************************/
+int PnTrans::slotFind( int placeId ) const
+{
+	unsigned int mask = slotIndex.size() - 1;
+	unsigned int i = ( (unsigned int) placeId * 2654435761U ) & mask;
 
-	    // Seed the random number generator
-	    srand( seed );
+	while( slotIndex[i] >= 0 )
+	    {
+	    if( inPlaces[slotIndex[i]].placeId == placeId )
+		return slotIndex[i];
 
-	    randGenSeeded = true;
+	    i = ( i + 1 ) & mask;
 	    }
 
-	// Now generate the random number
-	while ( (value < 1) || (value > 60) )
+	return -1;
+}
+
+/*******************************************************************
+* Function Name: slotAdd
+* Description: This routine stores a new input place and returns 
+* its slot.  The place starts with its arc not satisfied.  The 
+* index is doubled and rebuilt when it would become more than 
+* half full.
+********************************************************************/
+unsigned int PnTrans::slotAdd( int placeId, unsigned int arcWidth )
+{
+	inputPlaceInfo info;
+	unsigned int first;	// First slot to put in the index
+	unsigned int mask;
+	unsigned int i;
+
+	info.placeId = placeId;
+	info.arcWidth = arcWidth;
+	info.enabled = false;
+	inPlaces.push_back( info );
+
+	first = inPlaces.size() - 1;
+	if( 2 * inPlaces.size() > slotIndex.size() )
 	    {
-	    value = (unsigned int) rand() % 100;
+	    slotIndex.assign( 2 * slotIndex.size(), -1 );
+	    first = 0;
 	    }
 
-	return( value );
+	mask = slotIndex.size() - 1;
+	for( unsigned int slot = first; slot < inPlaces.size(); slot++ )
+	    {
+	    i = ( (unsigned int) inPlaces[slot].placeId * 2654435761U ) & mask;
+
+	    while( slotIndex[i] >= 0 )
+		i = ( i + 1 ) & mask;
+
+	    slotIndex[i] = slot;
+	    }
 
+	return inPlaces.size() - 1;
 }
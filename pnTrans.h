@@ -14,7 +14,13 @@
 #define __PNTRANS_H
 
 #include <list>
+#include <vector>
 #include "atomic.h"     // class Atomic
+#include "pnRandom.h"	// PnDelay
+#include "pnTrace.h"	// class PnTrace
+#include "pnStats.h"	// class PnStats
+#include "pnProfile.h"	// class PnProfile
+#include "pnCheckpoint.h"	// class PnCheckpoint
 
 // structure to store information about input places
 struct inputPlaceInfo
@@ -38,7 +44,16 @@ protected:
 	Model &externalFunction( const ExternalMessage & );
 	Model &internalFunction( const InternalMessage & );
 	Model &outputFunction( const InternalMessage & );
-	unsigned int randNumGet( void );
+	float randNumGet( void );
+	int slotFind( int placeId ) const;
+	unsigned int slotAdd( int placeId, unsigned int arcWidth );
+	void stateLoad();
+	void stateSave( double now, double due )
+		{
+		fireTime = due;
+		if( saved != NULL )
+		    saved->trans( savedId, now, draws, due, unsatisfied );
+		}
 
 private:
 
@@ -56,14 +71,56 @@ private:
 	Port &out4;
 	Port &fired;
 
+	// Weighted ports.  All the input ports (in0..in4 and the
+	// ones declared by "inweights") with their weights, and
+	// the output ports which are linked to a place with the
+	// number of tokens they deposit.
+	vector<const Port *> inPorts;
+	vector<unsigned int> inWeights;
+	vector<Port *> outPorts;
+	vector<unsigned int> outWeights;
+	vector<Port *> linkedOuts;
+	vector<unsigned int> linkedWeights;
+
 	// State variables
 	bool transEnabled;	
-	unsigned int numOfInputs;
-	bool randGenSeeded;
+	double fireTime;		// Time of the firing scheduled, in
+					// seconds, -1 if none
+	unsigned int unsatisfied;	// Number of input arcs which 
+					// are not satisfied
+	unsigned int maxInputs;		// Maximum number of input places,
+					// zero if there is no limit
+
+	// Firing delays
+	PnDelay delay;
+	unsigned long long seed;
+	unsigned long long draws;	// Number of delays drawn
+
+	// Binary trace of the firings, NULL if none
+	PnTrace *trace;
+
+	// Statistics of the firings, NULL if none, and the number of
+	// the transition in them
+	PnStats *stats;
+	unsigned int statsId;
+
+	// Profile of the work of the model, NULL if none, and the
+	// number of the model in it
+	PnProfile *profile;
+	unsigned int profileId;
+
+	// Checkpoint the state is saved in, NULL if none, with the
+	// number of the transition in it, and the checkpoint the
+	// state is loaded from, NULL if none
+	PnCheckpoint *saved;
+	unsigned int savedId;
+	const PnCheckpoint *loaded;
 
-	// Pointers to an array of input places
-	inputPlaceInfo * pInArray;
-	inputPlaceInfo * pArrayStart;
+	// Input places of this transition, and open addressing
+	// index giving the slot of a place in inPlaces from its
+	// ID (-1 marks a free entry of the index).
+	vector<inputPlaceInfo> inPlaces;
+	vector<int> slotIndex;
 
 };	// class PnTrans
 
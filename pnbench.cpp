@@ -0,0 +1,349 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Benchmark Harness
+*
+*  pnbench fires every net it is given for the same simulated time
+*  and reports, one line per net, how fast it went:
+*
+*  - startup: seconds to load and compile the net, prove it 1-safe
+*    or not and build and reset the engine;
+*  - the firings done and the firings per second of the engine;
+*  - the messages per firing the PnPlace and PnTrans models would
+*    exchange for the same firings: one per input and output arc of
+*    the transition, plus one per arc leaving a place whenever its
+*    count crosses an arc threshold and the place advertises it;
+*  - the peak resident memory of the process so far, in kilobytes.
+*    Run one net per pnbench for the peak of each net.
+*
+*  The output is CSV, or JSON with -fjson, so the results of runs
+*  can be kept and compared from one version to the next.  Nets of
+*  any size come from pngen (see pngen.cpp).
+*
+*  Usage:
+*
+*  pnbench [-tTIME] [-sSEED] [-qheap|-qladder] [-g] [-fcsv|-fjson]
+*	file.ma|file.hpx...
+*
+*  -t	simulated seconds (default 3600)
+*  -s	seed of the delays (default 1)
+*  -q	event list of the engine (default heap, see pnEvents.h)
+*  -g	keep the general engine even for a 1-safe net
+*  -f	output format (default csv)
+*
+*  For example:
+*
+*  -> pngen -d"uniform 1 2" pipeline 10000 > pipeline10000.ma
+*  -> pnbench -t1000 -fjson pipeline.ma pipeline10000.ma
+*
+*  Build it with:
+*
+*  -> g++ -O2 -mavx2 -o pnbench pnbench.cpp pnEngine.cpp pnEvents.cpp
+*     pnStruct.cpp pnNetDef.cpp pnNetHpx.cpp pnNetImage.cpp
+*     pnRandom.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEngine.h"	// class PnEngine
+#include "pnStruct.h"	// pnNetSafe()
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), atof()
+#include <string.h>	// strcmp()
+#include <sys/resource.h>	// getrusage()
+#include <chrono>	// steady_clock
+#include <algorithm>	// sort(), unique(), upper_bound()
+
+/** private data **/
+
+// Measures of a net
+struct PnBenchResult
+    {
+    string net;
+    unsigned int places;
+    unsigned int transitions;
+    unsigned int arcs;
+    bool safe;
+    double startup;
+    double seconds;
+    unsigned long firings;
+    double messages;
+    long peakKb;
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: secondsSince
+********************************************************************/
+static double secondsSince( chrono::steady_clock::time_point start )
+{
+	return chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+}
+
+/*******************************************************************
+* Function Name: peakKbGet
+* Description: Returns the peak resident memory of the process.
+********************************************************************/
+static long peakKbGet()
+{
+	struct rusage usage;
+
+	if( getrusage( RUSAGE_SELF, &usage ) != 0 )
+	    return 0;
+
+	return usage.ru_maxrss;
+}
+
+/*******************************************************************
+* Function Name: jsonQuote
+* Description: Returns a string as a JSON string, for the Windows
+* paths in particular.
+********************************************************************/
+static string jsonQuote( const string &text )
+{
+	string quoted( "\"" );
+
+	for( string::size_type i = 0; i < text.size(); i++ )
+	    {
+	    if( text[i] == '"' || text[i] == '\\' )
+		quoted += '\\';
+	    quoted += text[i];
+	    }
+
+	return quoted + "\"";
+}
+
+// Place advertisements of the PnPlace models: the arc thresholds
+// of every place and the level of its count, as in PnPlace
+class PnBenchPlaces
+{
+public:
+	PnBenchPlaces( const PnNetDef &net );
+
+	// Returns the messages sent if a place now holds <tokens>
+	unsigned int change( unsigned int place, PnTokens tokens );
+
+private:
+	unsigned int levelGet( unsigned int place, PnTokens tokens ) const
+		{return upper_bound( thresholds.begin() + start[place],
+				     thresholds.begin() + start[place + 1], tokens ) -
+			( thresholds.begin() + start[place] );}
+
+	const PnNetDef &def;
+	vector<unsigned int> start;
+	vector<PnTokens> thresholds;
+	vector<unsigned int> level;
+
+};	// class PnBenchPlaces
+
+/*******************************************************************
+* Function Name: PnBenchPlaces constructor
+* Description: An inhibitor arc changes state at one token, like an
+* arc of weight one.
+********************************************************************/
+PnBenchPlaces::PnBenchPlaces( const PnNetDef &net )
+: def( net )
+{
+	vector<PnTokens> list;
+	unsigned int p, t, a;
+
+	start.push_back( 0 );
+
+	for( p = 0; p < net.places(); p++ )
+	    {
+	    list.clear();
+
+	    for( unsigned int c = net.consStart[p]; c < net.consStart[p + 1]; c++ )
+		{
+		t = net.consTrans[c];
+		for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		    if( net.prePlace[a] == p )
+			list.push_back( net.preWeight[a] == 0 ? 1 : net.preWeight[a] );
+		}
+
+	    sort( list.begin(), list.end() );
+	    list.erase( unique( list.begin(), list.end() ), list.end() );
+
+	    thresholds.insert( thresholds.end(), list.begin(), list.end() );
+	    start.push_back( thresholds.size() );
+	    }
+
+	for( p = 0; p < net.places(); p++ )
+	    level.push_back( levelGet( p, net.initMarking[p] ) );
+}
+
+/*******************************************************************
+* Function Name: change
+********************************************************************/
+unsigned int PnBenchPlaces::change( unsigned int place, PnTokens tokens )
+{
+	unsigned int now = levelGet( place, tokens );
+
+	if( now == level[place] )
+	    return 0;
+
+	level[place] = now;
+
+	return def.consStart[place + 1] - def.consStart[place];
+}
+
+/*******************************************************************
+* Function Name: netBench
+* Description: Loads and fires a net.  Throws a PnNetError if the
+* net cannot be loaded or its immediate transitions fire forever.
+********************************************************************/
+static void netBench( const char *fileName, double length, unsigned long long seed,
+		      PnEventListKind list, bool general, PnBenchResult &result )
+{
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	PnNetDef net;
+	unsigned long long messages = 0;
+	unsigned int i, a, p;
+
+	pnNetLoad( fileName, net );
+
+	result.net = fileName;
+	result.places = net.places();
+	result.transitions = net.transitions();
+	result.arcs = net.preStart[net.transitions()] + net.postStart[net.transitions()];
+	result.safe = !general && pnNetSafe( net );
+
+	PnEngine engine( net, result.safe, list );
+	PnBenchPlaces places( net );
+
+	engine.reset( 0, seed );
+	result.startup = secondsSince( start );
+
+	start = chrono::steady_clock::now();
+
+	while( engine.pending() && engine.nextTime() <= length )
+	    {
+	    engine.fire();
+
+	    const vector<unsigned int> &fired = engine.lastFired();
+
+	    for( i = 0; i < fired.size(); i++ )
+		{
+		unsigned int t = fired[i];
+
+		for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		    if( net.preWeight[a] != 0 )
+			{
+			p = net.prePlace[a];
+			messages += 1 + places.change( p, engine.tokens( p ) );
+			}
+
+		for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		    {
+		    p = net.postPlace[a];
+		    messages += 1 + places.change( p, engine.tokens( p ) );
+		    }
+		}
+	    }
+
+	result.seconds = secondsSince( start );
+	result.firings = engine.firings();
+	result.messages = result.firings != 0 ? (double) messages / result.firings : 0;
+	result.peakKb = peakKbGet();
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-tTIME] [-sSEED] [-qheap|-qladder] [-g] "
+		 "[-fcsv|-fjson] file.ma|file.hpx...\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	double length = 3600;
+	unsigned long long seed = 1;
+	PnEventListKind list = PN_LIST_HEAP;
+	bool general = false, json = false;
+	vector<const char *> files;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		files.push_back( opt );
+	    else if( opt[1] == 't' )
+		length = atof( opt + 2 );
+	    else if( opt[1] == 's' )
+		seed = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'q' )
+		{
+		if( !pnEventListParse( opt + 2, list ) )
+		    return usage( argv[0] );
+		}
+	    else if( opt[1] == 'g' )
+		general = true;
+	    else if( opt[1] == 'f' && strcmp( opt + 2, "json" ) == 0 )
+		json = true;
+	    else if( opt[1] == 'f' && strcmp( opt + 2, "csv" ) == 0 )
+		json = false;
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( files.empty() || length <= 0 )
+	    return usage( argv[0] );
+
+	if( json )
+	    printf( "[\n" );
+	else
+	    printf( "net,places,transitions,arcs,safe,list,time,startup_s,"
+		    "run_s,firings,firings_per_s,messages_per_firing,peak_rss_kb\n" );
+
+	for( i = 0; i < files.size(); i++ )
+	    {
+	    PnBenchResult r;
+
+	    try
+	       {
+	       netBench( files[i], length, seed, list, general, r );
+	       }
+	    catch( PnNetError &err )
+	       {
+	       fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	       return 1;
+	       }
+
+	    double rate = r.seconds > 0 ? r.firings / r.seconds : 0;
+	    const char *listName = list == PN_LIST_HEAP ? "heap" : "ladder";
+
+	    if( json )
+		printf( "  {\"net\": %s, \"places\": %u, \"transitions\": %u, "
+			"\"arcs\": %u, \"safe\": %s, \"list\": \"%s\", \"time\": %g, "
+			"\"startup_s\": %.6f, \"run_s\": %.6f, \"firings\": %lu, "
+			"\"firings_per_s\": %.6g, \"messages_per_firing\": %.4f, "
+			"\"peak_rss_kb\": %ld}%s\n", jsonQuote( r.net ).c_str(), r.places,
+			r.transitions, r.arcs, r.safe ? "true" : "false", listName,
+			length, r.startup, r.seconds, r.firings, rate, r.messages,
+			r.peakKb, i + 1 < files.size() ? "," : "" );
+	    else
+		printf( "%s,%u,%u,%u,%d,%s,%g,%.6f,%.6f,%lu,%.6g,%.4f,%ld\n",
+			r.net.c_str(), r.places, r.transitions, r.arcs, r.safe,
+			listName, length, r.startup, r.seconds, r.firings, rate,
+			r.messages, r.peakKb );
+
+	    fflush( stdout );
+	    }
+
+	if( json )
+	    printf( "]\n" );
+
+	return 0;
+}
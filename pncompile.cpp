@@ -0,0 +1,81 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Compiler
+*
+*  pncompile loads a net from its .ma or .hpx file and writes its
+*  compiled form as an image (see pnNetImage.cpp).  Every tool and
+*  the PnNet model load a .pni image as they load the net file it
+*  came from, without parsing it, which saves most of the startup
+*  of large nets and of runs started many times on the same net.
+*  The image holds the whole net, delays included, so compile it
+*  again after changing the net file.
+*
+*  Usage:
+*
+*  pncompile file.ma|file.hpx [file.pni]
+*
+*  Without a .pni file the image is written next to the net file,
+*  with the .pni extension.  For example:
+*
+*  -> pngen pipeline 100000 > pipeline100000.ma
+*  -> pncompile pipeline100000.ma
+*  -> pnbench pipeline100000.ma pipeline100000.pni
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pncompile pncompile.cpp pnNetDef.cpp pnNetHpx.cpp
+*     pnNetImage.cpp pnRandom.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// pnNetLoad(), pnNetWriteImage()
+#include <stdio.h>	// printf()
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	PnNetDef net;
+	string image;
+
+	if( argc != 2 && argc != 3 )
+	    {
+	    fprintf( stderr, "usage: %s file.ma|file.hpx [file.pni]\n", argv[0] );
+	    return 1;
+	    }
+
+	if( argc == 3 )
+	    image = argv[2];
+	else
+	    {
+	    string name( argv[1] );
+	    string::size_type dot = name.rfind( '.' );
+	    string::size_type slash = name.find_last_of( "/\\" );
+
+	    if( dot != string::npos && ( slash == string::npos || dot > slash ) )
+		name.erase( dot );
+
+	    image = name + ".pni";
+	    }
+
+	try
+	   {
+	   pnNetLoad( argv[1], net );
+	   pnNetWriteImage( image, net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	printf( "%s: %u places, %u transitions, %u arcs\n", image.c_str(),
+		net.places(), net.transitions(),
+		net.preStart[net.transitions()] + net.postStart[net.transitions()] );
+
+	return 0;
+}
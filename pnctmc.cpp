@@ -0,0 +1,155 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Steady State Tool
+*
+*  pnctmc computes the steady state of a net whose delays are all
+*  exponential (see pnCtmc.h) and prints the same results as pnrep,
+*  the time averaged tokens of every place and the throughput of
+*  every transition, but exact: there is no confidence interval and
+*  no simulation.  Transitions with a zero delay are immediate.
+*
+*  Usage:
+*
+*  pnctmc [-x] [-eEPSILON] [-iSWEEPS] [-wOMEGA] [-mMAXSTATES] [-jWORKERS]
+*	  file.ma|file.hpx
+*
+*  -x	replace the delays which are not exponential by exponential
+*	delays with the same mean, for instance the default
+*	"discrete 1 60" by "exponential 30.5"
+*  -e	stop when no probability changes by more than EPSILON times
+*	the largest one in a sweep (default 1e-10)
+*  -i	stop after that many sweeps (default 100000)
+*  -w	relaxation factor of SOR, between 0 and 2 (default 1, Gauss-
+*	Seidel)
+*  -m	give up if the chain has more states (default: no limit)
+*  -j	number of worker threads (default: one per processor); with
+*	-j1 the solver is plain Gauss-Seidel
+*
+*  The tool returns 0 if the solver converged, 2 if it did not or
+*  if the chain has no single steady state.
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnctmc pnctmc.cpp pnCtmc.cpp pnPool.cpp pnNetDef.cpp
+*     pnNetHpx.cpp pnNetImage.cpp pnRandom.cpp -lpthread
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnCtmc.h"	// class PnCtmc
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoul(), atof()
+#include <time.h>	// time()
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-x] [-eEPSILON] [-iSWEEPS] [-wOMEGA] "
+		 "[-mMAXSTATES] [-jWORKERS] file.ma|file.hpx\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	unsigned int workers = 0, maxSweeps = 100000, maxStates = 0;
+	double epsilon = 1e-10, omega = 1;
+	bool approximate = false;
+	const char *fileName = NULL;
+	PnNetDef net;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		fileName = opt;
+	    else if( opt[1] == 'x' )
+		approximate = true;
+	    else if( opt[1] == 'e' )
+		epsilon = atof( opt + 2 );
+	    else if( opt[1] == 'i' )
+		maxSweeps = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'w' )
+		omega = atof( opt + 2 );
+	    else if( opt[1] == 'm' )
+		maxStates = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'j' )
+		workers = strtoul( opt + 2, NULL, 10 );
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( fileName == NULL || epsilon <= 0 || omega <= 0 || omega >= 2 )
+	    return usage( argv[0] );
+
+	try
+	   {
+	   pnNetLoad( fileName, net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	PnCtmc chain( net, workers );
+	time_t start = time( NULL );
+
+	chain.approximateSet( approximate );
+	chain.maxStatesSet( maxStates );
+
+	try
+	   {
+	   chain.build();
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	printf( "%u tangible states, %llu arcs, %llu immediate firings eliminated\n",
+		chain.states(), chain.arcs(), chain.vanishingFirings() );
+
+	// A dead marking or several closed classes: the long run
+	// behaviour depends on the path taken, there is no single
+	// steady state to compute
+	if( chain.deadStates() != 0 )
+	    {
+	    printf( "%u dead markings: use pnreach to find them\n", chain.deadStates() );
+	    return 2;
+	    }
+
+	if( chain.closedClasses() != 1 )
+	    {
+	    printf( "%u closed classes: no single steady state\n", chain.closedClasses() );
+	    return 2;
+	    }
+
+	bool converged = chain.solve( epsilon, maxSweeps, omega );
+
+	printf( "%s after %u sweeps, residual %.3g, %ld s\n",
+		converged ? "Converged" : "NOT CONVERGED", chain.sweeps(),
+		chain.residual(), (long) ( time( NULL ) - start ) );
+
+	printf( "\n%-20s %14s\n", "Place", "Tokens" );
+	for( i = 0; i < net.places(); i++ )
+	    printf( "%-20s %14.6g\n", net.placeName[i].c_str(), chain.tokens()[i] );
+
+	printf( "\n%-20s %14s\n", "Transition", "Firings/s" );
+	for( i = 0; i < net.transitions(); i++ )
+	    printf( "%-20s %14.6g\n", net.transName[i].c_str(), chain.throughput()[i] );
+
+	return converged ? 0 : 2;
+}
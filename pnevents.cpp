@@ -0,0 +1,236 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Event List Benchmark
+*
+*  pnevents compares the event lists of pnEvents.h.  Given a net it
+*  fires it once with every kind of list, checks they fire the same
+*  transitions at the same times and prints the firings per second
+*  of each.  Given -h it runs the classic hold benchmark on the
+*  lists alone instead: SIZE firings are scheduled and every step
+*  takes the earliest and schedules it again a whole number of
+*  seconds later, drawn from the default delay distribution (1 to
+*  60), so the list always holds SIZE firings bunched on few times.
+*
+*  Usage:
+*
+*  pnevents [-tTIME] [-sSEED] file.ma|file.hpx
+*  pnevents -hSIZE [-nSTEPS] [-sSEED]
+*
+*  -t	length of the simulation in seconds (default 3600)
+*  -s	seed of the delays (default 1)
+*  -h	firings in the list for the hold benchmark
+*  -n	steps of the hold benchmark (default 10000000)
+*
+*  For example:
+*
+*  -> pnevents -t100000 pipeline.ma
+*  -> pnevents -h100000
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnevents pnevents.cpp pnEngine.cpp pnEvents.cpp
+*     pnNetDef.cpp pnNetHpx.cpp pnNetImage.cpp pnRandom.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEngine.h"	// class PnEngine
+#include "pnEvents.h"	// class PnEventList
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), atof()
+#include <chrono>	// steady_clock
+
+/** private data **/
+
+static const PnEventListKind kinds[] = { PN_LIST_HEAP, PN_LIST_LADDER };
+static const char *kindNames[] = { "heap", "ladder" };
+static const unsigned int KIND_COUNT = 2;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: secondsSince
+********************************************************************/
+static double secondsSince( chrono::steady_clock::time_point start )
+{
+	return chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+}
+
+/*******************************************************************
+* Function Name: netRun
+* Description: Fires a net until <end> and returns the number of
+* firings.  The firings are summed up in <check>.
+********************************************************************/
+static unsigned long netRun( PnEngine &engine, double end, unsigned long long seed,
+			     unsigned long long &check )
+{
+	check = 0;
+	engine.reset( 0, seed );
+
+	while( engine.pending() && engine.nextTime() <= end )
+	    {
+	    double time = engine.nextTime();
+
+	    engine.fire();
+
+	    const vector<unsigned int> &list = engine.lastFired();
+
+	    for( unsigned int i = 0; i < list.size(); i++ )
+		check = pnRandMix( check ^ ( list[i] + (unsigned long long) time * 0x10000 ) );
+	    }
+
+	return engine.firings();
+}
+
+/*******************************************************************
+* Function Name: holdRun
+* Description: Runs the hold benchmark on a list.  Returns a sum of
+* the times taken, which must not depend on the list.
+********************************************************************/
+static double holdRun( PnEventList &events, unsigned int size, unsigned long steps,
+		       unsigned long long seed )
+{
+	PnDelay delay = pnDelayDefault();
+	PnEvent ev;
+	unsigned long long draw = 0;
+	double sum = 0;
+
+	events.clear();
+
+	for( unsigned int i = 0; i < size; i++ )
+	    {
+	    ev.time = pnDelayDraw( delay, seed, 0, draw++ );
+	    ev.trans = i;
+	    ev.stamp = 0;
+	    events.push( ev );
+	    }
+
+	for( unsigned long s = 0; s < steps; s++ )
+	    {
+	    ev = events.top();
+	    events.pop();
+	    sum += ev.time;
+	    ev.time += pnDelayDraw( delay, seed, 0, draw++ );
+	    events.push( ev );
+	    }
+
+	return sum;
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-tTIME] [-sSEED] file.ma|file.hpx\n"
+		 "       %s -hSIZE [-nSTEPS] [-sSEED]\n", prog, prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	double length = 3600;
+	unsigned long long seed = 1;
+	unsigned int holdSize = 0;
+	unsigned long steps = 10000000;
+	const char *fileName = NULL;
+	unsigned int k;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		fileName = opt;
+	    else if( opt[1] == 't' )
+		length = atof( opt + 2 );
+	    else if( opt[1] == 's' )
+		seed = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'h' )
+		holdSize = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'n' )
+		steps = strtoul( opt + 2, NULL, 10 );
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( holdSize != 0 )
+	    {
+	    double first = 0;
+
+	    printf( "Hold benchmark, %u firings, %lu steps\n\n", holdSize, steps );
+	    printf( "%-10s %14s %14s\n", "List", "Seconds", "ns/step" );
+
+	    for( k = 0; k < KIND_COUNT; k++ )
+		{
+		PnEventList events( kinds[k] );
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		double sum = holdRun( events, holdSize, steps, seed );
+		double elapsed = secondsSince( start );
+
+		if( k == 0 )
+		    first = sum;
+		else if( sum != first )
+		    {
+		    fprintf( stderr, "%s: the %s list gave another order\n",
+			     argv[0], kindNames[k] );
+		    return 1;
+		    }
+
+		printf( "%-10s %14.3f %14.1f\n", kindNames[k], elapsed,
+			elapsed * 1e9 / steps );
+		}
+
+	    return 0;
+	    }
+
+	if( fileName == NULL || length <= 0 )
+	    return usage( argv[0] );
+
+	PnNetDef net;
+	unsigned long long first = 0;
+
+	try
+	   {
+	   pnNetLoad( fileName, net );
+
+	   printf( "%s, %u places, %u transitions, %g seconds\n\n", fileName,
+		   net.places(), net.transitions(), length );
+	   printf( "%-10s %14s %14s %14s\n", "List", "Firings", "Seconds", "Firings/s" );
+
+	   for( k = 0; k < KIND_COUNT; k++ )
+	       {
+	       PnEngine engine( net, false, kinds[k] );
+	       unsigned long long check;
+	       chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	       unsigned long firings = netRun( engine, length, seed, check );
+	       double elapsed = secondsSince( start );
+
+	       if( k == 0 )
+		   first = check;
+	       else if( check != first )
+		   {
+		   fprintf( stderr, "%s: the %s list fired another sequence\n",
+			    argv[0], kindNames[k] );
+		   return 1;
+		   }
+
+	       printf( "%-10s %14lu %14.3f %14.4g\n", kindNames[k], firings,
+		       elapsed, elapsed > 0 ? firings / elapsed : 0 );
+	       }
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	return 0;
+}
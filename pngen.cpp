@@ -0,0 +1,404 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Generator
+*
+*  pngen writes Petri Net .ma files of any size, for measuring the
+*  simulators on nets much larger than the demos (see pnbench.cpp).
+*  The nets are ordinary PnPlace and PnTrans nets, with the <fired>
+*  links and the "thresholds" of the places, so they run with the
+*  CD++ simulator as well as with PnNet and the tools.
+*
+*  Usage:
+*
+*  pngen [-sSEED] [-dDELAY] [-mTOKENS] KIND SIZE... > file.ma
+*
+*  pipeline N		N stages like the ones of pipeline.ma: a source
+*			filling the first buffer whenever it is empty,
+*			and per stage a transition taking a part when
+*			the stage is free and one handing it to the
+*			next buffer once that buffer is empty; a sink
+*			empties the last buffer.  Every buffer after
+*			the first has a place marked while it is empty,
+*			so the net is bounded and holds one part per
+*			buffer and stage at most.
+*  mutex N		N processes sharing a critical section guarded
+*			by one semaphore, as in mutual_exclusion.ma.
+*  random P T IN OUT	P places and T transitions with IN input and
+*			OUT output places each, picked at random.
+*  inhibitor P K	P places in a ring, each emptied by a transition
+*			moving its tokens to the next place unless one
+*			of its K inhibitor places, picked at random,
+*			is marked.  A plain transition per place does
+*			the same without inhibitor, so the net never
+*			dies.
+*
+*  -s	seed of the random choices (default 1)
+*  -d	delay of every transition, e.g. "exponential 1" (default:
+*	no delay parameter, i.e. "discrete 1 60")
+*  -m	initial tokens of the random places, and of one ring place
+*	out of 8 for inhibitor nets (default 1)
+*
+*  For example:
+*
+*  -> pngen -d"uniform 1 2" pipeline 1000 > pipeline1000.ma
+*  -> pngen -m2 random 10000 10000 2 2 > random10000.ma
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pngen pngen.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnRandom.h"	// pnRand64()
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), strtoul()
+#include <string.h>	// strcmp()
+#include <string>
+#include <vector>
+#include <algorithm>	// sort(), unique()
+
+using namespace std;
+
+// Arc of the net being generated.  A weight of 0 is an inhibitor arc.
+struct PnGenArc
+    {
+    unsigned int place;
+    unsigned int trans;
+    unsigned int weight;
+    bool input;
+    };
+
+// Net being generated
+struct PnGenNet
+    {
+    unsigned int places;
+    unsigned int transitions;
+    vector<PnGenArc> arcs;
+    vector<unsigned long long> tokens;
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: arcAdd
+********************************************************************/
+static void arcAdd( PnGenNet &net, unsigned int place, unsigned int trans,
+		    unsigned int weight, bool input )
+{
+	PnGenArc arc;
+
+	arc.place = place;
+	arc.trans = trans;
+	arc.weight = weight;
+	arc.input = input;
+	net.arcs.push_back( arc );
+}
+
+/*******************************************************************
+* Function Name: netNew
+********************************************************************/
+static void netNew( PnGenNet &net, unsigned int places, unsigned int transitions )
+{
+	net.places = places;
+	net.transitions = transitions;
+	net.arcs.clear();
+	net.tokens.assign( places, 0 );
+}
+
+/*******************************************************************
+* Function Name: pick
+* Description: Picks <count> distinct numbers below <range>.
+********************************************************************/
+static void pick( vector<unsigned int> &picked, unsigned int count, unsigned int range,
+		  unsigned long long seed, unsigned long long &draws )
+{
+	picked.clear();
+
+	if( count > range )
+	    count = range;
+
+	while( picked.size() < count )
+	    {
+	    unsigned int n = (unsigned int) ( pnRandUnit( pnRand64( seed, 0, draws++ ) ) * range );
+
+	    if( find( picked.begin(), picked.end(), n ) == picked.end() )
+		picked.push_back( n );
+	    }
+}
+
+/*******************************************************************
+* Function Name: pipelineMake
+* Description: Places: buffer i (0..N), free i, busy i and empty i
+* (1..N), the last being the complement of buffer i.  Transitions:
+* the source, start i and end i, the sink.
+********************************************************************/
+static void pipelineMake( PnGenNet &net, unsigned int stages )
+{
+	unsigned int i;
+
+	netNew( net, 4 * stages + 1, 2 * stages + 2 );
+
+	// Source, inhibited by a full first buffer
+	arcAdd( net, 0, 0, 0, true );
+	arcAdd( net, 0, 0, 1, false );
+
+	for( i = 1; i <= stages; i++ )
+	    {
+	    unsigned int buffer = i, free = stages + i, busy = 2 * stages + i;
+	    unsigned int empty = 3 * stages + i;
+	    unsigned int start = i, end = stages + i;
+
+	    net.tokens[free] = 1;
+	    net.tokens[empty] = 1;
+
+	    arcAdd( net, buffer - 1, start, 1, true );
+	    arcAdd( net, free, start, 1, true );
+	    arcAdd( net, busy, start, 1, false );
+	    if( i > 1 )
+		arcAdd( net, empty - 1, start, 1, false );
+
+	    arcAdd( net, busy, end, 1, true );
+	    arcAdd( net, empty, end, 1, true );
+	    arcAdd( net, buffer, end, 1, false );
+	    arcAdd( net, free, end, 1, false );
+	    }
+
+	// Sink
+	arcAdd( net, stages, 2 * stages + 1, 1, true );
+	arcAdd( net, 4 * stages, 2 * stages + 1, 1, false );
+}
+
+/*******************************************************************
+* Function Name: mutexMake
+* Description: Places: idle i, critical i, the semaphore.
+* Transitions: enter i, leave i.
+********************************************************************/
+static void mutexMake( PnGenNet &net, unsigned int processes )
+{
+	unsigned int semaphore = 2 * processes;
+
+	netNew( net, 2 * processes + 1, 2 * processes );
+	net.tokens[semaphore] = 1;
+
+	for( unsigned int i = 0; i < processes; i++ )
+	    {
+	    net.tokens[i] = 1;
+
+	    arcAdd( net, i, i, 1, true );
+	    arcAdd( net, semaphore, i, 1, true );
+	    arcAdd( net, processes + i, i, 1, false );
+
+	    arcAdd( net, processes + i, processes + i, 1, true );
+	    arcAdd( net, i, processes + i, 1, false );
+	    arcAdd( net, semaphore, processes + i, 1, false );
+	    }
+}
+
+/*******************************************************************
+* Function Name: randomMake
+********************************************************************/
+static void randomMake( PnGenNet &net, unsigned int places, unsigned int transitions,
+			unsigned int fanIn, unsigned int fanOut,
+			unsigned long long tokens, unsigned long long seed )
+{
+	vector<unsigned int> picked;
+	unsigned long long draws = 0;
+	unsigned int t, i;
+
+	netNew( net, places, transitions );
+	net.tokens.assign( places, tokens );
+
+	// The first input place of transition t is place t % P, so that
+	// no place keeps its tokens for want of a transition taking them
+	for( t = 0; t < transitions; t++ )
+	    {
+	    pick( picked, fanIn, places, seed, draws );
+	    if( !picked.empty() &&
+		find( picked.begin(), picked.end(), t % places ) == picked.end() )
+		picked[0] = t % places;
+
+	    for( i = 0; i < picked.size(); i++ )
+		arcAdd( net, picked[i], t, 1, true );
+
+	    pick( picked, fanOut, places, seed, draws );
+	    for( i = 0; i < picked.size(); i++ )
+		arcAdd( net, picked[i], t, 1, false );
+	    }
+}
+
+/*******************************************************************
+* Function Name: inhibitorMake
+* Description: Transition i moves a token from ring place i to the
+* next one unless one of its inhibitor places, other ring places,
+* is marked.  Transition P + i does it without inhibitor.
+********************************************************************/
+static void inhibitorMake( PnGenNet &net, unsigned int places, unsigned int inhibitors,
+			   unsigned long long tokens, unsigned long long seed )
+{
+	vector<unsigned int> picked;
+	unsigned long long draws = 0;
+	unsigned int p, i, added;
+
+	netNew( net, places, 2 * places );
+
+	for( p = 0; p < places; p += 8 )
+	    net.tokens[p] = tokens;
+
+	for( p = 0; p < places; p++ )
+	    {
+	    unsigned int next = ( p + 1 ) % places;
+
+	    arcAdd( net, p, p, 1, true );
+	    arcAdd( net, next, p, 1, false );
+
+	    // Two picks more in case the ring places come up
+	    pick( picked, inhibitors + 2, places, seed, draws );
+	    for( i = 0, added = 0; i < picked.size() && added < inhibitors; i++ )
+		if( picked[i] != p && picked[i] != next )
+		    {
+		    arcAdd( net, picked[i], p, 0, true );
+		    added++;
+		    }
+
+	    arcAdd( net, p, places + p, 1, true );
+	    arcAdd( net, next, places + p, 1, false );
+	    }
+}
+
+/*******************************************************************
+* Function Name: netWrite
+* Description: Writes the net as a .ma file.  Parallel arcs between
+* the same place and transition are written once per arc.
+********************************************************************/
+static void netWrite( const PnGenNet &net, const string &title, const char *delay )
+{
+	vector<vector<unsigned int> > thresholds( net.places );
+	unsigned int i;
+
+	printf( "%% %s, generated by pngen\n", title.c_str() );
+	printf( "[top]\n" );
+
+	for( i = 0; i < net.places; i++ )
+	    printf( "%sP%u@pnPlace%s", i % 10 == 0 ? "components : " : "", i + 1,
+		    i % 10 == 9 || i + 1 == net.places ? "\n" : " " );
+
+	for( i = 0; i < net.transitions; i++ )
+	    printf( "%sT%u@pnTrans%s", i % 10 == 0 ? "components : " : "", i + 1,
+		    i % 10 == 9 || i + 1 == net.transitions ? "\n" : " " );
+
+	printf( "\n" );
+
+	for( i = 0; i < net.arcs.size(); i++ )
+	    {
+	    const PnGenArc &arc = net.arcs[i];
+
+	    if( arc.input )
+		{
+		printf( "Link : out@P%u\tin%u@T%u\n", arc.place + 1, arc.weight, arc.trans + 1 );
+		thresholds[arc.place].push_back( arc.weight );
+		}
+	    else
+		printf( "Link : out%u@T%u\tin@P%u\n", arc.weight, arc.trans + 1, arc.place + 1 );
+	    }
+
+	printf( "\n" );
+
+	for( i = 0; i < net.arcs.size(); i++ )
+	    if( net.arcs[i].input && net.arcs[i].weight != 0 )
+		printf( "Link : fired@T%u\tin@P%u\n", net.arcs[i].trans + 1,
+			net.arcs[i].place + 1 );
+
+	for( i = 0; i < net.places; i++ )
+	    {
+	    vector<unsigned int> &list = thresholds[i];
+
+	    sort( list.begin(), list.end() );
+	    list.erase( unique( list.begin(), list.end() ), list.end() );
+
+	    printf( "\n[P%u]\n", i + 1 );
+	    if( net.tokens[i] != 0 )
+		printf( "tokens : %llu\n", net.tokens[i] );
+
+	    printf( "thresholds :" );
+	    if( list.empty() )
+		printf( " none" );
+	    for( unsigned int k = 0; k < list.size(); k++ )
+		printf( " %u", list[k] );
+	    printf( "\n" );
+	    }
+
+	if( delay != NULL )
+	    for( i = 0; i < net.transitions; i++ )
+		printf( "\n[T%u]\ndelay : %s\n", i + 1, delay );
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-sSEED] [-dDELAY] [-mTOKENS] KIND SIZE...\n"
+		 "  pipeline N | mutex N | random P T IN OUT | inhibitor P K\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	unsigned long long seed = 1, tokens = 1;
+	const char *delay = NULL;
+	vector<const char *> words;
+	vector<unsigned long> sizes;
+	PnGenNet net;
+	string title;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		words.push_back( opt );
+	    else if( opt[1] == 's' )
+		seed = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'd' )
+		delay = opt + 2;
+	    else if( opt[1] == 'm' )
+		tokens = strtoull( opt + 2, NULL, 10 );
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( words.empty() )
+	    return usage( argv[0] );
+
+	title = words[0];
+	for( i = 1; i < words.size(); i++ )
+	    {
+	    sizes.push_back( strtoul( words[i], NULL, 10 ) );
+	    if( sizes.back() == 0 )
+		return usage( argv[0] );
+	    title += string( " " ) + words[i];
+	    }
+
+	if( strcmp( words[0], "pipeline" ) == 0 && sizes.size() == 1 )
+	    pipelineMake( net, sizes[0] );
+	else if( strcmp( words[0], "mutex" ) == 0 && sizes.size() == 1 )
+	    mutexMake( net, sizes[0] );
+	else if( strcmp( words[0], "random" ) == 0 && sizes.size() == 4 )
+	    randomMake( net, sizes[0], sizes[1], sizes[2], sizes[3], tokens, seed );
+	else if( strcmp( words[0], "inhibitor" ) == 0 && sizes.size() == 2 )
+	    inhibitorMake( net, sizes[0], sizes[1], tokens, seed );
+	else
+	    return usage( argv[0] );
+
+	netWrite( net, title, delay );
+
+	return 0;
+}
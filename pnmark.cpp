@@ -0,0 +1,295 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Marking Tool
+*
+*  pnmark generates the Petri Net marking file (.pn) of a simulation
+*  from its log file (.log).  The log is read in a single pass, one
+*  line at a time, so the memory used does not depend on the size
+*  of the log.
+*
+*  The net is loaded from its .ma file (see pnNetDef.h).  Only the
+*  firings are taken from the log: a transition fires when the
+*  simulator activates it (a "Mensaje *" line addressed to it) and
+*  it sends its output messages.  The marking is then updated with
+*  the arcs of the transition.  It therefore does not depend on
+*  the places advertising every change of their contents, nor on
+*  the encoding of the messages.
+*
+*  Usage:
+*
+*  pnmark file.ma file.log [file.pn] [-cfile.csv]
+*
+*  Without a .pn file the marking is written to the standard
+*  output.  With -c the marking after every firing is also written
+*  as a CSV time series, one line per firing:
+*
+*  Count/ Steps;Time/ ms;p1;p2;p3;
+*  0;0;2;1;4;
+*  1;18000;3;1;4;
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnmark pnmark.cpp pnNetDef.cpp pnNetHpx.cpp
+*     pnNetImage.cpp pnRandom.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include <stdio.h>	// fopen(), fgets()
+#include <string.h>	// strncmp(), strstr()
+#include <ctype.h>	// tolower()
+#include <map>
+
+/** private data **/
+
+// Names of the transitions, lower case as in the log, with their
+// index in the net
+static map<string, unsigned int> transIds;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: lowerCase
+* Description: Returns a lower case copy of a string.
+********************************************************************/
+static string lowerCase( const string &str )
+{
+	string result( str );
+
+	for( unsigned int i = 0; i < result.size(); i++ )
+	    result[i] = tolower( result[i] );
+
+	return result;
+}
+
+/*******************************************************************
+* Function Name: modelName
+* Description: Returns the name of a model written as "t2(15)" in
+* the log, without the ID.  text points to the first character of
+* the name.
+********************************************************************/
+static string modelName( const char *text )
+{
+	const char *end = text;
+
+	while( *end != '\0' && *end != '(' && *end != ' ' && *end != '\n' )
+	    end++;
+
+	return string( text, end - text );
+}
+
+/*******************************************************************
+* Function Name: timeMsecs
+* Description: Converts a time written as hh:mm:ss:mmm to
+* milliseconds.
+********************************************************************/
+static long long timeMsecs( const char *text )
+{
+	int h = 0, m = 0, s = 0, ms = 0;
+
+	sscanf( text, "%d:%d:%d:%d", &h, &m, &s, &ms );
+
+	return ( ( h * 60LL + m ) * 60 + s ) * 1000 + ms;
+}
+
+/*******************************************************************
+* Function Name: markingPrint
+* Description: Prints a marking as (m1,m2,...).
+********************************************************************/
+static void markingPrint( FILE *out, const vector<PnTokens> &marking )
+{
+	fputc( '(', out );
+
+	for( unsigned int p = 0; p < marking.size(); p++ )
+	    fprintf( out, p == 0 ? "%lld" : ",%lld", marking[p] );
+
+	fputc( ')', out );
+}
+
+/*******************************************************************
+* Function Name: csvPrint
+* Description: Prints a line of the CSV time series.
+********************************************************************/
+static void csvPrint( FILE *csv, unsigned long step, long long time,
+		      const vector<PnTokens> &marking )
+{
+	fprintf( csv, "%lu;%lld;", step, time );
+
+	for( unsigned int p = 0; p < marking.size(); p++ )
+	    fprintf( csv, "%lld;", marking[p] );
+
+	fputc( '\n', csv );
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s file.ma file.log [file.pn] [-cfile.csv]\n",
+		 prog );
+
+	return 1;
+}
+
+/*******************************************************************
+* Function Name: hasSuffix
+********************************************************************/
+static bool hasSuffix( const string &name, const string &suffix )
+{
+	return name.size() > suffix.size() &&
+	       name.compare( name.size() - suffix.size(), suffix.size(), suffix ) == 0;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	string maFile, logFile, pnFile, csvFile;
+	PnNetDef net;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    string name( argv[arg] );
+
+	    if( name.compare( 0, 2, "-c" ) == 0 )
+		csvFile = name.substr( 2 );
+	    else if( hasSuffix( name, ".ma" ) && maFile.empty() )
+		maFile = name;
+	    else if( hasSuffix( name, ".log" ) && logFile.empty() )
+		logFile = name;
+	    else if( hasSuffix( name, ".pn" ) && pnFile.empty() )
+		pnFile = name;
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( maFile.empty() || logFile.empty() )
+	    return usage( argv[0] );
+
+	try
+	   {
+	   pnNetLoadMa( maFile, net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	FILE *log = fopen( logFile.c_str(), "r" );
+	FILE *out = pnFile.empty() ? stdout : fopen( pnFile.c_str(), "w" );
+	FILE *csv = csvFile.empty() ? NULL : fopen( csvFile.c_str(), "w" );
+
+	if( log == NULL || out == NULL || ( !csvFile.empty() && csv == NULL ) )
+	    {
+	    fprintf( stderr, "%s: cannot open the files\n", argv[0] );
+	    return 1;
+	    }
+
+	static char logBuffer[1 << 16];
+	setvbuf( log, logBuffer, _IOFBF, sizeof( logBuffer ) );
+
+	if( !pnFile.empty() )
+	    printf( "\nGenerating marking for Petri Net model ... " );
+
+	// Header of the marking file
+	fprintf( out, "\nPetri Net places: " );
+	for( i = 0; i < net.places(); i++ )
+	    fprintf( out, "%s ", lowerCase( net.placeName[i] ).c_str() );
+
+	fprintf( out, "\nPetri Net transitions: " );
+	for( i = 0; i < net.transitions(); i++ )
+	    {
+	    transIds[lowerCase( net.transName[i] )] = i;
+	    fprintf( out, "%s ", lowerCase( net.transName[i] ).c_str() );
+	    }
+	fprintf( out, "\n\n" );
+
+	vector<PnTokens> marking( net.initMarking );
+	vector<bool> activated( net.transitions(), false );
+	unsigned long step = 0;
+	char line[1024];
+
+	if( csv != NULL )
+	    {
+	    fprintf( csv, "Count/ Steps;Time/ ms;" );
+	    for( i = 0; i < net.places(); i++ )
+		fprintf( csv, "%s;", lowerCase( net.placeName[i] ).c_str() );
+	    fputc( '\n', csv );
+	    csvPrint( csv, step, 0, marking );
+	    }
+
+	while( fgets( line, sizeof( line ), log ) != NULL )
+	    {
+	    // Lines look like "Mensaje * / 00:01:00:000 / top(01)
+	    // para t2(15)" and "Mensaje Y / 00:01:00:000 / t2(15) /
+	    // out1 / 1.000 para top(01)"
+	    if( strncmp( line, "Mensaje ", 8 ) != 0 )
+		continue;
+
+	    char type = line[8];
+	    const char *time = strstr( line, " / " );
+	    const char *model = time == NULL ? NULL : strstr( time + 3, " / " );
+	    map<string, unsigned int>::iterator t;
+
+	    if( model == NULL )
+		continue;
+
+	    time += 3;
+	    model += 3;
+
+	    if( type == '*' )
+		{
+		const char *target = strstr( model, " para " );
+
+		if( target != NULL &&
+		    ( t = transIds.find( modelName( target + 6 ) ) ) != transIds.end() )
+		    activated[t->second] = true;
+		}
+	    else if( type == 'Y' )
+		{
+		t = transIds.find( modelName( model ) );
+
+		if( t == transIds.end() || !activated[t->second] )
+		    continue;
+
+		// First output of an activated transition: it fires
+		unsigned int trans = t->second;
+		unsigned int a;
+
+		activated[trans] = false;
+
+		markingPrint( out, marking );
+		fprintf( out, "\n\t|\n\t|\n\t%s\n\t|\n\tV\n", t->first.c_str() );
+
+		for( a = net.preStart[trans]; a < net.preStart[trans + 1]; a++ )
+		    marking[net.prePlace[a]] -= net.preWeight[a];
+
+		for( a = net.postStart[trans]; a < net.postStart[trans + 1]; a++ )
+		    marking[net.postPlace[a]] += net.postWeight[a];
+
+		if( csv != NULL )
+		    csvPrint( csv, ++step, timeMsecs( time ), marking );
+		}
+	    }
+
+	markingPrint( out, marking );
+	fputc( '\n', out );
+
+	fclose( log );
+	if( out != stdout )
+	    fclose( out );
+	if( csv != NULL )
+	    fclose( csv );
+
+	if( !pnFile.empty() )
+	    printf( "DONE\n" );
+
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Parallel Simulation Tool
+*
+*  pnpar runs one long simulation of a timed Petri Net on several
+*  threads and reports, for every place, its time averaged number
+*  of tokens and, for every transition, its throughput (firings per
+*  second).  The net is split in partitions which exchange tokens
+*  through lock free rings and wait for each other only as long as
+*  a deposit could still arrive from another partition (see
+*  pnPart.h).
+*
+*  The results do not depend on the number of partitions: they are
+*  the ones of replication 0 of pnrep run with the same seed, unless
+*  random choices are made between immediate transitions.  Only the
+*  transitions with a minimum delay above zero (deterministic,
+*  uniform or discrete) can have arcs to another partition, so a net
+*  of exponential transitions is not split.
+*
+*  Usage:
+*
+*  pnpar [-tTIME] [-wWARMUP] [-sSEED] [-jPARTS] file.ma|file.hpx
+*
+*  -t	length of the simulation in seconds (default 3600)
+*  -w	warm up period in seconds, not measured (default 0)
+*  -s	seed of the run (default 1)
+*  -j	most partitions, one thread each (default: one per processor)
+*
+*  For example:
+*
+*  -> pnpar -t360000 -j8 multiprocessing.ma
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnpar pnpar.cpp pnPart.cpp pnEngine.cpp pnEvents.cpp
+*     pnPool.cpp pnNetDef.cpp pnNetHpx.cpp pnNetImage.cpp pnRandom.cpp
+*     -lpthread
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnPart.h"	// class PnParallel
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), atof()
+#include <thread>	// thread::hardware_concurrency()
+#include <chrono>	// steady_clock
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-tTIME] [-wWARMUP] [-sSEED] [-jPARTS] "
+		 "file.ma|file.hpx\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	unsigned int parts = 0;
+	double length = 3600, warmup = 0;
+	unsigned long long seed = 1;
+	const char *fileName = NULL;
+	PnNetDef net;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		fileName = opt;
+	    else if( opt[1] == 't' )
+		length = atof( opt + 2 );
+	    else if( opt[1] == 'w' )
+		warmup = atof( opt + 2 );
+	    else if( opt[1] == 's' )
+		seed = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'j' )
+		parts = strtoul( opt + 2, NULL, 10 );
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( fileName == NULL || length <= 0 || warmup < 0 )
+	    return usage( argv[0] );
+
+	if( parts == 0 )
+	    parts = thread::hardware_concurrency();
+
+	try
+	   {
+	   pnNetLoad( fileName, net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	PnParallel parallel( net, parts );
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+
+	try
+	   {
+	   // Same seed as replication 0 of pnrep
+	   parallel.simulate( warmup, warmup + length, pnRand64( seed, ~0ULL, 0 ) );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	double elapsed = chrono::duration<double>( chrono::steady_clock::now() - start ).count();
+
+	printf( "%g seconds after a warm up of %g seconds, %u partitions,"
+		" %u cut arcs, %llu deposits, %.3f s\n", length, warmup,
+		parallel.partitions(), parallel.cutArcs(), parallel.deposits(),
+		elapsed );
+
+	printf( "\n%-20s %14s\n", "Place", "Tokens" );
+	for( i = 0; i < net.places(); i++ )
+	    printf( "%-20s %14.6g\n", net.placeName[i].c_str(), parallel.tokens()[i] );
+
+	printf( "\n%-20s %14s\n", "Transition", "Firings/s" );
+	for( i = 0; i < net.transitions(); i++ )
+	    printf( "%-20s %14.6g\n", net.transName[i].c_str(), parallel.throughput()[i] );
+
+	return 0;
+}
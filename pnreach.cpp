@@ -0,0 +1,220 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Reachability Tool
+*
+*  pnreach explores every marking a net can reach (see pnReach.h)
+*  and reports the number of states, the deadlocks, the bound of
+*  every place and the markings breaking the checks given with -a.
+*  Unlike a simulation it proves that a deadlock or a violation
+*  cannot happen.
+*
+*  The P-invariants of the net (see pnStruct.h) are computed first
+*  and one place per invariant is left out of the stored markings,
+*  which makes them smaller.
+*
+*  Usage:
+*
+*  pnreach [-jWORKERS] [-mMAXSTATES] [-p] [-aCHECK]... file.ma|file.hpx
+*
+*  -j	number of worker threads (default: one per processor)
+*  -m	stop after that many states (default: no limit)
+*  -p	store every place, without using the P-invariants
+*  -a	check that a sum of places never exceeds a limit, for
+*	instance -aP3+P7<=1 for a mutual exclusion
+*
+*  The tool returns 0 if the whole state space was explored with
+*  no deadlock and no violation, 2 otherwise.
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnreach pnreach.cpp pnReach.cpp pnPool.cpp
+*     pnStruct.cpp pnNetDef.cpp pnNetHpx.cpp pnNetImage.cpp
+*     pnRandom.cpp -lpthread
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnReach.h"	// class PnReach
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), atoll()
+#include <time.h>	// clock()
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: markingPrint
+* Description: Prints the marked places of a marking.
+********************************************************************/
+static void markingPrint( const PnNetDef &net, const vector<PnTokens> &marking )
+{
+	bool empty = true;
+
+	for( unsigned int p = 0; p < marking.size(); p++ )
+	    if( marking[p] != 0 )
+		{
+		printf( " %s=%lld", net.placeName[p].c_str(), marking[p] );
+		empty = false;
+		}
+
+	printf( empty ? " (empty)\n" : "\n" );
+}
+
+/*******************************************************************
+* Function Name: checkParse
+* Description: Parses a check such as "P3+P7<=1".  Returns false if
+* the text is not a valid check.
+********************************************************************/
+static bool checkParse( const PnNetDef &net, const string &text, PnReachCheck &check )
+{
+	string::size_type le = text.find( "<=" );
+
+	if( le == string::npos )
+	    return false;
+
+	string sum( text.substr( 0, le ) );
+	string::size_type start = 0;
+
+	check.text = text;
+	check.places.clear();
+	check.limit = atoll( text.c_str() + le + 2 );
+
+	while( start <= sum.size() )
+	    {
+	    string::size_type plus = sum.find( '+', start );
+
+	    if( plus == string::npos )
+		plus = sum.size();
+
+	    int p = net.placeIndex( sum.substr( start, plus - start ) );
+
+	    if( p < 0 )
+		return false;
+
+	    check.places.push_back( p );
+	    start = plus + 1;
+	    }
+
+	return !check.places.empty();
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-jWORKERS] [-mMAXSTATES] [-p] [-aCHECK]... "
+		 "file.ma|file.hpx\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	unsigned int workers = 0;
+	unsigned long long maxStates = 0;
+	bool invariants = true;
+	vector<string> checkTexts;
+	const char *fileName = NULL;
+	PnNetDef net;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		fileName = opt;
+	    else if( opt[1] == 'j' )
+		workers = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'm' )
+		maxStates = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'p' )
+		invariants = false;
+	    else if( opt[1] == 'a' )
+		checkTexts.push_back( opt + 2 );
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( fileName == NULL )
+	    return usage( argv[0] );
+
+	try
+	   {
+	   pnNetLoad( fileName, net );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	PnReach reach( net, workers );
+
+	reach.maxStatesSet( maxStates );
+
+	if( invariants )
+	    {
+	    vector<PnInvariant> inv;
+
+	    try
+	       {
+	       pnInvariantsP( net, inv );
+	       printf( "%u places left out by %u P-invariants\n",
+		       reach.invariantsUse( inv ), (unsigned int) inv.size() );
+	       }
+	    catch( PnNetError &err )
+	       {
+	       printf( "No P-invariants: %s\n", err.message().c_str() );
+	       }
+	    }
+
+	for( i = 0; i < checkTexts.size(); i++ )
+	    {
+	    PnReachCheck check;
+
+	    if( !checkParse( net, checkTexts[i], check ) )
+		{
+		fprintf( stderr, "%s: invalid check %s\n", argv[0], checkTexts[i].c_str() );
+		return 1;
+		}
+
+	    reach.checkAdd( check );
+	    }
+
+	time_t start = time( NULL );
+	bool complete = reach.explore();
+
+	printf( "%s: %llu states, %llu edges, %u levels, %u bits per state, %ld s\n",
+		complete ? "Complete" : "INCOMPLETE", reach.states(), reach.edges(),
+		reach.levels(), reach.markingBits(), (long) ( time( NULL ) - start ) );
+
+	printf( "\n%llu deadlocks\n", reach.deadlocks() );
+	for( i = 0; i < reach.deadlockExamples().size(); i++ )
+	    markingPrint( net, reach.deadlockExamples()[i] );
+
+	printf( "\n%-20s %s\n", "Place", "Bound" );
+	for( i = 0; i < net.places(); i++ )
+	    printf( "%-20s %lld\n", net.placeName[i].c_str(), reach.bounds()[i] );
+
+	bool violated = false;
+
+	for( i = 0; i < reach.checkResults().size(); i++ )
+	    {
+	    const PnReachCheck &check = reach.checkResults()[i];
+
+	    printf( "\n%s: %llu violations\n", check.text.c_str(), check.violations );
+	    if( check.violations != 0 )
+		{
+		violated = true;
+		markingPrint( net, check.example );
+		}
+	    }
+
+	return complete && reach.deadlocks() == 0 && !violated ? 0 : 2;
+}
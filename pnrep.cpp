@@ -0,0 +1,405 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Replication Tool
+*
+*  pnrep runs many independent replications of a timed Petri Net
+*  and reports, for every place, its time averaged number of tokens
+*  and, for every transition, its throughput (firings per second),
+*  each with a 95% confidence interval over the replications.
+*
+*  The net is loaded once from a Petri Net .ma file or an HPSIM .hpx
+*  file (see pnNetDef.h) and every worker thread fires it with its
+*  own PnEngine, so a replication costs no parsing, no model
+*  construction and no log.
+*  The replications are spread over the processors by a work
+*  stealing pool (see pnPool.h).  Replication r draws its delays
+*  with a seed derived from the seed of the run and r: the results
+*  do not depend on the number of workers.  When the P-invariants
+*  prove the net 1-safe the engines fire it in safe mode, on bitset
+*  markings (see pnEngine.h).
+*
+*  A long warm up can be fired once and saved in a checkpoint (see
+*  pnCheckpoint.h) with -c; the replications of the following runs
+*  then start from the saved state with -r instead of the initial
+*  marking, each with its own seed.  The times of those runs count
+*  from the checkpoint, and -w adds a warm up after it.
+*
+*  Usage:
+*
+*  pnrep [-nREPS] [-tTIME] [-wWARMUP] [-sSEED] [-jWORKERS] [-g]
+*	[-qheap|-qladder] [-cSTATE|-rSTATE] file.ma|file.hpx
+*
+*  -n	number of replications (default 100)
+*  -t	length of a replication in seconds (default 3600)
+*  -w	warm up period in seconds, not measured (default 0)
+*  -s	seed of the run (default 1)
+*  -j	number of worker threads (default: one per processor)
+*  -g	keep the general engine even for a 1-safe net
+*  -q	event list of the engines (default heap, see pnEvents.h)
+*  -c	fire the warm up once, save the state reached in STATE and
+*	stop
+*  -r	start the replications from the state saved in STATE
+*
+*  For example:
+*
+*  -> pnrep -n5000 -t36000 -w3600 scheduling.ma
+*  -> pnrep -w360000 -cwarm.pnc scheduling.ma
+*  -> pnrep -n5000 -t36000 -rwarm.pnc scheduling.ma
+*
+*  Build it with:
+*
+*  -> g++ -O2 -mavx2 -o pnrep pnrep.cpp pnPool.cpp pnEngine.cpp
+*     pnEvents.cpp pnStruct.cpp pnCheckpoint.cpp pnNetDef.cpp
+*     pnNetHpx.cpp pnNetImage.cpp pnRandom.cpp -lpthread
+*
+*  Leave out -mavx2 on a processor without AVX2.
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnNetDef.h"	// class PnNetDef
+#include "pnEngine.h"	// class PnEngine
+#include "pnPool.h"	// class PnPool
+#include "pnStruct.h"	// pnNetSafe()
+#include "pnCheckpoint.h"	// pnCheckpointRead(), pnCheckpointWrite()
+#include <stdio.h>	// printf()
+#include <stdlib.h>	// strtoull(), atof()
+#include <math.h>	// sqrt()
+
+/** private data **/
+
+// Two sided 95% quantiles of the Student t distribution for 1 to
+// 30 degrees of freedom
+static const double tQuantile[30] =
+    {
+    12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+    2.201, 2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+    2.080, 2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042
+    };
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: tQuantileGet
+* Description: Returns the 95% quantile of the Student t
+* distribution.  Above 30 degrees of freedom the normal quantile
+* corrected to the first order is accurate to 3 digits.
+********************************************************************/
+static double tQuantileGet( unsigned int freedom )
+{
+	if( freedom <= 30 )
+	    return tQuantile[freedom - 1];
+
+	return 1.96 + 2.4 / freedom;
+}
+
+// Replications of a net.  The results of replication r are
+// stored in row r of the result tables so the statistics are
+// computed in the same order whatever worker ran it.
+class PnReplication : public PnTask
+{
+public:
+	PnReplication( const PnNetDef &net, unsigned int reps,
+		       unsigned int workers, double length,
+		       double warmup, unsigned long long seed, bool safe,
+		       PnEventListKind list, const PnEngineState *start );
+
+	~PnReplication();
+
+	void run( unsigned int rep, unsigned int worker );
+
+	// Time averaged tokens of the places and throughput of the
+	// transitions, one row per replication
+	vector<double> tokens;
+	vector<double> throughput;
+
+	// Error which stopped a replication, empty if none
+	vector<string> errors;
+
+private:
+	const PnNetDef &net;
+	vector<PnEngine *> engines;
+	double length;
+	double warmup;
+	unsigned long long seed;
+	const PnEngineState *start;	// state to start from, NULL if none
+
+};	// class PnReplication
+
+/*******************************************************************
+* Function Name: PnReplication constructor
+* Description: Creates one engine per worker, in safe mode if
+* the net was proven 1-safe.
+********************************************************************/
+PnReplication::PnReplication( const PnNetDef &def, unsigned int reps,
+			      unsigned int workers, double len,
+			      double warm, unsigned long long runSeed, bool safe,
+			      PnEventListKind list, const PnEngineState *startState )
+: tokens( (size_t) reps * def.places() )
+, throughput( (size_t) reps * def.transitions() )
+, errors( reps )
+, net( def )
+, length( len )
+, warmup( warm )
+, seed( runSeed )
+, start( startState )
+{
+	for( unsigned int w = 0; w < workers; w++ )
+	    engines.push_back( new PnEngine( net, safe, list ) );
+}
+
+/*******************************************************************
+* Function Name: PnReplication destructor
+********************************************************************/
+PnReplication::~PnReplication()
+{
+	for( unsigned int w = 0; w < engines.size(); w++ )
+	    delete engines[w];
+}
+
+/*******************************************************************
+* Function Name: run
+* Description: Runs one replication.  The area under the number of
+* tokens of a place is only brought up to date when a firing
+* touches the place, so a firing costs the same as in the engine.
+* The immediate firings which follow a firing happen at the same
+* time, so the count a place held before them is kept aside.
+********************************************************************/
+void PnReplication::run( unsigned int rep, unsigned int worker )
+{
+	PnEngine &engine = *engines[worker];
+	double end = warmup + length;
+	vector<double> area( net.places(), 0 );
+	vector<double> since( net.places(), warmup );
+	vector<PnTokens> level( net.places() );
+	vector<unsigned long> fired( net.transitions(), 0 );
+	unsigned int p, a, i;
+
+	try
+	   {
+	   // Replication r uses stream ~0 of the run seed, which no
+	   // transition uses, to get its own seed
+	   if( start != NULL )
+	       engine.stateSet( *start, 0, pnRand64( seed, ~0ULL, rep ) );
+	   else
+	       engine.reset( 0, pnRand64( seed, ~0ULL, rep ) );
+
+	   while( engine.pending() && engine.nextTime() <= warmup )
+	       engine.fire();
+
+	   for( p = 0; p < net.places(); p++ )
+	       level[p] = engine.tokens( p );
+
+	   while( engine.pending() && engine.nextTime() <= end )
+	       {
+	       double time = engine.nextTime();
+
+	       engine.fire();
+
+	       const vector<unsigned int> &list = engine.lastFired();
+
+	       for( i = 0; i < list.size(); i++ )
+		   {
+		   unsigned int t = list[i];
+
+		   for( a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+		       {
+		       p = net.prePlace[a];
+		       area[p] += level[p] * ( time - since[p] );
+		       since[p] = time;
+		       level[p] = engine.tokens( p );
+		       }
+
+		   for( a = net.postStart[t]; a < net.postStart[t + 1]; a++ )
+		       {
+		       p = net.postPlace[a];
+		       area[p] += level[p] * ( time - since[p] );
+		       since[p] = time;
+		       level[p] = engine.tokens( p );
+		       }
+
+		   fired[t]++;
+		   }
+	       }
+	   }
+	catch( PnNetError &err )
+	   {
+	   errors[rep] = err.message();
+	   return;
+	   }
+
+	for( p = 0; p < net.places(); p++ )
+	    {
+	    area[p] += level[p] * ( end - since[p] );
+	    tokens[(size_t) rep * net.places() + p] = area[p] / length;
+	    }
+
+	for( unsigned int t = 0; t < net.transitions(); t++ )
+	    throughput[(size_t) rep * net.transitions() + t] = fired[t] / length;
+}
+
+/*******************************************************************
+* Function Name: statPrint
+* Description: Prints the mean of column <col> of a result table
+* and the half width of its 95% confidence interval.
+********************************************************************/
+static void statPrint( const string &name, const vector<double> &table,
+		       unsigned int cols, unsigned int col, unsigned int reps )
+{
+	double sum = 0, sumSq = 0, mean, dev;
+	unsigned int r;
+
+	for( r = 0; r < reps; r++ )
+	    sum += table[(size_t) r * cols + col];
+
+	mean = sum / reps;
+
+	for( r = 0; r < reps; r++ )
+	    {
+	    dev = table[(size_t) r * cols + col] - mean;
+	    sumSq += dev * dev;
+	    }
+
+	if( reps > 1 )
+	    printf( "%-20s %14.6g +/- %-12.4g\n", name.c_str(), mean,
+		    tQuantileGet( reps - 1 ) * sqrt( sumSq / ( reps - 1 ) / reps ) );
+	else
+	    printf( "%-20s %14.6g\n", name.c_str(), mean );
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-nREPS] [-tTIME] [-wWARMUP] [-sSEED] "
+		 "[-jWORKERS] [-g] [-qheap|-qladder] [-cSTATE|-rSTATE] "
+		 "file.ma|file.hpx\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	unsigned int reps = 100, workers = 0;
+	double length = 3600, warmup = 0;
+	unsigned long long seed = 1;
+	const char *fileName = NULL, *saveName = NULL, *loadName = NULL;
+	bool general = false, safe;
+	PnEventListKind list = PN_LIST_HEAP;
+	PnNetDef net;
+	PnEngineState start;
+	unsigned int i;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    {
+	    const char *opt = argv[arg];
+
+	    if( opt[0] != '-' )
+		fileName = opt;
+	    else if( opt[1] == 'n' )
+		reps = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 't' )
+		length = atof( opt + 2 );
+	    else if( opt[1] == 'w' )
+		warmup = atof( opt + 2 );
+	    else if( opt[1] == 's' )
+		seed = strtoull( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'j' )
+		workers = strtoul( opt + 2, NULL, 10 );
+	    else if( opt[1] == 'g' )
+		general = true;
+	    else if( opt[1] == 'q' )
+		{
+		if( !pnEventListParse( opt + 2, list ) )
+		    return usage( argv[0] );
+		}
+	    else if( opt[1] == 'c' && opt[2] != '\0' )
+		saveName = opt + 2;
+	    else if( opt[1] == 'r' && opt[2] != '\0' )
+		loadName = opt + 2;
+	    else
+		return usage( argv[0] );
+	    }
+
+	if( fileName == NULL || reps == 0 || length <= 0 || warmup < 0 ||
+	    ( saveName != NULL && loadName != NULL ) )
+	    return usage( argv[0] );
+
+	try
+	   {
+	   pnNetLoad( fileName, net );
+
+	   if( loadName != NULL )
+	       pnCheckpointRead( loadName, net, start );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	safe = !general && pnNetSafe( net );
+
+	// The warm up is fired with the seed of replication 0
+	if( saveName != NULL )
+	    {
+	    PnEngine engine( net, safe, list );
+
+	    try
+	       {
+	       engine.reset( 0, pnRand64( seed, ~0ULL, 0 ) );
+
+	       while( engine.pending() && engine.nextTime() <= warmup )
+		   engine.fire();
+
+	       pnCheckpointWrite( saveName, engine, warmup );
+	       }
+	    catch( PnNetError &err )
+	       {
+	       fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	       return 1;
+	       }
+
+	    printf( "State after a warm up of %g seconds, %lu firings, saved in %s\n",
+		    warmup, engine.firings(), saveName );
+
+	    return 0;
+	    }
+
+	PnPool pool( workers );
+	PnReplication replication( net, reps, pool.workers(), length, warmup, seed,
+				 safe, list, loadName != NULL ? &start : NULL );
+
+	pool.run( reps, replication );
+
+	for( i = 0; i < reps; i++ )
+	    if( !replication.errors[i].empty() )
+		{
+		fprintf( stderr, "%s: replication %u: %s\n", argv[0], i,
+			 replication.errors[i].c_str() );
+		return 1;
+		}
+
+	printf( "%u replications of %g seconds after a warm up of %g seconds,"
+		" %u workers%s\n", reps, length, warmup, pool.workers(),
+		safe ? ", 1-safe" : "" );
+
+	if( loadName != NULL )
+	    printf( "Started from the state of %s at %g seconds\n", loadName, start.time );
+
+	printf( "\n%-20s %14s     %s\n", "Place", "Tokens", "95% CI" );
+	for( i = 0; i < net.places(); i++ )
+	    statPrint( net.placeName[i], replication.tokens, net.places(), i, reps );
+
+	printf( "\n%-20s %14s     %s\n", "Transition", "Firings/s", "95% CI" );
+	for( i = 0; i < net.transitions(); i++ )
+	    statPrint( net.transName[i], replication.throughput, net.transitions(), i, reps );
+
+	return 0;
+}
@@ -0,0 +1,193 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Structural Analysis Tool
+*
+*  pnstruct prints the structural properties of a net (see
+*  pnStruct.h), found from its arcs alone without exploring its
+*  markings, so they are cheap even for nets whose state space is
+*  too large for pnreach:
+*
+*  - the P-invariants with their constant sum in every marking,
+*    the places no invariant covers and the bound the invariants
+*    give to the others;
+*  - the T-invariants, the firing counts restoring a marking;
+*  - the minimal siphons and traps.  A siphon empty in the initial
+*    marking stays empty, so the transitions taking tokens from it
+*    can never fire.  A siphon holding an initially marked trap can
+*    never be emptied.
+*
+*  Usage:
+*
+*  pnstruct file.ma|file.hpx
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pnstruct pnstruct.cpp pnStruct.cpp pnNetDef.cpp
+*     pnNetHpx.cpp pnNetImage.cpp pnRandom.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnStruct.h"	// pnInvariantsP(), ...
+#include <algorithm>	// includes()
+#include <stdio.h>	// printf()
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: invariantPrint
+* Description: Prints a weighted sum of places or transitions.
+********************************************************************/
+static void invariantPrint( const vector<string> &names, const PnInvariant &inv )
+{
+	for( unsigned int i = 0; i < inv.index.size(); i++ )
+	    {
+	    if( i != 0 )
+		printf( " +" );
+	    if( inv.weight[i] != 1 )
+		printf( " %lld*%s", inv.weight[i], names[inv.index[i]].c_str() );
+	    else
+		printf( " %s", names[inv.index[i]].c_str() );
+	    }
+}
+
+/*******************************************************************
+* Function Name: setPrint
+* Description: Prints a set of places.
+********************************************************************/
+static void setPrint( const PnNetDef &net, const PnPlaceSet &s )
+{
+	printf( " {" );
+	for( unsigned int i = 0; i < s.size(); i++ )
+	    printf( i == 0 ? "%s" : ", %s", net.placeName[s[i]].c_str() );
+	printf( "}" );
+}
+
+/*******************************************************************
+* Function Name: marked
+* Description: Returns true if a set of places holds tokens in the
+* initial marking.
+********************************************************************/
+static bool marked( const PnNetDef &net, const PnPlaceSet &s )
+{
+	for( unsigned int i = 0; i < s.size(); i++ )
+	    if( net.initMarking[s[i]] != 0 )
+		return true;
+
+	return false;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	vector<PnInvariant> pInv, tInv;
+	vector<PnPlaceSet> siphons, traps;
+	bool siphonsAll, trapsAll;
+	PnNetDef net;
+	unsigned int i, j, p;
+
+	if( argc != 2 )
+	    {
+	    fprintf( stderr, "usage: %s file.ma|file.hpx\n", argv[0] );
+	    return 1;
+	    }
+
+	try
+	   {
+	   pnNetLoad( argv[1], net );
+	   pnInvariantsP( net, pInv );
+	   pnInvariantsT( net, tInv );
+	   }
+	catch( PnNetError &err )
+	   {
+	   fprintf( stderr, "%s: %s\n", argv[0], err.message().c_str() );
+	   return 1;
+	   }
+
+	siphonsAll = pnSiphons( net, siphons );
+	trapsAll = pnTraps( net, traps );
+
+	// P-invariants and the bounds they give
+	vector<PnTokens> bound( net.places(), -1 );
+
+	printf( "%u P-invariants\n", (unsigned int) pInv.size() );
+	for( i = 0; i < pInv.size(); i++ )
+	    {
+	    PnTokens sum = pnInvariantSum( pInv[i], net.initMarking );
+
+	    invariantPrint( net.placeName, pInv[i] );
+	    printf( " = %lld\n", sum );
+
+	    for( j = 0; j < pInv[i].index.size(); j++ )
+		{
+		PnTokens b = sum / pInv[i].weight[j];
+
+		p = pInv[i].index[j];
+		if( bound[p] < 0 || b < bound[p] )
+		    bound[p] = b;
+		}
+	    }
+
+	printf( "\n%-20s %s\n", "Place", "Bound" );
+	for( p = 0; p < net.places(); p++ )
+	    if( bound[p] < 0 )
+		printf( "%-20s not covered\n", net.placeName[p].c_str() );
+	    else
+		printf( "%-20s %lld\n", net.placeName[p].c_str(), bound[p] );
+
+	printf( "\n%u T-invariants\n", (unsigned int) tInv.size() );
+	for( i = 0; i < tInv.size(); i++ )
+	    {
+	    invariantPrint( net.transName, tInv[i] );
+	    printf( "\n" );
+	    }
+
+	// Siphons, with the traps they hold or the transitions they
+	// kill
+	printf( "\n%u minimal siphons%s\n", (unsigned int) siphons.size(),
+		siphonsAll ? "" : " (search stopped, maybe not all)" );
+	for( i = 0; i < siphons.size(); i++ )
+	    {
+	    setPrint( net, siphons[i] );
+
+	    if( !marked( net, siphons[i] ) )
+		{
+		printf( " EMPTY, dead:" );
+		for( unsigned int t = 0; t < net.transitions(); t++ )
+		    for( unsigned int a = net.preStart[t]; a < net.preStart[t + 1]; a++ )
+			if( net.preWeight[a] != 0 &&
+			    binary_search( siphons[i].begin(), siphons[i].end(), net.prePlace[a] ) )
+			    {
+			    printf( " %s", net.transName[t].c_str() );
+			    break;
+			    }
+		}
+	    else
+		{
+		for( j = 0; j < traps.size(); j++ )
+		    if( marked( net, traps[j] ) &&
+			includes( siphons[i].begin(), siphons[i].end(),
+				  traps[j].begin(), traps[j].end() ) )
+			break;
+
+		if( j < traps.size() )
+		    printf( " holds a marked trap" );
+		}
+
+	    printf( "\n" );
+	    }
+
+	printf( "\n%u minimal traps%s\n", (unsigned int) traps.size(),
+		trapsAll ? "" : " (search stopped, maybe not all)" );
+	for( i = 0; i < traps.size(); i++ )
+	    {
+	    setPrint( net, traps[i] );
+	    printf( marked( net, traps[i] ) ? " marked\n" : "\n" );
+	    }
+
+	return 0;
+}
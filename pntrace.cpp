@@ -0,0 +1,229 @@
+/*******************************************************************
+*
+*  DESCRIPTION: Petri Net Binary Trace Reader
+*
+*  pntrace reads a binary trace written by the PnPlace, PnTrans or
+*  PnNet models (see pnTrace.h).  The file is mapped in memory and
+*  its records are read in place.
+*
+*  Usage:
+*
+*  pntrace [-s] file.pnt
+*
+*  Without option every record is printed, one per line:
+*
+*  00:00:58:000 T1 fired
+*  00:00:58:000 P2 +1
+*
+*  With -s only a summary is printed: the number of firings of
+*  every transition and the final marking of every place.
+*
+*  Build it with:
+*
+*  -> g++ -O2 -o pntrace pntrace.cpp
+*
+*******************************************************************/
+
+/** include files **/
+#include "pnTrace.h"	// PnTraceHeader, PnTraceRecord
+#include <stdio.h>	// printf()
+#include <string.h>	// memcmp()
+#include <sys/mman.h>	// mmap()
+#include <sys/stat.h>	// fstat()
+#include <fcntl.h>	// open()
+#include <unistd.h>	// close()
+#include <map>
+
+/** private types **/
+
+typedef map<pair<int, int>, string> NameMap;
+
+/** private functions **/
+
+/*******************************************************************
+* Function Name: nameGet
+* Description: Returns the name of a place or transition, or its
+* number if the trace has no name for it.
+********************************************************************/
+static string nameGet( const NameMap &names, int kind, int id )
+{
+	NameMap::const_iterator i = names.find( make_pair( kind, id ) );
+	char text[16];
+
+	if( i != names.end() )
+	    return i->second;
+
+	sprintf( text, "#%d", id );
+
+	return text;
+}
+
+/*******************************************************************
+* Function Name: timeStr
+* Description: Formats a time in seconds as the simulator does.
+********************************************************************/
+static string timeStr( double time )
+{
+	long long msecs = (long long) ( time * 1000 + 0.5 );
+	char text[32];
+
+	sprintf( text, "%02lld:%02lld:%02lld:%03lld", msecs / 3600000,
+		 msecs / 60000 % 60, msecs / 1000 % 60, msecs % 1000 );
+
+	return text;
+}
+
+/*******************************************************************
+* Function Name: usage
+********************************************************************/
+static int usage( const char *prog )
+{
+	fprintf( stderr, "usage: %s [-s] file.pnt\n", prog );
+
+	return 1;
+}
+
+/** public functions **/
+
+/*******************************************************************
+* Function Name: main
+********************************************************************/
+int main( int argc, char *argv[] )
+{
+	const char *fileName = NULL;
+	bool summary = false;
+	struct stat info;
+	int fd;
+
+	for( int arg = 1; arg < argc; arg++ )
+	    if( strcmp( argv[arg], "-s" ) == 0 )
+		summary = true;
+	    else if( argv[arg][0] != '-' )
+		fileName = argv[arg];
+	    else
+		return usage( argv[0] );
+
+	if( fileName == NULL )
+	    return usage( argv[0] );
+
+	fd = open( fileName, O_RDONLY );
+	if( fd < 0 || fstat( fd, &info ) != 0 )
+	    {
+	    fprintf( stderr, "%s: cannot open %s\n", argv[0], fileName );
+	    return 1;
+	    }
+
+	if( (size_t) info.st_size < sizeof( PnTraceHeader ) )
+	    {
+	    fprintf( stderr, "%s: %s is not a trace\n", argv[0], fileName );
+	    return 1;
+	    }
+
+	const char *base = (const char *) mmap( NULL, info.st_size, PROT_READ,
+						MAP_SHARED, fd, 0 );
+	if( base == MAP_FAILED )
+	    {
+	    fprintf( stderr, "%s: cannot map %s\n", argv[0], fileName );
+	    return 1;
+	    }
+
+	const PnTraceHeader *header = (const PnTraceHeader *) base;
+
+	if( memcmp( header->magic, PN_TRACE_MAGIC, sizeof( PN_TRACE_MAGIC ) ) != 0 ||
+	    header->version != PN_TRACE_VERSION ||
+	    header->recordSize != sizeof( PnTraceRecord ) )
+	    {
+	    fprintf( stderr, "%s: %s is not a version %d trace\n", argv[0],
+		     fileName, PN_TRACE_VERSION );
+	    return 1;
+	    }
+
+	// The records end where the names start, or with the file if
+	// the trace was not closed.  A trace which was not closed holds
+	// as many records as there are complete records in the file,
+	// or as its header counts if a write failed while closing it.
+	// The header is never trusted past the end of the file.
+	uint64_t records = header->records;
+	uint64_t end = info.st_size;
+	uint64_t recordsEnd = end;
+
+	if( header->namesOffset != 0 && header->namesOffset < end )
+	    recordsEnd = header->namesOffset;
+
+	uint64_t found = recordsEnd > sizeof( PnTraceHeader ) ?
+	    ( recordsEnd - sizeof( PnTraceHeader ) ) / sizeof( PnTraceRecord ) : 0;
+
+	if( header->namesOffset == 0 )
+	    {
+	    if( records == 0 || records > found )
+		records = found;
+	    fprintf( stderr, "%s: %s was not closed, %llu records found\n",
+		     argv[0], fileName, (unsigned long long) records );
+	    }
+	else if( records > found )
+	    {
+	    fprintf( stderr, "%s: %s is truncated, %llu of its %llu records found\n",
+		     argv[0], fileName, (unsigned long long) found,
+		     (unsigned long long) records );
+	    records = found;
+	    }
+
+	NameMap names;
+	uint64_t offset = header->namesOffset;
+
+	while( offset != 0 && offset + sizeof( PnTraceName ) <= end )
+	    {
+	    const PnTraceName *entry = (const PnTraceName *) ( base + offset );
+
+	    offset += sizeof( PnTraceName );
+	    if( offset + entry->length > end )
+		break;
+
+	    names[make_pair( entry->kind, entry->id )] = string( base + offset, entry->length );
+	    offset += entry->length;
+	    }
+
+	const PnTraceRecord *record = (const PnTraceRecord *) ( base + sizeof( PnTraceHeader ) );
+	map<int, unsigned long long> firings;
+	map<int, long long> marking;
+
+	for( uint64_t r = 0; r < records; r++, record++ )
+	    {
+	    if( summary )
+		{
+		if( record->place == PN_TRACE_NONE )
+		    firings[record->trans]++;
+		else
+		    marking[record->place] += record->delta;
+		}
+	    else if( record->place == PN_TRACE_NONE )
+		printf( "%s %s fired\n", timeStr( record->time ).c_str(),
+			nameGet( names, PN_TRACE_TRANS, record->trans ).c_str() );
+	    else
+		printf( "%s %s %+lld\n", timeStr( record->time ).c_str(),
+			nameGet( names, PN_TRACE_PLACE, record->place ).c_str(),
+			(long long) record->delta );
+	    }
+
+	if( summary )
+	    {
+	    printf( "%llu records\n", (unsigned long long) records );
+
+	    printf( "\n%-20s %s\n", "Transition", "Firings" );
+	    for( map<int, unsigned long long>::iterator t = firings.begin();
+		 t != firings.end(); t++ )
+		printf( "%-20s %llu\n", nameGet( names, PN_TRACE_TRANS, t->first ).c_str(),
+			t->second );
+
+	    printf( "\n%-20s %s\n", "Place", "Tokens" );
+	    for( map<int, long long>::iterator p = marking.begin();
+		 p != marking.end(); p++ )
+		printf( "%-20s %lld\n", nameGet( names, PN_TRACE_PLACE, p->first ).c_str(),
+			p->second );
+	    }
+
+	munmap( (void *) base, info.st_size );
+	close( fd );
+
+	return 0;
+}
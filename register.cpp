@@ -20,6 +20,7 @@
 #include "trafico.h"    // class Trafico
 #include "pnPlace.h" 	// class PnPlace
 #include "pnTrans.h" 	// class PnTrans
+#include "pnNet.h" 	// class PnNet
 
 
 void MainSimulator::registerNewAtomics()
@@ -31,4 +32,5 @@ void MainSimulator::registerNewAtomics()
 	SingleModelAdm::Instance().registerAtomic( NewAtomicFunction<Trafico>() , "Trafico" ) ;
 	SingleModelAdm::Instance().registerAtomic( NewAtomicFunction<PnPlace>() , "PnPlace" ) ;
 	SingleModelAdm::Instance().registerAtomic( NewAtomicFunction<PnTrans>() , "PnTrans" ) ;
+	SingleModelAdm::Instance().registerAtomic( NewAtomicFunction<PnNet>() , "PnNet" ) ;
 }